@@ -2,14 +2,162 @@
 // Licensed under GPLv3+
 // Refer to the LICENSE file included.
 
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <thread>
 
-#include "Core/HW/FloppyDrive.h"
+#include "Core/Baseline.h"
+#include "Core/CPU/CPU.h"
+#include "Core/CPU/Exception.h"
 #include "Core/Core.h"
+#include "Core/Debug/CallStack.h"
+#include "Core/Debug/Coverage.h"
+#include "Core/Debug/Lockstep.h"
+#include "Core/Debug/OpCounters.h"
+#include "Core/Debug/Profiler.h"
+#include "Core/Debug/StateHash.h"
+#include "Core/Debug/Trace.h"
+#include "Core/HW/FloppyDrive.h"
+#include "Core/HW/Keyboard.h"
 #include "Version.h"
 
+#include "Common/JSON.h"
 #include "Common/ParameterParser.h"
 
+// Type everything arriving on stdin. The thread is left blocking in the read
+// when the emulation ends
+static void ForwardInput()
+{
+  std::thread([] {
+    char c;
+
+    while (std::cin.get(c)) {
+      // Wait for the guest to catch up
+      while (!Core::HW::Keyboard::PushChar(c))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }).detach();
+}
+
+// Boot what the parameters name. Only a floppy or COM program run
+// interactively gets stdin as keyboard input
+static int Boot(ParameterParser& p, char** argv, bool interactive)
+{
+  if (p.GetString("floppy") != "") {
+
+    if (!Core::HW::FloppyDrive::Insert(p.GetString("floppy"))) {
+      std::cerr << "Failed to mount floppy image " << argv[1] << "!"
+                << std::endl;
+      return 1;
+    }
+
+    if (!Core::HW::FloppyDrive::IsBootable()) {
+      std::cerr << argv[1] << " is not a bootable floppy image." << std::endl;
+      return 1;
+    }
+
+    if (interactive)
+      ForwardInput();
+
+    return Core::BootFloppy() ? 0 : 1;
+  } else if (p.GetString("com") != "") {
+    if (interactive)
+      ForwardInput();
+
+    return !Core::BootCOM(p.GetString("com"));
+  } else if (p.GetString("baseline") != "") {
+    return !Core::BootBaseline(p.GetString("baseline"));
+  }
+
+  std::cerr << "Nothing to do! See --help" << std::endl;
+
+  return 1;
+}
+
+static int Bench(const std::string& out)
+{
+  static const char* const workloads[] = {"Integer", "String", "Recursive",
+                                          "Text"};
+
+  Core::CPU::clock_speed = 0;
+
+  std::cout << std::left << std::setw(12) << "Workload" << std::right
+            << std::setw(14) << "Instructions" << std::setw(12) << "Time (s)"
+            << std::setw(10) << "MIPS" << std::endl;
+
+  int result = 0;
+  JSON::Value report;
+
+  for (const char* name : workloads) {
+    const std::string path =
+        std::string(APE_WORKLOADS_DIR) + "/" + name + ".com";
+
+    // Keep guest output and logging out of the measurement
+    std::cout.setstate(std::ios::failbit);
+
+    bool ok;
+    std::string error;
+    const auto start = std::chrono::steady_clock::now();
+    const std::clock_t cpu_start = std::clock();
+
+    try {
+      ok = Core::BootCOM(path);
+    } catch (Core::CPU::CPUException& e) {
+      ok = false;
+      error = e.what();
+    }
+
+    const std::chrono::duration<double> time =
+        std::chrono::steady_clock::now() - start;
+    const double cpu_time =
+        static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    std::cout.clear();
+
+    if (!ok) {
+      std::cerr << name << ": "
+                << (error.empty() ? "Failed to load " + path : error)
+                << std::endl;
+      result = 1;
+      continue;
+    }
+
+    const u64 instructions = Core::CPU::instructions;
+
+    std::cout << std::left << std::setw(12) << name << std::right
+              << std::setw(14) << instructions << std::setw(12) << std::fixed
+              << std::setprecision(3) << time.count() << std::setw(10)
+              << std::setprecision(2) << instructions / time.count() / 1e6
+              << std::endl;
+
+    // Same layout as Google Benchmark results so both can be compared alike
+    JSON::Value entry;
+    entry["name"] = std::string("Workload/") + name;
+    entry["iterations"] = 1;
+    entry["real_time"] = time.count() * 1e3;
+    entry["cpu_time"] = cpu_time * 1e3;
+    entry["time_unit"] = "ms";
+    entry["instructions"] = static_cast<double>(instructions);
+    entry["mips"] = instructions / time.count() / 1e6;
+    report["benchmarks"].Append(entry);
+  }
+
+  if (out != "") {
+    std::ofstream ofs(out);
+    ofs << JSON::Write(report) << std::endl;
+
+    if (!ofs.good()) {
+      std::cerr << "Failed to write " << out << std::endl;
+      return 1;
+    }
+  }
+
+  return result;
+}
+
 int main(int argc, char** argv)
 {
   std::cout << "Ape " << VERSION_STRING << " (c) Ape Emulator Project, 2018"
@@ -20,6 +168,27 @@ int main(int argc, char** argv)
 
   p.AddString("floppy");
   p.AddString("com");
+  p.AddString("baseline");
+  p.AddString("save-baseline");
+  p.AddString("save-baseline-at");
+  p.AddString("memory");
+  p.AddString("ems");
+  p.AddString("xms");
+  p.AddString("trace");
+  p.AddString("trace-mode");
+  p.AddCommand("profile-ops");
+  p.AddString("profile");
+  p.AddString("profile-stacks");
+  p.AddString("profile-interval");
+  p.AddString("callgrind");
+  p.AddString("coverage");
+  p.AddString("state-hash");
+  p.AddString("state-hash-every");
+  p.AddString("state-hash-range");
+  p.AddCommand("lockstep");
+  p.AddString("lockstep-engines");
+  p.AddCommand("bench");
+  p.AddString("bench-out");
   p.AddCommand("help");
 
   if (!p.Parse(argc, argv)) {
@@ -28,30 +197,204 @@ int main(int argc, char** argv)
   }
 
   if (p.CheckCommand("help")) {
-    std::cerr << argv[0] << " (--floppy/--com) [file]" << std::endl;
+    std::cerr << argv[0] << " (--floppy/--com/--baseline) [file]" << std::endl
+              << "  --memory [KiB]           Conventional memory (default "
+                 "640)"
+              << std::endl
+              << "  --ems [KiB]              Expanded memory (default none)"
+              << std::endl
+              << "  --xms [KiB]              Extended memory (default none)"
+              << std::endl
+              << "  --save-baseline [file]   Save the machine state for "
+                 "--baseline"
+              << std::endl
+              << "  --save-baseline-at [n]   Instructions to execute before "
+                 "(default: at the end)"
+              << std::endl
+              << "  --trace [file]           Record an execution trace"
+              << std::endl
+              << "  --trace-mode [mode]      full (default), registers or "
+                 "branches"
+              << std::endl
+              << "  --profile-ops            Print executed instruction counts"
+              << std::endl
+              << "  --profile [file]         Write a report of hot guest code"
+              << std::endl
+              << "  --profile-stacks [file]  Write sampled collapsed stacks"
+              << std::endl
+              << "  --profile-interval [n]   Sample interval (default 1000)"
+              << std::endl
+              << "  --callgrind [file]       Write a call graph profile"
+              << std::endl
+              << "  --coverage [file]        Write a code coverage bitmap"
+              << std::endl
+              << "  --state-hash [file]      Record machine state hashes"
+              << std::endl
+              << "  --state-hash-every [n]   Instructions between two hashes "
+                 "(default 10000)"
+              << std::endl
+              << "  --state-hash-range [a,b] Only record instructions a to b"
+              << std::endl
+              << "  --lockstep               Check the execution engines "
+                 "against each other"
+              << std::endl
+              << "  --lockstep-engines [a,b] Engines to compare (default: "
+                 "Interpreter,Interpreter)"
+              << std::endl
+              << "  --bench                  Run the bundled benchmark "
+                 "workloads"
+              << std::endl
+              << "  --bench-out [file]       Write the results as JSON"
+              << std::endl;
 
     return 1;
   }
 
-  if (p.GetString("floppy") != "") {
+  if (p.CheckCommand("profile-ops") && !Core::Debug::OpCounters::enabled) {
+    std::cerr << "Counting instructions requires building with "
+                 "ENABLE_OP_COUNTERS"
+              << std::endl;
+    return 1;
+  }
 
-    if (!Core::HW::FloppyDrive::Insert(p.GetString("floppy"))) {
-      std::cerr << "Failed to mount floppy image " << argv[1] << "!"
-                << std::endl;
+  if (p.CheckCommand("bench"))
+    return Bench(p.GetString("bench-out"));
+
+  if (p.GetString("memory") != "")
+    Core::memory_config.conventional = std::stoul(p.GetString("memory")) * 1024;
+
+  if (p.GetString("ems") != "")
+    Core::memory_config.expanded = std::stoul(p.GetString("ems")) * 1024;
+
+  if (p.GetString("xms") != "")
+    Core::memory_config.extended = std::stoul(p.GetString("xms")) * 1024;
+
+  const bool profile =
+      p.GetString("profile") != "" || p.GetString("profile-stacks") != "";
+
+  if (profile) {
+    const auto& interval = p.GetString("profile-interval");
+    Core::Debug::Profiler::Start(interval == "" ? 1000 : std::stoull(interval));
+  }
+
+  if (p.GetString("coverage") != "")
+    Core::Debug::Coverage::Start();
+
+  if (p.GetString("state-hash") != "") {
+    const auto& interval = p.GetString("state-hash-every");
+    const auto& range = p.GetString("state-hash-range");
+    const auto comma = range.find(',');
+    u64 from = 0, to = UINT64_MAX;
+
+    if (range != "" && comma == std::string::npos) {
+      std::cerr << "Bad state hash range '" << range << "'" << std::endl;
       return 1;
     }
 
-    if (!Core::HW::FloppyDrive::IsBootable()) {
-      std::cerr << argv[1] << " is not a bootable floppy image." << std::endl;
+    if (range != "") {
+      from = std::stoull(range.substr(0, comma));
+      to = std::stoull(range.substr(comma + 1));
+    }
+
+    if (!Core::Debug::StateHash::Start(
+            p.GetString("state-hash"),
+            interval == "" ? 10000 : std::stoull(interval), from, to))
+      return 1;
+  }
+
+  if (p.CheckCommand("lockstep")) {
+    std::string engines = p.GetString("lockstep-engines");
+
+    if (engines == "")
+      engines = "Interpreter,Interpreter";
+
+    const auto comma = engines.find(',');
+
+    if (comma == std::string::npos ||
+        !Core::Debug::Lockstep::Start(engines.substr(0, comma),
+                                      engines.substr(comma + 1))) {
+      std::cerr << "Unknown engines '" << engines << "'" << std::endl;
+      return 1;
+    }
+  }
+
+  if (p.GetString("trace") != "") {
+    using Mode = Core::Debug::Trace::Mode;
+
+    const auto& name = p.GetString("trace-mode");
+    Mode mode = Mode::Full;
+
+    if (name == "registers") {
+      mode = Mode::Registers;
+    } else if (name == "branches") {
+      mode = Mode::Branches;
+    } else if (name != "" && name != "full") {
+      std::cerr << "Unknown trace mode '" << name << "'" << std::endl;
       return 1;
     }
 
-    return Core::BootFloppy() ? 0 : 1;
-  } else if (p.GetString("com") != "") {
-    return !Core::BootCOM(p.GetString("com"));
+    if (!Core::Debug::Trace::Start(p.GetString("trace"), mode))
+      return 1;
   }
 
-  std::cerr << "Nothing to do! See --help" << std::endl;
+  const auto& baseline = p.GetString("save-baseline");
+  const auto& baseline_at = p.GetString("save-baseline-at");
 
-  return 1;
+  if (baseline != "" && baseline_at != "")
+    Core::Baseline::SaveAt(baseline, std::stoull(baseline_at));
+
+  // Recordings (traces, coverage, state hashes for ApeBisect) have to be
+  // reproducible, input typed at an arbitrary time isn't
+  const bool interactive = p.GetString("trace") == "" &&
+                           p.GetString("coverage") == "" &&
+                           p.GetString("state-hash") == "";
+
+  int result;
+
+  try {
+    result = Boot(p, argv, interactive);
+  } catch (Core::CPU::CPUException& e) {
+    std::cerr << "Emulation stopped: " << e.what() << std::endl;
+    result = 1;
+  }
+
+  // Make sure the trace contains everything up to the crash
+  Core::Debug::Trace::Stop();
+  Core::Debug::StateHash::Stop();
+
+  if (baseline != "" && baseline_at == "")
+    Core::Baseline::Save(baseline);
+  else if (Core::Baseline::pending)
+    std::cerr << "Stopped before the baseline was saved" << std::endl;
+
+  if (p.GetString("profile") != "")
+    Core::Debug::Profiler::WriteReport(p.GetString("profile"));
+
+  if (p.GetString("profile-stacks") != "")
+    Core::Debug::Profiler::WriteCollapsedStacks(p.GetString("profile-stacks"));
+
+  if (p.GetString("coverage") != "")
+    Core::Debug::Coverage::Write(p.GetString("coverage"));
+
+  if (p.GetString("callgrind") != "")
+    Core::Debug::CallStack::WriteCallgrind(p.GetString("callgrind"));
+
+  if (p.CheckCommand("profile-ops"))
+    Core::Debug::OpCounters::PrintReport(std::cout);
+
+  if (Core::Debug::Lockstep::active) {
+    const auto& divergence = Core::Debug::Lockstep::GetDivergence();
+
+    if (!divergence.empty()) {
+      std::cerr << divergence;
+      result = 1;
+    } else {
+      std::cerr << "Checked " << Core::Debug::Lockstep::GetBlockCount()
+                << " blocks in lockstep" << std::endl;
+    }
+
+    Core::Debug::Lockstep::Stop();
+  }
+
+  return result;
 }
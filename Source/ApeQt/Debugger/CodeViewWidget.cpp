@@ -60,22 +60,22 @@ void CodeViewWidget::Update()
   for (int i = 0; i < rows; i++) {
     u16 base = offset;
     auto ins =
-        Core::CPU::Instruction(Core::Memory::Get<u8>(segment, offset++), base);
+        Core::CPU::Instruction(Core::Memory::Read<u8>(segment, offset++), base);
 
     QString ins_str = tr("Unresolved");
 
     if (ins.IsPrefix())
       ins = Core::CPU::Instruction(
-          ins, Core::Memory::Get<u8>(segment, offset++), base);
+          ins, Core::Memory::Read<u8>(segment, offset++), base);
 
     if (!ins.IsResolved()) {
-      u8 mod = static_cast<u8>(Core::Memory::Get<u8>(segment, offset++));
+      u8 mod = static_cast<u8>(Core::Memory::Read<u8>(segment, offset++));
       u8 length = ins.GetLength(mod);
 
       std::vector<u8> ins_data;
 
       for (u16 j = 0; j < length; j++) {
-        ins_data.push_back(Core::Memory::Get<u8>(segment, offset++));
+        ins_data.push_back(Core::Memory::Read<u8>(segment, offset++));
       }
 
       ins.Resolve(mod, ins_data);
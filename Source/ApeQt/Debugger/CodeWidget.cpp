@@ -24,6 +24,8 @@
 #include "Core/CPU/Breakpoint.h"
 #include "Core/CPU/CPU.h"
 #include "Core/CPU/Instruction.h"
+#include "Core/Debug/CallStack.h"
+#include "Core/Debug/Checkpoint.h"
 #include "Core/Memory.h"
 
 CodeWidget::CodeWidget()
@@ -31,10 +33,18 @@ CodeWidget::CodeWidget()
   setWindowTitle(tr("Code"));
   CreateWidgets();
 
+  // Step Back and Reverse Continue need the history
+  Core::Debug::Checkpoint::active = true;
+
   setVisible(QSettings().value("debug/showcode", true).toBool());
 
-  Core::CPU::RegisterStateChangedCallback(
-      [this](Core::CPU::State) { QueueOnObject(this, [this] { Update(); }); });
+  Core::CPU::RegisterStateChangedCallback([this](Core::CPU::State state) {
+    QueueOnObject(this, [this, state] {
+      m_step_back->setEnabled(state != Core::CPU::State::Running);
+      m_reverse_continue->setEnabled(state != Core::CPU::State::Running);
+      Update();
+    });
+  });
 
   Update();
 }
@@ -62,6 +72,21 @@ void CodeWidget::CreateWidgets()
   jump_layout->addWidget(scroll_btn);
   jump_layout->addStretch();
 
+  auto* reverse_layout = new QHBoxLayout;
+
+  m_step_back = new QPushButton(tr("Step Back"));
+  m_reverse_continue = new QPushButton(tr("Reverse Continue"));
+
+  connect(m_step_back, &QPushButton::pressed, this,
+          [] { Core::Debug::Checkpoint::StepBack(); });
+  connect(m_reverse_continue, &QPushButton::pressed, this,
+          [] { Core::Debug::Checkpoint::ReverseContinue(); });
+
+  reverse_layout->addStretch();
+  reverse_layout->addWidget(m_step_back);
+  reverse_layout->addWidget(m_reverse_continue);
+  reverse_layout->addStretch();
+
   auto* stack_box = new QGroupBox(tr("Stack"));
   auto* stack_layout = new QVBoxLayout;
 
@@ -71,6 +96,22 @@ void CodeWidget::CreateWidgets()
 
   stack_layout->addWidget(m_stack_list);
 
+  auto* call_stack_box = new QGroupBox(tr("Call Stack"));
+  auto* call_stack_layout = new QVBoxLayout;
+
+  call_stack_box->setLayout(call_stack_layout);
+
+  m_call_stack_list = new QListWidget;
+
+  call_stack_layout->addWidget(m_call_stack_list);
+
+  connect(m_call_stack_list, &QListWidget::itemActivated, this,
+          [this](QListWidgetItem* item) {
+            m_code_view->SetSegment(item->data(Qt::UserRole).toUInt());
+            m_code_view->SetOffset(item->data(Qt::UserRole + 1).toUInt());
+            Update();
+          });
+
   auto* splitter = new QSplitter(Qt::Vertical);
   auto* widget = new QWidget;
   auto* layout = new QVBoxLayout;
@@ -79,8 +120,10 @@ void CodeWidget::CreateWidgets()
 
   splitter->addWidget(m_code_view);
   splitter->addWidget(stack_box);
+  splitter->addWidget(call_stack_box);
 
   layout->addLayout(jump_layout);
+  layout->addLayout(reverse_layout);
   layout->addWidget(splitter);
 
   setWidget(widget);
@@ -98,17 +141,35 @@ void CodeWidget::Update()
   m_offset_spin->setValue(m_code_view->GetOffset());
 
   m_stack_list->clear();
+  m_call_stack_list->clear();
 
   m_code_view->Update();
 
   for (u32 i = 0; i < 16; i++) {
     m_stack_list->addItem(new QListWidgetItem(
         QStringLiteral("%1:%2 %3")
-            .arg(Core::CPU::SS, 4, 16, QLatin1Char('0'))
+            .arg(static_cast<u16>(Core::CPU::SS), 4, 16, QLatin1Char('0'))
             .arg(Core::CPU::SP + i * sizeof(u16), 4, 16, QLatin1Char('0'))
-            .arg(Core::Memory::Get<u16>(
+            .arg(Core::Memory::Read<u16>(
                      Core::CPU::SS,
                      static_cast<u16>(Core::CPU::SP + i * sizeof(u16))),
                  4, 16, QLatin1Char('0'))));
   }
+
+  // Innermost frame first, activating a frame shows where it returns to
+  const auto& frames = Core::Debug::CallStack::GetFrames();
+
+  for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+    auto* item = new QListWidgetItem(
+        QStringLiteral("%1:%2 (from %3:%4)")
+            .arg(it->segment, 4, 16, QLatin1Char('0'))
+            .arg(it->offset, 4, 16, QLatin1Char('0'))
+            .arg(it->return_segment, 4, 16, QLatin1Char('0'))
+            .arg(it->return_offset, 4, 16, QLatin1Char('0')));
+
+    item->setData(Qt::UserRole, it->return_segment);
+    item->setData(Qt::UserRole + 1, it->return_offset);
+
+    m_call_stack_list->addItem(item);
+  }
 }
@@ -10,6 +10,7 @@
 
 class CodeViewWidget;
 class QListWidget;
+class QPushButton;
 class QResizeEvent;
 class QSpinBox;
 
@@ -26,8 +27,11 @@ signals:
 
 private:
   QListWidget* m_stack_list;
+  QListWidget* m_call_stack_list;
   QSpinBox* m_segment_spin;
   QSpinBox* m_offset_spin;
+  QPushButton* m_step_back;
+  QPushButton* m_reverse_continue;
 
   CodeViewWidget* m_code_view;
 
@@ -0,0 +1,105 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "ApeQt/Debugger/OpCountersWidget.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSettings>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <QWidget>
+
+#include "ApeQt/QueueOnObject.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/Debug/OpCounters.h"
+
+OpCountersWidget::OpCountersWidget()
+{
+  setWindowTitle(tr("Op Counters"));
+  CreateWidgets();
+
+  setVisible(QSettings().value("debug/showopcounters", false).toBool());
+
+  // Counters only get published while paused or stopped
+  Core::CPU::RegisterStateChangedCallback([this](Core::CPU::State state) {
+    if (state != Core::CPU::State::Running)
+      QueueOnObject(this, [this] { Update(); });
+  });
+}
+
+void OpCountersWidget::closeEvent(QCloseEvent*)
+{
+  QSettings().setValue("debug/showopcounters", false);
+  emit Closed();
+}
+
+void OpCountersWidget::CreateWidgets()
+{
+  auto* layout = new QVBoxLayout;
+
+  if (!Core::Debug::OpCounters::enabled) {
+    layout->addWidget(
+        new QLabel(tr("Ape was built without ENABLE_OP_COUNTERS.")));
+    layout->addStretch();
+  }
+
+  m_table = new QTableWidget(0, 3);
+  m_table->setHorizontalHeaderLabels({tr("Group"), tr("Name"), tr("Count")});
+  m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+  m_table->verticalHeader()->hide();
+  m_table->horizontalHeader()->setStretchLastSection(true);
+  m_table->setVisible(Core::Debug::OpCounters::enabled);
+
+  auto* button_layout = new QHBoxLayout;
+  auto* refresh = new QPushButton(tr("Refresh"));
+  auto* clear = new QPushButton(tr("Clear"));
+
+  refresh->setEnabled(Core::Debug::OpCounters::enabled);
+  clear->setEnabled(Core::Debug::OpCounters::enabled);
+
+  connect(refresh, &QPushButton::pressed, this, [this] { Update(); });
+  connect(clear, &QPushButton::pressed, this, [this] {
+    Core::Debug::OpCounters::Clear();
+    Update();
+  });
+
+  button_layout->addStretch();
+  button_layout->addWidget(refresh);
+  button_layout->addWidget(clear);
+
+  layout->addWidget(m_table);
+  layout->addLayout(button_layout);
+
+  auto* widget = new QWidget;
+
+  widget->setLayout(layout);
+
+  setWidget(widget);
+}
+
+void OpCountersWidget::Update()
+{
+  const auto& report = Core::Debug::OpCounters::GetReport();
+
+  m_table->setRowCount(static_cast<int>(report.size()));
+
+  for (int i = 0; i < static_cast<int>(report.size()); i++) {
+    const auto& entry = report[i];
+    auto* count = new QTableWidgetItem;
+
+    count->setData(Qt::DisplayRole, static_cast<qulonglong>(entry.count));
+    count->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+    m_table->setItem(
+        i, 0, new QTableWidgetItem(QString::fromStdString(entry.group)));
+    m_table->setItem(
+        i, 1, new QTableWidgetItem(QString::fromStdString(entry.name)));
+    m_table->setItem(i, 2, count);
+  }
+}
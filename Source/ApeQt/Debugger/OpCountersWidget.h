@@ -0,0 +1,27 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+
+#include <QDockWidget>
+
+class QTableWidget;
+
+class OpCountersWidget : public QDockWidget
+{
+  Q_OBJECT
+public:
+  explicit OpCountersWidget();
+
+  void closeEvent(QCloseEvent*) override;
+
+signals:
+  void Closed();
+
+private:
+  QTableWidget* m_table;
+
+  void CreateWidgets();
+  void Update();
+};
@@ -53,6 +53,22 @@ QSpinBox* RegisterWidget::Get16BitInput(u16* value)
   return spin;
 }
 
+QSpinBox* RegisterWidget::GetSegmentInput(Core::CPU::Segment* segment)
+{
+  auto* spin = new DebugSpinBox(sizeof(u16));
+  spin->setValue(*segment);
+
+  connect(this, &RegisterWidget::OnUpdate, this, [spin, segment] {
+    QSignalBlocker blocker(spin);
+    spin->setValue(*segment);
+  });
+  // Assigning keeps the base of the segment up to date
+  connect(spin, QOverload<int>::of(&QSpinBox::valueChanged), this,
+          [spin, segment] { *segment = spin->value(); });
+
+  return spin;
+}
+
 QSpinBox* RegisterWidget::Get8BitInput(u8* value)
 {
   auto* spin = new DebugSpinBox(sizeof(u8));
@@ -147,22 +163,22 @@ void RegisterWidget::CreateWidgets()
   si_box->setLayout(si_layout);
 
   si_layout->addWidget(new QLabel("CS"), 0, 0);
-  si_layout->addWidget(Get16BitInput(&Core::CPU::CS), 0, 1);
+  si_layout->addWidget(GetSegmentInput(&Core::CPU::CS), 0, 1);
   si_layout->addWidget(new QLabel("IP"), 0, 2);
   si_layout->addWidget(Get16BitInput(&Core::CPU::IP), 0, 3);
 
   si_layout->addWidget(new QLabel("SS"), 1, 0);
-  si_layout->addWidget(Get16BitInput(&Core::CPU::SS), 1, 1);
+  si_layout->addWidget(GetSegmentInput(&Core::CPU::SS), 1, 1);
   si_layout->addWidget(new QLabel("SP"), 1, 2);
   si_layout->addWidget(Get16BitInput(&Core::CPU::SP), 1, 3);
 
   si_layout->addWidget(new QLabel("DS"), 2, 0);
-  si_layout->addWidget(Get16BitInput(&Core::CPU::DS), 2, 1);
+  si_layout->addWidget(GetSegmentInput(&Core::CPU::DS), 2, 1);
   si_layout->addWidget(new QLabel("SI"), 2, 2);
   si_layout->addWidget(Get16BitInput(&Core::CPU::SI), 2, 3);
 
   si_layout->addWidget(new QLabel("ES"), 3, 0);
-  si_layout->addWidget(Get16BitInput(&Core::CPU::ES), 3, 1);
+  si_layout->addWidget(GetSegmentInput(&Core::CPU::ES), 3, 1);
   si_layout->addWidget(new QLabel("DI"), 3, 2);
   si_layout->addWidget(Get16BitInput(&Core::CPU::DI), 3, 3);
 
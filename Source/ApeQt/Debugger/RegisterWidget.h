@@ -12,6 +12,11 @@
 class QCheckBox;
 class QSpinBox;
 
+namespace Core::CPU
+{
+class Segment;
+}
+
 class RegisterWidget : public QDockWidget
 {
   Q_OBJECT
@@ -29,6 +34,7 @@ private:
   void CreateWidgets();
 
   QSpinBox* Get16BitInput(u16* value);
+  QSpinBox* GetSegmentInput(Core::CPU::Segment* segment);
   QSpinBox* Get8BitInput(u8* value);
   QCheckBox* GetFlagInput(QString label, bool* value);
 };
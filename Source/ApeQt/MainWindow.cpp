@@ -17,6 +17,7 @@
 #include <QStatusBar>
 
 #include "ApeQt/Debugger/CodeWidget.h"
+#include "ApeQt/Debugger/OpCountersWidget.h"
 #include "ApeQt/Debugger/RegisterWidget.h"
 #include "ApeQt/QueueOnObject.h"
 #include "ApeQt/TTYWidget.h"
@@ -119,6 +120,7 @@ void MainWindow::CreateWidgets()
 
   m_show_code = debug_menu->addAction(tr("Show Code"));
   m_show_register = debug_menu->addAction(tr("Show Registers"));
+  m_show_op_counters = debug_menu->addAction(tr("Show Op Counters"));
 
   m_show_code->setCheckable(true);
   m_show_code->setChecked(QSettings().value("debug/showcode", true).toBool());
@@ -137,6 +139,15 @@ void MainWindow::CreateWidgets()
     QSettings().setValue("debug/showregister", checked);
   });
 
+  m_show_op_counters->setCheckable(true);
+  m_show_op_counters->setChecked(
+      QSettings().value("debug/showopcounters", false).toBool());
+
+  connect(m_show_op_counters, &QAction::toggled, this, [this](bool checked) {
+    m_op_counters_widget->setVisible(checked);
+    QSettings().setValue("debug/showopcounters", checked);
+  });
+
   auto* help_menu = m_menu_bar->addMenu(tr("Help"));
 
   help_menu->addAction(tr("About..."), this, &MainWindow::ShowAbout);
@@ -161,9 +172,11 @@ void MainWindow::CreateWidgets()
 
   m_code_widget = new CodeWidget;
   m_register_widget = new RegisterWidget;
+  m_op_counters_widget = new OpCountersWidget;
 
   addDockWidget(Qt::LeftDockWidgetArea, m_code_widget);
   addDockWidget(Qt::LeftDockWidgetArea, m_register_widget);
+  addDockWidget(Qt::LeftDockWidgetArea, m_op_counters_widget);
 
   connect(m_code_widget, &CodeWidget::Closed, this,
           [this] { m_show_code->setChecked(false); });
@@ -171,7 +184,11 @@ void MainWindow::CreateWidgets()
   connect(m_register_widget, &RegisterWidget::Closed, this,
           [this] { m_show_register->setChecked(false); });
 
+  connect(m_op_counters_widget, &OpCountersWidget::Closed, this,
+          [this] { m_show_op_counters->setChecked(false); });
+
   tabifyDockWidget(m_code_widget, m_register_widget);
+  tabifyDockWidget(m_register_widget, m_op_counters_widget);
 }
 
 void MainWindow::ConnectWidgets() {}
@@ -14,6 +14,7 @@
 #include "Core/Core.h"
 
 class CodeWidget;
+class OpCountersWidget;
 class RegisterWidget;
 class QAction;
 class QLabel;
@@ -50,12 +51,14 @@ private:
   QAction* m_machine_pause;
   QAction* m_show_code;
   QAction* m_show_register;
+  QAction* m_show_op_counters;
 
   QStatusBar* m_status_bar;
   QLabel* m_status_label;
 
   CodeWidget* m_code_widget;
   RegisterWidget* m_register_widget;
+  OpCountersWidget* m_op_counters_widget;
 
   std::thread m_thread;
 };
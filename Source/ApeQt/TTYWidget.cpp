@@ -10,14 +10,75 @@
 #include <QFont>
 #include <QKeyEvent>
 #include <QString>
+#include <QStringList>
 #include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
 #include <QVector>
 
 #include "Common/Logger.h"
 #include "Common/String.h"
 
+#include "Core/HW/Keyboard.h"
 #include "Core/TTY.h"
 
+// Scan code of the key of an event, 0 if the guest has no such key
+static u8 GetScanCode(const QKeyEvent& event)
+{
+  switch (event.key()) {
+  case Qt::Key_Escape:
+    return 0x01;
+  case Qt::Key_Backspace:
+    return 0x0E;
+  case Qt::Key_Tab:
+  case Qt::Key_Backtab:
+    return 0x0F;
+  case Qt::Key_Return:
+  case Qt::Key_Enter:
+    return 0x1C;
+  case Qt::Key_Control:
+    return 0x1D;
+  case Qt::Key_Shift:
+    return 0x2A;
+  case Qt::Key_Alt:
+    return 0x38;
+  case Qt::Key_Home:
+    return 0x47;
+  case Qt::Key_Up:
+    return 0x48;
+  case Qt::Key_PageUp:
+    return 0x49;
+  case Qt::Key_Left:
+    return 0x4B;
+  case Qt::Key_Right:
+    return 0x4D;
+  case Qt::Key_End:
+    return 0x4F;
+  case Qt::Key_Down:
+    return 0x50;
+  case Qt::Key_PageDown:
+    return 0x51;
+  case Qt::Key_Insert:
+    return 0x52;
+  case Qt::Key_Delete:
+    return 0x53;
+  default:
+    break;
+  }
+
+  const int key = event.key();
+
+  if (key >= Qt::Key_F1 && key <= Qt::Key_F10)
+    return static_cast<u8>(0x3B + key - Qt::Key_F1);
+
+  // Printable keys are named after the (upper case) character they type
+  if (key > 0 && key < 0x80)
+    return Core::HW::Keyboard::GetScanCode(
+        static_cast<char>(std::tolower(key)));
+
+  return 0;
+}
+
 TTYWidget::TTYWidget()
 {
   g_VGABackend = this;
@@ -25,6 +86,14 @@ TTYWidget::TTYWidget()
   QFont font("Monospace");
   font.setStyleHint(QFont::TypeWriter);
   setFont(font);
+
+  // One block per row, updates replace the characters that changed
+  QStringList rows;
+
+  for (int y = 0; y < Core::HW::VGA::ROWS; y++)
+    rows.append(QString(Core::HW::VGA::COLUMNS, ' '));
+
+  setPlainText(rows.join('\n'));
 }
 TTYWidget::~TTYWidget() { g_VGABackend = nullptr; }
 
@@ -34,31 +103,70 @@ void TTYWidget::SetMode(u8 mode)
       ". TTYWidget only supports text mode!");
 }
 
-void TTYWidget::Update()
+void TTYWidget::Update(const std::vector<Core::HW::VGA::Change>& changes)
 {
-  static const QVector<QString> color_str = {
-      "black",      "blue",         "green",      "cyan",
-      "red",        "magenta",      "brown",      "lightgray",
-      "lightblack", "lightblue",    "lightgreen", "lightcyan",
-      "lightred",   "lightmagenta", "yellow",     "white"};
+  struct Text {
+    int row;
+    int column;
+    QString text;
+  };
 
-  u8* buffer = Core::HW::VGA::GetBuffer();
+  const u8* buffer = Core::HW::VGA::GetBuffer();
 
-  constexpr int COLUMNS = 80;
-  constexpr int ROWS = 25;
+  // Copy the cells now, the guest keeps changing them
+  QVector<Text> texts;
 
-  QString s(ROWS * (COLUMNS + 1));
+  for (const auto& change : changes) {
+    QString s(change.last - change.first + 1, ' ');
 
-  for (int y = 0; y < ROWS; y++) {
-    for (int x = 0; x < COLUMNS; x++) {
-      char c = buffer[(y * COLUMNS + x) * sizeof(u16)];
-      s[y * (COLUMNS + 1) + x] = std::isprint(c) ? c : ' ';
+    for (int x = change.first; x <= change.last; x++) {
+      char c = buffer[(change.row * Core::HW::VGA::COLUMNS + x) * sizeof(u16)];
+      s[x - change.first] = std::isprint(c) ? c : ' ';
     }
-    s[(y + 1) * (COLUMNS + 1) - 1] = '\n';
+
+    texts.append({change.row, change.first, s});
   }
 
-  QueueOnObject(this, [this, s] {
-    clear();
-    append(s);
+  QueueOnObject(this, [this, texts] {
+    QTextCursor cursor(document());
+
+    for (const Text& text : texts) {
+      const int start =
+          document()->findBlockByNumber(text.row).position() + text.column;
+
+      cursor.setPosition(start);
+      cursor.setPosition(start + text.text.size(), QTextCursor::KeepAnchor);
+      cursor.insertText(text.text);
+    }
   });
 }
+
+void TTYWidget::keyPressEvent(QKeyEvent* event)
+{
+  const u8 code = GetScanCode(*event);
+
+  if (code == 0) {
+    QTextBrowser::keyPressEvent(event);
+    return;
+  }
+
+  // Holding a key repeats its press, like the typematic of a real keyboard
+  if (!Core::HW::Keyboard::Push(code))
+    LOG("Keyboard queue full, dropping a key press");
+}
+
+void TTYWidget::keyReleaseEvent(QKeyEvent* event)
+{
+  const u8 code = GetScanCode(*event);
+
+  if (code == 0) {
+    QTextBrowser::keyReleaseEvent(event);
+    return;
+  }
+
+  if (event->isAutoRepeat())
+    return;
+
+  if (!Core::HW::Keyboard::Push(code | 0x80))
+    LOG("Keyboard queue full, dropping a key release");
+}
@@ -15,5 +15,9 @@ public:
   ~TTYWidget();
 
   void SetMode(u8 mode) override;
-  void Update() override;
+  void Update(const std::vector<Core::HW::VGA::Change>& changes) override;
+
+protected:
+  void keyPressEvent(QKeyEvent* event) override;
+  void keyReleaseEvent(QKeyEvent* event) override;
 };
@@ -0,0 +1,20 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include <benchmark/benchmark.h>
+
+#include "Common/String.h"
+#include "Common/Types.h"
+
+template <typename T> static void BM_ToHex(benchmark::State& state)
+{
+  T value = 0;
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(String::ToHex<T>(value++));
+}
+
+BENCHMARK_TEMPLATE(BM_ToHex, u8);
+BENCHMARK_TEMPLATE(BM_ToHex, u16);
+BENCHMARK_TEMPLATE(BM_ToHex, u32);
@@ -0,0 +1,168 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+#include <benchmark/benchmark.h>
+
+#include "Common/Types.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/CPU/Flags.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+
+using PType = CPU::Instruction::Parameter::Type;
+using Prefix = CPU::Instruction::SegmentPrefix;
+
+// Put code at 0000:0100 and point CS:IP at it
+static void Load(std::initializer_list<u8> code)
+{
+  u16 offset = 0x100;
+
+  for (u8 byte : code)
+    Memory::Get<u8>(0x0000, offset++) = byte;
+
+  CPU::CS = 0x0000;
+  CPU::IP = 0x100;
+}
+
+template <typename T>
+static void BM_ParameterTo(benchmark::State& state, PType type)
+{
+  CPU::Instruction::Parameter parameter(type);
+  parameter.Resolve(0x12);
+
+  CPU::BX = 0x1000;
+  CPU::BP = 0x2000;
+  CPU::SI = 0x0010;
+  CPU::DI = 0x0020;
+  CPU::DS = 0x1000;
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(CPU::ParameterTo<T>(parameter, Prefix::None));
+}
+
+// Each case is named after its parameter type, the values of the enum change
+// whenever a type gets added
+template <typename T>
+static bool RegisterParameterTo(
+    const std::string& name,
+    std::initializer_list<std::pair<const char*, PType>> types)
+{
+  for (const auto& [label, type] : types)
+    benchmark::RegisterBenchmark((name + "/" + label).c_str(),
+                                 BM_ParameterTo<T>, type);
+
+  return true;
+}
+
+static const bool s_parameter_to_u8 = RegisterParameterTo<u8>(
+    "BM_ParameterTo<u8>",
+    {{"AL", PType::AL},
+     {"Literal_Byte", PType::Literal_Byte},
+     {"Value_WordAddress", PType::Value_WordAddress},
+     {"Value_BX", PType::Value_BX},
+     {"Value_BX_SI", PType::Value_BX_SI},
+     {"Value_BX_SI_Offset", PType::Value_BX_SI_Offset},
+     {"Value_BP_DI_WordOffset", PType::Value_BP_DI_WordOffset}});
+
+static const bool s_parameter_to_u16 = RegisterParameterTo<u16>(
+    "BM_ParameterTo<u16>",
+    {{"AX", PType::AX},
+     {"DS", PType::DS},
+     {"Literal_Word", PType::Literal_Word},
+     {"Value_WordAddress_Word", PType::Value_WordAddress_Word},
+     {"Value_BX_Word", PType::Value_BX_Word},
+     {"Value_BX_SI_Word", PType::Value_BX_SI_Word},
+     {"Value_BX_SI_Offset_Word", PType::Value_BX_SI_Offset_Word},
+     {"Value_BP_DI_WordOffset_Word", PType::Value_BP_DI_WordOffset_Word}});
+
+static void BM_RepStosb(benchmark::State& state)
+{
+  // REP STOSB
+  Load({0xF3, 0xAA});
+
+  CPU::ES = 0x1000;
+  CPU::DF = false;
+
+  for (auto _ : state) {
+    CPU::IP = 0x100;
+    CPU::CX = static_cast<u16>(state.range(0));
+    CPU::DI = 0;
+    // This emulator treats REP as REPZ, which checks ZF on STOS too
+    CPU::ZF = true;
+
+    // The prefix is executed as an instruction of its own
+    CPU::Step();
+    CPU::Step();
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_RepMovsw(benchmark::State& state)
+{
+  // REP MOVSW
+  Load({0xF3, 0xA5});
+
+  CPU::DS = 0x1000;
+  CPU::ES = 0x2000;
+  CPU::DF = false;
+
+  for (auto _ : state) {
+    CPU::IP = 0x100;
+    CPU::CX = static_cast<u16>(state.range(0));
+    CPU::SI = 0;
+    CPU::DI = 0;
+    CPU::ZF = true;
+
+    CPU::Step();
+    CPU::Step();
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(u16));
+}
+
+BENCHMARK(BM_RepStosb)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK(BM_RepMovsw)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_UpdateFlags(benchmark::State& state)
+{
+  i32 value = 0;
+
+  for (auto _ : state) {
+    CPU::UpdateZF(static_cast<u16>(value));
+    CPU::UpdatePF(static_cast<u16>(value));
+    CPU::UpdateSF(static_cast<i16>(value));
+    CPU::UpdateOF<i16>(value);
+    CPU::UpdateCF<i16>(value);
+    value += 0x1111;
+  }
+
+  benchmark::DoNotOptimize(CPU::GetFlags());
+}
+
+BENCHMARK(BM_UpdateFlags);
+
+static void BM_TickLoop(benchmark::State& state)
+{
+  Load({
+      0xB9, 0xFF, 0xFF, // MOV CX, 0xFFFF
+      0x40,             // INC AX
+      0x01, 0xC3,       // ADD BX, AX
+      0xE2, 0xFB,       // LOOP -5
+      0xEB, 0xF6,       // JMP -10
+  });
+
+  for (auto _ : state)
+    CPU::Tick();
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_TickLoop);
@@ -0,0 +1,79 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Common/Types.h"
+
+#include "Core/CPU/Instruction.h"
+
+using namespace Core::CPU;
+
+// A typical function prologue, body and epilogue as compiled for DOS
+static const u8 CODE[] = {
+    0x55, 0x89, 0xe5, 0x83, 0xec, 0x08, 0x8b, 0x46, 0x04, 0x8b, 0x5e, 0x06,
+    0x89, 0x46, 0xfe, 0x31, 0xc9, 0xb1, 0x10, 0x8a, 0x10, 0x8b, 0x51, 0x12,
+    0x01, 0xd0, 0x83, 0xd3, 0x00, 0x3c, 0x20, 0x74, 0x02, 0x46, 0x4f, 0x24,
+    0x0f, 0x08, 0xd8, 0xd1, 0xe0, 0xd1, 0xea, 0xac, 0xaa, 0xf3, 0xa5, 0xb8,
+    0x00, 0x4c, 0xcd, 0x21, 0xe8, 0x12, 0x00, 0x50, 0x5b, 0xc4, 0x7e, 0x08,
+    0x8d, 0xb7, 0x00, 0x01, 0x92, 0x98, 0x26, 0x8a, 0x05, 0x84, 0xc0, 0xe2,
+    0xda, 0x89, 0xec, 0x5d, 0xc3};
+
+// Decode the same way CPU::Step() does
+static size_t Decode(size_t offset, Instruction& ins)
+{
+  ins = Instruction(CODE[offset++]);
+
+  if (ins.IsPrefix())
+    ins = Instruction(ins, CODE[offset++]);
+
+  if (!ins.IsResolved()) {
+    u8 mod = CODE[offset++];
+    u8 length = ins.GetLength(mod);
+
+    std::vector<u8> data(CODE + offset, CODE + offset + length);
+    offset += length;
+
+    ins.Resolve(mod, data);
+  }
+
+  return offset;
+}
+
+static void BM_Decode(benchmark::State& state)
+{
+  size_t offset = 0;
+  Instruction ins;
+
+  for (auto _ : state) {
+    offset = Decode(offset, ins);
+    benchmark::DoNotOptimize(ins);
+
+    if (offset == sizeof(CODE))
+      offset = 0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_DecodeToString(benchmark::State& state)
+{
+  size_t offset = 0;
+  Instruction ins;
+
+  for (auto _ : state) {
+    offset = Decode(offset, ins);
+    benchmark::DoNotOptimize(ins.ToString());
+
+    if (offset == sizeof(CODE))
+      offset = 0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Decode);
+BENCHMARK(BM_DecodeToString);
@@ -0,0 +1,40 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include <benchmark/benchmark.h>
+
+#include "Common/Types.h"
+
+#include "Core/Memory.h"
+
+using namespace Core;
+
+template <typename T> static void BM_MemoryRead(benchmark::State& state)
+{
+  u16 offset = 0;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Memory::Get<T>(0x1000, offset));
+    offset += sizeof(T);
+  }
+
+  state.SetBytesProcessed(state.iterations() * sizeof(T));
+}
+
+template <typename T> static void BM_MemoryWrite(benchmark::State& state)
+{
+  u16 offset = 0;
+
+  for (auto _ : state) {
+    Memory::Get<T>(0x1000, offset) = static_cast<T>(offset);
+    offset += sizeof(T);
+  }
+
+  state.SetBytesProcessed(state.iterations() * sizeof(T));
+}
+
+BENCHMARK_TEMPLATE(BM_MemoryRead, u8);
+BENCHMARK_TEMPLATE(BM_MemoryRead, u16);
+BENCHMARK_TEMPLATE(BM_MemoryWrite, u8);
+BENCHMARK_TEMPLATE(BM_MemoryWrite, u16);
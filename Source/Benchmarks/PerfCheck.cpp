@@ -0,0 +1,267 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "Common/JSON.h"
+#include "Common/ParameterParser.h"
+#include "Version.h"
+
+// Used for benchmarks without a tolerance of their own
+constexpr double DEFAULT_TOLERANCE = 0.15;
+
+// CPU time of every benchmark in nanoseconds
+using Results = std::map<std::string, double>;
+
+static double ToNanoseconds(double time, const std::string& unit)
+{
+  if (unit == "us")
+    return time * 1e3;
+  if (unit == "ms")
+    return time * 1e6;
+  if (unit == "s")
+    return time * 1e9;
+
+  return time;
+}
+
+static std::string FormatTime(double ns)
+{
+  static const char* const units[] = {"ns", "us", "ms", "s"};
+  size_t unit = 0;
+
+  while (ns >= 1000 && unit < 3) {
+    ns /= 1000;
+    unit++;
+  }
+
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(2) << ns << " " << units[unit];
+  return ss.str();
+}
+
+// Read Google Benchmark JSON output. Repeated runs are reduced to the fastest
+// one as noise only ever adds time
+static bool Load(const std::string& path, Results& results)
+{
+  JSON::Value json;
+  std::string error;
+
+  if (!JSON::ParseFile(path, json, &error)) {
+    std::cerr << path << ": " << error << std::endl;
+    return false;
+  }
+
+  for (const auto& entry : json["benchmarks"].AsArray()) {
+    if (entry["run_type"].AsString() == "aggregate" ||
+        !entry["cpu_time"].IsNumber())
+      continue;
+
+    const double time = ToNanoseconds(entry["cpu_time"].AsNumber(),
+                                      entry["time_unit"].AsString());
+    const auto& name = entry.Has("run_name") ? entry["run_name"].AsString()
+                                             : entry["name"].AsString();
+
+    if (!results.count(name) || time < results[name])
+      results[name] = time;
+  }
+
+  return true;
+}
+
+static int Update(const std::string& path, const JSON::Value& baseline,
+                  const Results& results)
+{
+  JSON::Value updated;
+
+  updated["tolerance"] = baseline["tolerance"].IsNumber()
+                             ? baseline["tolerance"].AsNumber()
+                             : DEFAULT_TOLERANCE;
+  updated["benchmarks"] = JSON::Value::Object();
+
+  for (const auto& [name, time] : results) {
+    JSON::Value entry;
+    entry["cpu_time"] = std::round(time * 100) / 100;
+
+    // Keep tolerances which were tuned by hand
+    const auto& old = baseline["benchmarks"][name];
+    if (old["tolerance"].IsNumber())
+      entry["tolerance"] = old["tolerance"].AsNumber();
+
+    updated["benchmarks"][name] = entry;
+  }
+
+  std::ofstream ofs(path);
+  ofs << JSON::Write(updated) << std::endl;
+
+  if (!ofs.good()) {
+    std::cerr << "Failed to write " << path << std::endl;
+    return 1;
+  }
+
+  std::cerr << "Wrote " << results.size() << " benchmarks to " << path
+            << std::endl;
+  return 0;
+}
+
+static int Compare(const JSON::Value& baseline, const Results& results)
+{
+  const double default_tolerance = baseline["tolerance"].IsNumber()
+                                       ? baseline["tolerance"].AsNumber()
+                                       : DEFAULT_TOLERANCE;
+  const auto& expected = baseline["benchmarks"].AsObject();
+
+  size_t width = 10;
+  for (const auto& [name, time] : results)
+    width = std::max(width, name.size() + 2);
+  for (const auto& [name, entry] : expected)
+    width = std::max(width, name.size() + 2);
+
+  std::cout << std::left << std::setw(width) << "Benchmark" << std::right
+            << std::setw(12) << "Baseline" << std::setw(12) << "Current"
+            << std::setw(10) << "Change" << std::setw(8) << "Limit"
+            << "  Status" << std::endl;
+
+  size_t regressions = 0;
+  size_t missing = 0;
+  size_t added = 0;
+
+  auto Row = [&](const std::string& name, const std::string& base,
+                 const std::string& current, const std::string& change,
+                 const std::string& limit, const std::string& status) {
+    std::cout << std::left << std::setw(width) << name << std::right
+              << std::setw(12) << base << std::setw(12) << current
+              << std::setw(10) << change << std::setw(8) << limit << "  "
+              << status << std::endl;
+  };
+
+  for (const auto& [name, time] : results) {
+    // Nothing to compare against, but not a failure: Say so to get it into
+    // the baseline
+    if (!expected.count(name)) {
+      Row(name, "-", FormatTime(time), "", "", "new");
+      added++;
+      continue;
+    }
+
+    const auto& entry = expected.at(name);
+    const double base = entry["cpu_time"].AsNumber();
+    const double tolerance = entry["tolerance"].IsNumber()
+                                 ? entry["tolerance"].AsNumber()
+                                 : default_tolerance;
+    const double change = base > 0 ? time / base - 1 : 0;
+
+    std::string status = "ok";
+
+    if (change > tolerance) {
+      status = "SLOWER";
+      regressions++;
+    } else if (change < -tolerance) {
+      status = "faster";
+    }
+
+    std::ostringstream change_text, limit_text;
+    change_text << std::showpos << std::fixed << std::setprecision(1)
+                << change * 100 << "%";
+    limit_text << std::fixed << std::setprecision(0) << tolerance * 100 << "%";
+
+    Row(name, FormatTime(base), FormatTime(time), change_text.str(),
+        limit_text.str(), status);
+  }
+
+  // A benchmark that got renamed, removed or broken would otherwise pass
+  // unnoticed
+  for (const auto& [name, entry] : expected) {
+    if (!results.count(name)) {
+      Row(name, FormatTime(entry["cpu_time"].AsNumber()), "-", "", "",
+          "MISSING");
+      missing++;
+    }
+  }
+
+  std::cout << std::endl;
+
+  if (added != 0)
+    std::cerr << "Warning: " << added << " benchmarks are not in the "
+              << "baseline yet, add them with --update" << std::endl;
+
+  if (regressions != 0)
+    std::cout << regressions << " of " << results.size()
+              << " benchmarks got slower than allowed" << std::endl;
+
+  if (missing != 0)
+    std::cout << missing << " of " << expected.size()
+              << " benchmarks of the baseline have no result" << std::endl;
+
+  if (regressions != 0 || missing != 0)
+    return 1;
+
+  std::cout << "All benchmarks are within tolerance" << std::endl;
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  std::cerr << "Ape " << VERSION_STRING << " Performance Check" << std::endl
+            << "(c) Ape Emulator Project, 2018" << std::endl
+            << std::endl;
+
+  ParameterParser p;
+
+  p.AddString("baseline");
+  p.AddString("results");
+  p.AddCommand("update");
+  p.AddCommand("help");
+
+  if (!p.Parse(argc, argv)) {
+    std::cerr << "Bad parameters provided. See --help" << std::endl;
+    return 1;
+  }
+
+  if (p.CheckCommand("help") || p.GetString("baseline") == "" ||
+      p.GetString("results") == "") {
+    std::cerr << "Usage: " << argv[0]
+              << " --baseline (file) --results (a,b,...)" << std::endl
+              << "  --update  Replace the baseline with the results"
+              << std::endl;
+    return 1;
+  }
+
+  const auto& path = p.GetString("baseline");
+
+  // A missing baseline is fine when creating one
+  JSON::Value baseline;
+  std::string error;
+
+  if (!JSON::ParseFile(path, baseline, &error) && !p.CheckCommand("update")) {
+    std::cerr << path << ": " << error << std::endl
+              << "Create it with --update" << std::endl;
+    return 1;
+  }
+
+  Results results;
+  std::stringstream files(p.GetString("results"));
+
+  for (std::string file; std::getline(files, file, ',');) {
+    if (!Load(file, results))
+      return 1;
+  }
+
+  if (results.empty()) {
+    std::cerr << "No benchmark results found" << std::endl;
+    return 1;
+  }
+
+  if (p.CheckCommand("update"))
+    return Update(path, baseline, results);
+
+  return Compare(baseline, results);
+}
@@ -0,0 +1,33 @@
+# Integer arithmetic and tight loops
+#
+# as --32 -o Integer.o Integer.s
+# ld -m elf_i386 -Ttext 0x100 -e 0x100 --oformat binary -o Integer.com Integer.o
+
+.code16
+.text
+  mov $200, %si
+outer:
+  mov $1000, %cx
+  xor %ax, %ax
+  mov $1, %bx
+  xor %dx, %dx
+inner:
+  add %bx, %ax
+  adc $0, %dx
+  xor %cx, %bx
+  shl $1, %bx
+  inc %bx
+  mov %ax, %di
+  and $0xff, %di
+  sub %di, %ax
+  cmp $0x8000, %ax
+  jb 1f
+  sub $0x4000, %ax
+1:
+  inc %dx
+  dec %cx
+  jnz inner
+  dec %si
+  jnz outer
+
+  int $0x20
@@ -0,0 +1,40 @@
+# Call heavy recursion, computes fib(22) a few times
+#
+# as --32 -o Recursive.o Recursive.s
+# ld -m elf_i386 -Ttext 0x100 -e 0x100 --oformat binary -o Recursive.com Recursive.o
+
+.code16
+.text
+  mov $4, %si
+1:
+  mov $22, %ax
+  push %ax
+  call fib
+  add $2, %sp
+  dec %si
+  jnz 1b
+
+  int $0x20
+
+# u16 fib(u16 n), argument on the stack, result in AX
+fib:
+  push %bp
+  mov %sp, %bp
+  push %bx
+  mov 4(%bp), %ax
+  cmp $2, %ax
+  jb 2f
+  dec %ax
+  push %ax
+  call fib
+  mov %ax, %bx
+  pop %ax
+  dec %ax
+  push %ax
+  call fib
+  add $2, %sp
+  add %bx, %ax
+2:
+  pop %bx
+  pop %bp
+  ret
@@ -0,0 +1,50 @@
+# String instructions with and without REP prefixes
+#
+# as --32 -o String.o String.s
+# ld -m elf_i386 -Ttext 0x100 -e 0x100 --oformat binary -o String.com String.o
+
+.code16
+.text
+  .equ source, 0x1000
+  .equ dest, 0x2000
+
+  mov %cs, %ax
+  mov %ax, %es
+  cld
+  mov $200, %bp
+outer:
+  # Fill the source buffer
+  mov $source, %di
+  mov $0x4141, %ax
+  mov $2048, %cx
+  cmp %ax, %ax
+  rep stosw
+
+  # Copy it
+  mov $source, %si
+  mov $dest, %di
+  mov $2048, %cx
+  cmp %ax, %ax
+  rep movsw
+
+  # Compare both copies
+  mov $source, %si
+  mov $dest, %di
+  mov $2048, %cx
+  cmp %ax, %ax
+  repz cmpsw
+
+  # Transform it one byte at a time
+  mov $source, %si
+  mov $dest, %di
+  mov $1024, %cx
+1:
+  lodsb
+  xor $0x20, %al
+  stosb
+  loop 1b
+
+  dec %bp
+  jnz outer
+
+  int $0x20
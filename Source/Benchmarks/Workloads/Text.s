@@ -0,0 +1,42 @@
+# Text output through BIOS and DOS interrupts
+#
+# as --32 -o Text.o Text.s
+# ld -m elf_i386 -Ttext 0x100 -e 0x100 --oformat binary -o Text.com Text.o
+
+.code16
+.text
+  mov $2000, %bp
+outer:
+  # Whole line through DOS
+  mov $line, %dx
+  mov $0x09, %ah
+  int $0x21
+
+  # Character by character through DOS
+  mov $line, %si
+1:
+  lodsb
+  cmp $'$', %al
+  je 2f
+  mov %al, %dl
+  mov $0x02, %ah
+  int $0x21
+  jmp 1b
+2:
+  # Character by character through the BIOS
+  mov $line, %si
+3:
+  lodsb
+  cmp $'$', %al
+  je 4f
+  mov $0x0e, %ah
+  int $0x10
+  jmp 3b
+4:
+  dec %bp
+  jnz outer
+
+  int $0x20
+
+line:
+  .ascii "The quick brown fox jumps over the lazy dog\r\n$"
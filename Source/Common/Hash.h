@@ -0,0 +1,34 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+
+#include <cstddef>
+
+#include "Common/Types.h"
+
+namespace Hash
+{
+constexpr u64 FNV_OFFSET = 0xCBF29CE484222325;
+constexpr u64 FNV_PRIME = 0x100000001B3;
+
+//! FNV-1a of size bytes at data, continuing from hash
+inline u64 FNV1a(const void* data, size_t size, u64 hash = FNV_OFFSET)
+{
+  const u8* bytes = static_cast<const u8*>(data);
+
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
+
+//! FNV-1a of the bytes of value, continuing from hash
+template <typename T> u64 FNV1a(const T& value, u64 hash = FNV_OFFSET)
+{
+  return FNV1a(&value, sizeof(value), hash);
+}
+} // namespace Hash
@@ -0,0 +1,485 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Common/JSON.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "Common/Types.h"
+
+using namespace JSON;
+
+// Deeper nesting is rejected instead of overflowing the stack
+constexpr int MAX_DEPTH = 256;
+
+Value::Value(bool value) : m_type(Type::Bool), m_bool(value) {}
+Value::Value(double value) : m_type(Type::Number), m_number(value) {}
+Value::Value(int value) : m_type(Type::Number), m_number(value) {}
+Value::Value(const char* value) : m_type(Type::String), m_string(value) {}
+Value::Value(const std::string& value) : m_type(Type::String), m_string(value)
+{
+}
+Value::Value(const Array& value) : m_type(Type::Array), m_array(value) {}
+Value::Value(const Object& value) : m_type(Type::Object), m_object(value) {}
+
+Value::Type Value::GetType() const { return m_type; }
+bool Value::IsNull() const { return m_type == Type::Null; }
+bool Value::IsNumber() const { return m_type == Type::Number; }
+bool Value::IsString() const { return m_type == Type::String; }
+bool Value::IsArray() const { return m_type == Type::Array; }
+bool Value::IsObject() const { return m_type == Type::Object; }
+
+bool Value::AsBool() const { return m_bool; }
+double Value::AsNumber() const { return m_number; }
+const std::string& Value::AsString() const { return m_string; }
+const Value::Array& Value::AsArray() const { return m_array; }
+const Value::Object& Value::AsObject() const { return m_object; }
+
+bool Value::Has(const std::string& key) const
+{
+  return m_type == Type::Object && m_object.count(key);
+}
+
+const Value& Value::operator[](const std::string& key) const
+{
+  static const Value null;
+
+  if (!Has(key))
+    return null;
+
+  return m_object.at(key);
+}
+
+Value& Value::operator[](const std::string& key)
+{
+  if (m_type != Type::Object)
+    *this = Object();
+
+  return m_object[key];
+}
+
+void Value::Append(const Value& value)
+{
+  if (m_type != Type::Array)
+    *this = Array();
+
+  m_array.push_back(value);
+}
+
+namespace
+{
+struct Parser {
+  const std::string& text;
+  size_t pos;
+  std::string error;
+
+  bool Fail(const std::string& message)
+  {
+    if (error.empty())
+      error = message + " at offset " + std::to_string(pos);
+    return false;
+  }
+
+  void SkipWhitespace()
+  {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' ||
+                                 text[pos] == '\n' || text[pos] == '\r'))
+      pos++;
+  }
+
+  bool Expect(const std::string& word)
+  {
+    if (text.compare(pos, word.size(), word) != 0)
+      return Fail("Expected '" + word + "'");
+
+    pos += word.size();
+    return true;
+  }
+
+  bool ParseHex(u32& code)
+  {
+    if (pos + 4 > text.size())
+      return Fail("Truncated escape");
+
+    code = 0;
+
+    for (int i = 0; i < 4; i++) {
+      const char c = text[pos++];
+      code <<= 4;
+
+      if (c >= '0' && c <= '9')
+        code |= c - '0';
+      else if (c >= 'a' && c <= 'f')
+        code |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+        code |= c - 'A' + 10;
+      else
+        return Fail("Bad escape");
+    }
+
+    return true;
+  }
+
+  static void AppendUTF8(std::string& s, u32 code)
+  {
+    if (code < 0x80) {
+      s += static_cast<char>(code);
+    } else if (code < 0x800) {
+      s += static_cast<char>(0xC0 | code >> 6);
+      s += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+      s += static_cast<char>(0xE0 | code >> 12);
+      s += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+      s += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+      s += static_cast<char>(0xF0 | code >> 18);
+      s += static_cast<char>(0x80 | (code >> 12 & 0x3F));
+      s += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+      s += static_cast<char>(0x80 | (code & 0x3F));
+    }
+  }
+
+  bool ParseString(std::string& s)
+  {
+    pos++; // Opening quote
+
+    while (pos < text.size() && text[pos] != '"') {
+      const char c = text[pos++];
+
+      if (static_cast<u8>(c) < 0x20)
+        return Fail("Control character in string");
+
+      if (c != '\\') {
+        s += c;
+        continue;
+      }
+
+      if (pos >= text.size())
+        break;
+
+      switch (text[pos++]) {
+      case '"':
+        s += '"';
+        break;
+      case '\\':
+        s += '\\';
+        break;
+      case '/':
+        s += '/';
+        break;
+      case 'b':
+        s += '\b';
+        break;
+      case 'f':
+        s += '\f';
+        break;
+      case 'n':
+        s += '\n';
+        break;
+      case 'r':
+        s += '\r';
+        break;
+      case 't':
+        s += '\t';
+        break;
+      case 'u': {
+        u32 code;
+        if (!ParseHex(code))
+          return false;
+
+        // Combine surrogate pairs
+        if (code >= 0xD800 && code < 0xDC00 &&
+            text.compare(pos, 2, "\\u") == 0) {
+          pos += 2;
+          u32 low;
+          if (!ParseHex(low))
+            return false;
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+
+        AppendUTF8(s, code);
+        break;
+      }
+      default:
+        pos--;
+        return Fail("Bad escape");
+      }
+    }
+
+    if (pos >= text.size())
+      return Fail("Unterminated string");
+
+    pos++; // Closing quote
+    return true;
+  }
+
+  bool ParseNumber(Value& value)
+  {
+    const size_t start = pos;
+
+    if (text[pos] == '-')
+      pos++;
+
+    if (pos >= text.size() || !std::isdigit(static_cast<u8>(text[pos])))
+      return Fail("Bad number");
+
+    while (pos < text.size() &&
+           (std::isdigit(static_cast<u8>(text[pos])) || text[pos] == '.' ||
+            text[pos] == 'e' || text[pos] == 'E' || text[pos] == '+' ||
+            text[pos] == '-'))
+      pos++;
+
+    const std::string number = text.substr(start, pos - start);
+    char* end;
+    const double result = std::strtod(number.c_str(), &end);
+
+    if (*end != '\0') {
+      pos = start;
+      return Fail("Bad number");
+    }
+
+    value = result;
+    return true;
+  }
+
+  bool ParseValue(Value& value, int depth)
+  {
+    if (depth > MAX_DEPTH)
+      return Fail("Nesting too deep");
+
+    SkipWhitespace();
+
+    if (pos >= text.size())
+      return Fail("Unexpected end");
+
+    switch (text[pos]) {
+    case 'n':
+      value = Value();
+      return Expect("null");
+    case 't':
+      value = true;
+      return Expect("true");
+    case 'f':
+      value = false;
+      return Expect("false");
+    case '"': {
+      std::string s;
+      if (!ParseString(s))
+        return false;
+      value = s;
+      return true;
+    }
+    case '[': {
+      pos++;
+      value = Value::Array();
+
+      SkipWhitespace();
+      if (pos < text.size() && text[pos] == ']') {
+        pos++;
+        return true;
+      }
+
+      while (true) {
+        Value element;
+        if (!ParseValue(element, depth + 1))
+          return false;
+        value.Append(element);
+
+        SkipWhitespace();
+        if (pos < text.size() && text[pos] == ',') {
+          pos++;
+          continue;
+        }
+
+        return Expect("]");
+      }
+    }
+    case '{': {
+      pos++;
+      value = Value::Object();
+
+      SkipWhitespace();
+      if (pos < text.size() && text[pos] == '}') {
+        pos++;
+        return true;
+      }
+
+      while (true) {
+        SkipWhitespace();
+        if (pos >= text.size() || text[pos] != '"')
+          return Fail("Expected a member name");
+
+        std::string key;
+        if (!ParseString(key))
+          return false;
+
+        SkipWhitespace();
+        if (!Expect(":") || !ParseValue(value[key], depth + 1))
+          return false;
+
+        SkipWhitespace();
+        if (pos < text.size() && text[pos] == ',') {
+          pos++;
+          continue;
+        }
+
+        return Expect("}");
+      }
+    }
+    default:
+      return ParseNumber(value);
+    }
+  }
+};
+} // namespace
+
+bool JSON::Parse(const std::string& text, Value& value, std::string* error)
+{
+  Parser parser{text, 0, ""};
+  Value result;
+
+  bool ok = parser.ParseValue(result, 0);
+
+  if (ok) {
+    parser.SkipWhitespace();
+    if (parser.pos != text.size())
+      ok = parser.Fail("Trailing characters");
+  }
+
+  if (!ok) {
+    if (error)
+      *error = parser.error;
+    return false;
+  }
+
+  value = std::move(result);
+  return true;
+}
+
+bool JSON::ParseFile(const std::string& path, Value& value, std::string* error)
+{
+  std::ifstream ifs(path);
+
+  if (!ifs.good()) {
+    if (error)
+      *error = "Failed to open " + path;
+    return false;
+  }
+
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+
+  return Parse(ss.str(), value, error);
+}
+
+static void WriteString(std::ostream& stream, const std::string& s)
+{
+  stream << '"';
+
+  for (char c : s) {
+    switch (c) {
+    case '"':
+      stream << "\\\"";
+      break;
+    case '\\':
+      stream << "\\\\";
+      break;
+    case '\n':
+      stream << "\\n";
+      break;
+    case '\r':
+      stream << "\\r";
+      break;
+    case '\t':
+      stream << "\\t";
+      break;
+    default:
+      if (static_cast<u8>(c) < 0x20) {
+        stream << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+               << static_cast<int>(c) << std::dec << std::setfill(' ');
+      } else {
+        stream << c;
+      }
+    }
+  }
+
+  stream << '"';
+}
+
+static void WriteValue(std::ostream& stream, const Value& value, int indent,
+                       int level)
+{
+  auto NewLine = [&stream, indent](int level) {
+    if (indent != 0)
+      stream << '\n' << std::string(indent * level, ' ');
+  };
+
+  switch (value.GetType()) {
+  case Value::Type::Null:
+    stream << "null";
+    break;
+  case Value::Type::Bool:
+    stream << (value.AsBool() ? "true" : "false");
+    break;
+  case Value::Type::Number:
+    // JSON has no representation for these
+    if (!std::isfinite(value.AsNumber()))
+      stream << "null";
+    else
+      stream << std::setprecision(15) << value.AsNumber();
+    break;
+  case Value::Type::String:
+    WriteString(stream, value.AsString());
+    break;
+  case Value::Type::Array: {
+    const auto& array = value.AsArray();
+
+    stream << '[';
+    for (size_t i = 0; i < array.size(); i++) {
+      if (i != 0)
+        stream << ',';
+      NewLine(level + 1);
+      WriteValue(stream, array[i], indent, level + 1);
+    }
+
+    if (!array.empty())
+      NewLine(level);
+    stream << ']';
+    break;
+  }
+  case Value::Type::Object: {
+    const auto& object = value.AsObject();
+
+    stream << '{';
+    bool first = true;
+    for (const auto& [key, member] : object) {
+      if (!first)
+        stream << ',';
+      first = false;
+
+      NewLine(level + 1);
+      WriteString(stream, key);
+      stream << (indent != 0 ? ": " : ":");
+      WriteValue(stream, member, indent, level + 1);
+    }
+
+    if (!object.empty())
+      NewLine(level);
+    stream << '}';
+    break;
+  }
+  }
+}
+
+std::string JSON::Write(const Value& value, int indent)
+{
+  std::ostringstream ss;
+  WriteValue(ss, value, indent, 0);
+  return ss.str();
+}
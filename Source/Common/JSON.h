@@ -0,0 +1,76 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+//! Minimal JSON reader and writer
+namespace JSON
+{
+class Value
+{
+public:
+  enum class Type { Null, Bool, Number, String, Array, Object };
+
+  using Array = std::vector<Value>;
+  using Object = std::map<std::string, Value>;
+
+  Value() = default;
+  Value(bool value);
+  Value(double value);
+  Value(int value);
+  Value(const char* value);
+  Value(const std::string& value);
+  Value(const Array& value);
+  Value(const Object& value);
+
+  Type GetType() const;
+  bool IsNull() const;
+  bool IsNumber() const;
+  bool IsString() const;
+  bool IsArray() const;
+  bool IsObject() const;
+
+  //! Get the contents, or an empty / zero value if the type doesn't match
+  bool AsBool() const;
+  double AsNumber() const;
+  const std::string& AsString() const;
+  const Array& AsArray() const;
+  const Object& AsObject() const;
+
+  //! Check whether this is an object with the member key
+  bool Has(const std::string& key) const;
+
+  //! Get a member, or a null Value if there is none
+  const Value& operator[](const std::string& key) const;
+
+  //! Get a member, turning this into an object and adding it if needed
+  Value& operator[](const std::string& key);
+
+  //! Append an element, turning this into an array if needed
+  void Append(const Value& value);
+
+private:
+  Type m_type = Type::Null;
+  bool m_bool = false;
+  double m_number = 0;
+  std::string m_string;
+  Array m_array;
+  Object m_object;
+};
+
+//! Parse text into value. On failure error describes what went wrong
+bool Parse(const std::string& text, Value& value, std::string* error = nullptr);
+
+//! Parse the file at path
+bool ParseFile(const std::string& path, Value& value,
+               std::string* error = nullptr);
+
+//! Serialize value, indenting nested values by indent spaces (0 for a single
+//! line)
+std::string Write(const Value& value, int indent = 2);
+} // namespace JSON
@@ -18,7 +18,9 @@ bool ParameterParser::Parse(int argc, char** argv)
     if (parameter.find('=') != std::string::npos) {
       value = parameter.substr(parameter.find('=') + 1);
       parameter = parameter.substr(0, parameter.find('='));
-    } else if (i + 1 < argc) {
+    } else if (i + 1 < argc && m_parameters.count(parameter) &&
+               m_parameters[parameter].type == Parameter::Type::STRING) {
+      // Only strings take the next argument, so commands can go anywhere
       value = argv[++i];
     }
 
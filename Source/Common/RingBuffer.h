@@ -0,0 +1,66 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**@brief Lock-free ring buffer
+ *
+ * Safe to use from exactly one producer and one consumer thread at the same
+ * time.
+ */
+template <typename T, size_t Capacity> class RingBuffer
+{
+  static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+public:
+  //! Append an element. Returns ``false`` if the buffer is full
+  bool Push(const T& value)
+  {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+
+    if (head - m_tail.load(std::memory_order_acquire) == Capacity)
+      return false;
+
+    m_data[head & (Capacity - 1)] = value;
+    m_head.store(head + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  //! Remove the oldest element. Returns ``false`` if the buffer is empty
+  bool Pop(T& value)
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+    if (m_head.load(std::memory_order_acquire) == tail)
+      return false;
+
+    value = m_data[tail & (Capacity - 1)];
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  //! Get the amount of elements currently stored
+  size_t Size() const
+  {
+    return m_head.load(std::memory_order_acquire) -
+           m_tail.load(std::memory_order_acquire);
+  }
+
+  bool IsEmpty() const { return Size() == 0; }
+
+private:
+  std::array<T, Capacity> m_data;
+
+  // Keep both indices on separate cache lines so the threads don't contend
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+};
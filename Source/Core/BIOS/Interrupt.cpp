@@ -4,6 +4,7 @@
 
 #include "Core/CPU/CPU.h"
 
+#include <cctype>
 #include <fstream>
 #include <iostream>
 
@@ -13,136 +14,269 @@
 
 #include "Core/CPU/Exception.h"
 #include "Core/HW/FloppyDrive.h"
+#include "Core/HW/IO.h"
+#include "Core/HW/Keyboard.h"
 #include "Core/TTY.h"
 
-using namespace Core;
+// Timer ticks from midnight to midnight
+constexpr u32 TICKS_PER_DAY = 0x1800B0;
 
-bool CPU::CallBIOSInterrupt(u8 vector)
+// Shift flags in the BIOS data area (0040:0017)
+constexpr u8 RIGHT_SHIFT = 1 << 0;
+constexpr u8 LEFT_SHIFT = 1 << 1;
+constexpr u8 CONTROL = 1 << 2;
+constexpr u8 ALT = 1 << 3;
+
+namespace Core::CPU
 {
-  switch (vector) {
-  case 0x10: // Video services
-    switch (AH) {
-    case 0x00: // Set video mode
-      WARN("Video mode setting ignored, might cause issues");
-      break;
-    case 0x01: // Set cursor shape
-      WARN("Cursor shape setting ignored, might cause issues");
-      break;
-    case 0x06: { // Scroll screen
-      TTY::Scroll(BL, BH);
-      break;
-    }
-    case 0x02: { // Set cursor
-      TTY::SetCursorRow(DH);
-      TTY::SetCursorColumn(DL);
-      break;
-    }
-    case 0x03: { // Get cursor info
-      AX = 0;
+// INT 08h (IRQ0)
+static void TimerTick()
+{
+  u32& ticks = Memory::Get<u32>(0x0040, 0x006C);
 
-      // TODO: Start and end scan line?
-      CH = CL = 0;
+  if (++ticks >= TICKS_PER_DAY) {
+    ticks = 0;
+    Memory::Get<u8>(0x0040, 0x0070) = 1; // Midnight passed
+  }
+}
 
-      DH = TTY::GetCursorRow();
-      DL = TTY::GetCursorColumn();
-      break;
-    }
-    case 0x0E: { // Write character and move cursor
-      TTY::Write(AL);
-    } break;
-    default:
-      LOG("[INT 10h] Unknown parameter AH=" + String::ToHex(AH));
-      throw UnhandledInterruptException();
-    }
-    break;
-  case 0x13: // Disc services
-    switch (AH) {
-    case 0x00: // Reset disc drives
-      // TODO: Do something here?
-      AH = 0;
-      CF = false;
-      break;
-    case 0x02: { // Read disc sector
+// Shift flag a key changes, 0 for the other keys
+static u8 GetShiftFlag(u8 code)
+{
+  switch (code) {
+  case 0x36:
+    return RIGHT_SHIFT;
+  case 0x2A:
+    return LEFT_SHIFT;
+  case 0x1D:
+    return CONTROL;
+  case 0x38:
+    return ALT;
+  default:
+    return 0;
+  }
+}
+
+// INT 09h (IRQ1)
+static void KeyboardInterrupt()
+{
+  const u8 code = HW::IO::Read(0x60);
+  const bool released = code & 0x80;
+  const u8 key = code & 0x7F;
 
-      const u8 sector_count = AL;
-      const u8 cylinder = CH;
-      const u8 sector = CL;
-      const u8 head = DH;
-      const u8 drive = DL;
+  u8& flags = Memory::Get<u8>(0x0040, 0x0017);
 
-      // We currently only support one floppy drive.
-      if (drive != 0) {
-        AH = 0xAA; // Drive not ready
-        CF = true;
-        break;
-      }
+  if (const u8 flag = GetShiftFlag(key); flag != 0) {
+    flags = released ? flags & ~flag : flags | flag;
+    return;
+  }
 
-      u8* dest = Memory::GetPtr<u8>(ES, BX);
+  if (released)
+    return;
 
-      LOG("C:H:S = " + String::ToHex<u8>(cylinder) + ":" +
-          String::ToHex<u8>(head) + ":" + String::ToHex<u8>(sector));
+  char c = HW::Keyboard::ToChar(key, flags & (LEFT_SHIFT | RIGHT_SHIFT));
 
-      LOG("ES:BX = " + String::ToHex<u16>(ES) + ":" + String::ToHex<u16>(BX));
+  if (flags & ALT)
+    c = 0;
+  else if ((flags & CONTROL) && std::isalpha(c))
+    c &= 0x1F;
 
-      LOG(String::ToHex<u32>(sector_count) + " to be read.");
+  if (!TTY::PushKey(static_cast<u16>(key << 8 | static_cast<u8>(c))))
+    LOG("Keyboard buffer full, dropping key " + String::ToHex(key));
+}
 
-      if (!Core::HW::FloppyDrive::Read(cylinder, head, sector, sector_count,
-                                       dest)) {
-        AH = 0x40; // Bad seek (Is there a more fitting one?)
-        CF = true;
-        LOG("Read error!");
-        break;
-      }
+// INT 10h
+static void VideoServices()
+{
+  switch (AH) {
+  case 0x00: // Set video mode
+    WARN("Video mode setting ignored, might cause issues");
+    break;
+  case 0x01: // Set cursor shape
+    WARN("Cursor shape setting ignored, might cause issues");
+    break;
+  case 0x06: { // Scroll screen
+    TTY::Scroll(BL, BH);
+    break;
+  }
+  case 0x02: { // Set cursor
+    TTY::SetCursorRow(DH);
+    TTY::SetCursorColumn(DL);
+    break;
+  }
+  case 0x03: { // Get cursor info
+    AX = 0;
 
-      AH = 0;
-      CF = false;
-      break;
-    }
-    default:
-      LOG("[INT 13h] Unknown parameter AH=" + String::ToHex(AH));
-      throw UnhandledInterruptException();
-    }
+    // TODO: Start and end scan line?
+    CH = CL = 0;
+
+    DH = TTY::GetCursorRow();
+    DL = TTY::GetCursorColumn();
     break;
-  case 0x16: { // Keyboard services
-    switch (AH) {
-    case 0x00: // Wait for key press
-      AL = TTY::Read();
-      AH = 0; // TODO: This should be the scancode...
-      CF = false;
+  }
+  case 0x0E: { // Write character and move cursor
+    TTY::Write(AL);
+  } break;
+  default:
+    LOG("[INT 10h] Unknown parameter AH=" + String::ToHex(AH));
+    throw UnhandledInterruptException();
+  }
+}
+
+// INT 12h
+static void GetMemorySize()
+{
+  AX = static_cast<u16>(Memory::GetConventionalSize() / 1024);
+}
+
+// INT 13h
+static void DiscServices()
+{
+  switch (AH) {
+  case 0x00: // Reset disc drives
+    // TODO: Do something here?
+    AH = 0;
+    CF = false;
+    break;
+  case 0x02: { // Read disc sector
+
+    const u8 sector_count = AL;
+    const u8 cylinder = CH;
+    const u8 sector = CL;
+    const u8 head = DH;
+    const u8 drive = DL;
+
+    // We currently only support one floppy drive.
+    if (drive != 0) {
+      AH = 0xAA; // Drive not ready
+      CF = true;
       break;
-    case 0x01: // Poll keys
-      WARN("Key polling ignored");
-      ZF = true;
+    }
+
+    u8* dest = Memory::GetPtr<u8>(ES, BX);
+
+    LOG("C:H:S = " + String::ToHex<u8>(cylinder) + ":" +
+        String::ToHex<u8>(head) + ":" + String::ToHex<u8>(sector));
+
+    LOG("ES:BX = " + String::ToHex<u16>(ES) + ":" + String::ToHex<u16>(BX));
+
+    LOG(String::ToHex<u32>(sector_count) + " to be read.");
+
+    if (!Core::HW::FloppyDrive::Read(cylinder, head, sector, sector_count,
+                                     dest)) {
+      AH = 0x40; // Bad seek (Is there a more fitting one?)
+      CF = true;
+      LOG("Read error!");
       break;
-    default:
-      LOG("[INT 16h] Unknown parameter AH=" + String::ToHex(AH));
-      throw UnhandledInterruptException();
     }
+
+    AH = 0;
+    CF = false;
     break;
-  case 0x17: // Printer services
-    switch (AH) {
-    case 0x00: // Write character
-      LOG("[PRINTER STUB] Writing " + std::string(AL, 1));
-
-      // Set both the "Out of paper" and "Selected" flag to indicate no printer
-      // is attached
-      AH = 0b0011'0000;
+  }
+  default:
+    LOG("[INT 13h] Unknown parameter AH=" + String::ToHex(AH));
+    throw UnhandledInterruptException();
+  }
+}
+
+// INT 16h
+static void KeyboardServices()
+{
+  switch (AH) {
+  case 0x00: // Wait for key press
+    if (!TTY::IsCharAvailable()) {
+      WaitForInterrupt();
       break;
-    default:
-      LOG("[INT 17h] Unknown parameter AH=" + String::ToHex(AH));
-      throw UnhandledInterruptException();
     }
+
+    AX = TTY::ReadKey();
+    break;
+  case 0x01: // Poll keys
+    ZF = !TTY::IsCharAvailable();
+
+    if (!ZF)
+      AX = TTY::PeekKey();
+    break;
+  case 0x02: // Get shift flags
+    AL = Memory::Get<u8>(0x0040, 0x0017);
     break;
+  default:
+    LOG("[INT 16h] Unknown parameter AH=" + String::ToHex(AH));
+    throw UnhandledInterruptException();
+  }
+}
+
+// INT 17h
+static void PrinterServices()
+{
+  switch (AH) {
+  case 0x00: // Write character
+    LOG("[PRINTER STUB] Writing " + std::string(AL, 1));
+
+    // Set both the "Out of paper" and "Selected" flag to indicate no printer
+    // is attached
+    AH = 0b0011'0000;
+    break;
+  default:
+    LOG("[INT 17h] Unknown parameter AH=" + String::ToHex(AH));
+    throw UnhandledInterruptException();
   }
-  case 0x19: // Reset
-  {
-    LOG("[STUB] Reset requested; Stopping...");
-    Stop();
+}
+
+// INT 19h
+static void Reset()
+{
+  LOG("[STUB] Reset requested; Stopping...");
+  Stop();
+}
+
+// INT 1Ah
+static void TimeServices()
+{
+  switch (AH) {
+  case 0x00: { // Read tick count
+    const u32 ticks = Memory::Get<u32>(0x0040, 0x006C);
+    CX = static_cast<u16>(ticks >> 16);
+    DX = static_cast<u16>(ticks);
+
+    // Whether midnight passed since the last read
+    u8& midnight = Memory::Get<u8>(0x0040, 0x0070);
+    AL = midnight;
+    midnight = 0;
     break;
   }
+  case 0x01: // Set tick count
+    Memory::Get<u32>(0x0040, 0x006C) = static_cast<u32>(CX << 16 | DX);
+    Memory::Get<u8>(0x0040, 0x0070) = 0;
+    break;
+  case 0x02: // Read real time clock time
+  case 0x03: // Set real time clock time
+  case 0x04: // Read real time clock date
+  case 0x05: // Set real time clock date
+    // The PC has no real time clock
+    CF = true;
+    break;
   default:
-    return false;
+    LOG("[INT 1Ah] Unknown parameter AH=" + String::ToHex(AH));
+    throw UnhandledInterruptException();
   }
+}
 
-  return true;
+// INT 1Ch, called by the IRQ0 handler for programs to hook
+static void UserTimerTick() {}
+
+void SetBIOSInterruptHandlers()
+{
+  SetInterruptHandler(0x08, TimerTick);
+  SetInterruptHandler(0x09, KeyboardInterrupt);
+  SetInterruptHandler(0x10, VideoServices);
+  SetInterruptHandler(0x12, GetMemorySize);
+  SetInterruptHandler(0x13, DiscServices);
+  SetInterruptHandler(0x16, KeyboardServices);
+  SetInterruptHandler(0x17, PrinterServices);
+  SetInterruptHandler(0x19, Reset);
+  SetInterruptHandler(0x1A, TimeServices);
+  SetInterruptHandler(0x1C, UserTimerTick);
 }
+} // namespace Core::CPU
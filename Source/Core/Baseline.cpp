@@ -0,0 +1,133 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Baseline.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "Common/Logger.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/Core.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+
+constexpr char MAGIC[8] = {'A', 'P', 'E', 'B', 'A', 'S', 'E', '\0'};
+constexpr u16 VERSION = 1;
+
+namespace
+{
+//! Header at the beginning of a baseline, followed by RAM and the HMA
+//! starting at the next page so RAM can be mapped directly. As contexts are
+//! stored as they are, baselines only work with the build that wrote them
+struct Header {
+  char magic[8];
+  u16 version;
+  u8 a20;
+  u8 reserved;
+  u32 conventional;
+  u64 instructions;
+  CPU::Context context;
+};
+
+static_assert(std::is_trivially_copyable<Header>::value,
+              "Headers are written as they are");
+static_assert(sizeof(Header) <= Memory::PAGE_SIZE, "Bad header size");
+} // namespace
+
+bool Baseline::pending = false;
+
+static std::string s_path;
+static u64 s_instruction;
+
+bool Baseline::Save(const std::string& path)
+{
+  std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+
+  if (!ofs.good()) {
+    ERROR("Failed to open baseline " + path);
+    return false;
+  }
+
+  Header header{};
+  std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+  header.version = VERSION;
+  header.a20 = Memory::IsA20Enabled();
+  header.conventional = Memory::GetConventionalSize();
+  header.instructions = CPU::instructions;
+  header.context = CPU::SaveContext();
+
+  std::vector<u8> page(Memory::PAGE_SIZE);
+  std::copy_n(reinterpret_cast<const u8*>(&header), sizeof(header),
+              page.begin());
+
+  ofs.write(reinterpret_cast<const char*>(page.data()), page.size());
+  ofs.write(reinterpret_cast<const char*>(Memory::base), Memory::SIZE);
+
+  // The HMA is only visible with the A20 gate enabled
+  Memory::SetA20Enabled(true);
+  ofs.write(reinterpret_cast<const char*>(Memory::base + Memory::SIZE),
+            Memory::HMA_SIZE);
+  Memory::SetA20Enabled(header.a20);
+
+  return ofs.good();
+}
+
+void Baseline::SaveAt(const std::string& path, u64 instruction)
+{
+  s_path = path;
+  s_instruction = instruction;
+  pending = true;
+}
+
+void Baseline::Update()
+{
+  if (!pending || CPU::instructions < s_instruction)
+    return;
+
+  pending = false;
+
+  if (Save(s_path))
+    LOG("Saved baseline " + s_path + " at instruction " +
+        std::to_string(CPU::instructions));
+}
+
+bool Baseline::Load(const std::string& path)
+{
+  std::ifstream ifs(path, std::ios::binary);
+
+  Header header;
+  ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  if (!ifs.good() ||
+      !std::equal(std::begin(MAGIC), std::end(MAGIC), header.magic) ||
+      header.version != VERSION) {
+    ERROR(path + " is not a baseline of this version");
+    return false;
+  }
+
+  memory_config.conventional = header.conventional;
+  Init();
+
+  if (!Memory::MapFile(0, path, Memory::PAGE_SIZE, Memory::SIZE)) {
+    ERROR("Failed to map baseline " + path);
+    return false;
+  }
+
+  Memory::SetA20Enabled(true);
+  ifs.seekg(Memory::PAGE_SIZE + Memory::SIZE);
+  ifs.read(reinterpret_cast<char*>(Memory::base + Memory::SIZE),
+           Memory::HMA_SIZE);
+  Memory::SetA20Enabled(header.a20);
+
+  CPU::LoadContext(header.context);
+  CPU::instructions = header.instructions;
+
+  return ifs.good();
+}
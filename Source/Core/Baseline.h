@@ -0,0 +1,39 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <string>
+
+#include "Common/Types.h"
+
+/**@brief Machine states many instances can start from
+ *
+ * A baseline holds the registers and all of RAM (including the BIOS ROM and
+ * the video buffer) of a machine, e.g. after it booted. Instances starting
+ * from the same baseline file map its RAM copy-on-write, so they share one
+ * copy of every page they haven't written to.
+ *
+ * Extra memory (EMS and XMS) and host side state (e.g. MS-DOS file handles or
+ * the floppy drive) are not part of a baseline.
+ */
+namespace Core::Baseline
+{
+//! Whether a baseline is due to be saved. Use SaveAt() to change this
+extern bool pending;
+
+//! Write the current machine state to path
+bool Save(const std::string& path);
+
+//! Save the machine state to path once instruction instructions have been
+//! executed
+void SaveAt(const std::string& path, u64 instruction);
+
+//! Save the machine state if it is due
+void Update();
+
+//! Reset the machine to the state in path
+bool Load(const std::string& path);
+} // namespace Core::Baseline
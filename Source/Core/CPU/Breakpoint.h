@@ -17,4 +17,7 @@ void RemoveBreakpoint(Breakpoint b);
 
 bool IsBreakpointHit();
 bool IsBreakpoint(u16 sgement, u16 offset);
+
+//! Don't pause on a breakpoint at the current CS:IP when resuming
+void SkipCurrentBreakpoint();
 } // namespace Core::CPU
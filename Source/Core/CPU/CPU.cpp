@@ -6,53 +6,44 @@
 
 #include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <type_traits>
 
+#include "Core/Baseline.h"
 #include "Core/CPU/Breakpoint.h"
 #include "Core/CPU/Flags.h"
 #include "Core/CPU/Instruction.h"
 #include "Core/Core.h"
+#include "Core/Debug/CallStack.h"
+#include "Core/Debug/Checkpoint.h"
+#include "Core/Debug/Coverage.h"
+#include "Core/Debug/Lockstep.h"
+#include "Core/Debug/OpCounters.h"
+#include "Core/Debug/Profiler.h"
+#include "Core/Debug/StateHash.h"
+#include "Core/Debug/Trace.h"
+#include "Core/HW/IO.h"
+#include "Core/HW/Keyboard.h"
+#include "Core/HW/PIC.h"
 #include "Core/HW/VGA.h"
+#include "Core/Scheduler.h"
 
 namespace Core::CPU
 {
 
 Type type;
 
-GPR A, B, C, D;
-
-u16& AX = A.X;
-u16& BX = B.X;
-u16& CX = C.X;
-u16& DX = D.X;
-
-u8& AH = A.b8.H;
-u8& AL = A.b8.L;
-
-u8& BH = B.b8.H;
-u8& BL = B.b8.L;
-
-u8& CH = C.b8.H;
-u8& CL = C.b8.L;
-
-u8& DH = D.b8.H;
-u8& DL = D.b8.L;
-
-u16 IP = 0;
-u16 DI = 0;
-u16 SI = 0;
-u16 SP = 0;
-u16 BP = 0;
-
-u16 CS = 0;
-u16 DS = 0;
-u16 SS = 0;
-u16 ES = 0;
+Registers registers;
 
 u16 LAST_CS = 0;
 u16 LAST_IP = 0;
 
+u64 instructions = 0;
+
+u32 events = 0;
+
 bool AF = false;
 bool CF = false;
 bool IF = false;
@@ -73,8 +64,124 @@ u64 clock_speed = 5'000'000;
 
 RepeatMode s_repeat_mode = RepeatMode::None;
 
-void Stop() { running = false; }
-void SetPaused(bool value) { paused = value; }
+// Instruction after which interrupts are held off for one more instruction
+// (STI and loads of SS, so SS:SP can be set without an interrupt in between)
+static u64 s_interrupt_shadow = 0;
+
+// Whether HLT is waiting for an interrupt
+static bool s_halted = false;
+
+namespace
+{
+struct ExecutionState {
+  u64 interrupt_shadow;
+  bool halted;
+};
+} // namespace
+
+// Set by Wake() to end the sleep of Idle() early
+static std::mutex s_wake_mutex;
+static std::condition_variable s_wake;
+static bool s_woken = false;
+
+u16 GetFlags()
+{
+  return static_cast<u16>(CF) | (1 << 1) | (static_cast<u16>(PF) << 2) |
+         (static_cast<u16>(AF) << 4) | (static_cast<u16>(ZF) << 6) |
+         (static_cast<u16>(SF) << 7) | (/*TF*/ 0 << 8) |
+         (static_cast<u16>(IF) << 9) | (static_cast<u16>(DF) << 10) |
+         (static_cast<u16>(OF) << 11) | (1 << 14) | (1 << 15);
+}
+
+void SetFlags(u16 flags)
+{
+  CF = flags & 1;
+  PF = flags & (1 << 2);
+  AF = flags & (1 << 4);
+  ZF = flags & (1 << 6);
+  SF = flags & (1 << 7);
+  // TF = flags & (1 << 8);
+  IF = flags & (1 << 9);
+  DF = flags & (1 << 10);
+  OF = flags & (1 << 11);
+}
+
+Context SaveContext()
+{
+  return {AX, BX, CX, DX, CS, DS, ES, SS, IP, BP, SP, SI, DI,
+          AF, CF, IF, DF, OF, PF, SF, ZF, s_repeat_mode};
+}
+
+void LoadContext(const Context& context)
+{
+  AX = context.AX;
+  BX = context.BX;
+  CX = context.CX;
+  DX = context.DX;
+
+  CS = context.CS;
+  DS = context.DS;
+  ES = context.ES;
+  SS = context.SS;
+
+  IP = context.IP;
+  BP = context.BP;
+  SP = context.SP;
+  SI = context.SI;
+  DI = context.DI;
+
+  AF = context.AF;
+  CF = context.CF;
+  IF = context.IF;
+  DF = context.DF;
+  OF = context.OF;
+  PF = context.PF;
+  SF = context.SF;
+  ZF = context.ZF;
+
+  s_repeat_mode = context.repeat_mode;
+}
+
+void Stop()
+{
+  running = false;
+  Wake();
+}
+
+void SetPaused(bool value)
+{
+  paused = value;
+  Wake();
+}
+
+void Wake()
+{
+  {
+    std::lock_guard<std::mutex> lock(s_wake_mutex);
+    s_woken = true;
+  }
+
+  s_wake.notify_one();
+}
+
+std::any SaveState() { return ExecutionState{s_interrupt_shadow, s_halted}; }
+
+void LoadState(const std::any& state)
+{
+  const auto& saved = std::any_cast<const ExecutionState&>(state);
+
+  s_interrupt_shadow = saved.interrupt_shadow;
+  s_halted = saved.halted;
+}
+
+bool IsHalted() { return s_halted; }
+
+void WaitForInterrupt()
+{
+  // Both INT and TRAP take two bytes
+  IP -= 2;
+  s_halted = true;
+}
 
 bool IsRunning() { return running; }
 bool IsPaused() { return paused; }
@@ -138,17 +245,28 @@ bool HandleRepetition()
   }
 }
 
+// Port of an IN or OUT instruction, an immediate byte or DX
+static u16 GetPort(const Instruction::Parameter& parameter)
+{
+  if (parameter.GetType() == Instruction::Parameter::Type::DX)
+    return DX;
+
+  return parameter.GetData<u8>();
+}
+
 Breakpoint just_hit = {0, 0};
 
-void Tick()
+void SkipCurrentBreakpoint()
 {
-  const auto old_ip = IP;
-  LAST_CS = CS;
-  LAST_IP = IP;
+  just_hit.segment = CS;
+  just_hit.offset = IP;
+}
 
+void Tick()
+{
   if (IsBreakpointHit() && (just_hit.segment != CS || just_hit.offset != IP)) {
-    LOG("Hit a breakpoint at " + String::ToHex(CS) + ":" + String::ToHex(IP) +
-        "!");
+    LOG("Hit a breakpoint at " + String::ToHex<u16>(CS) + ":" +
+        String::ToHex(IP) + "!");
     SetPaused(true);
 
     just_hit.segment = CS;
@@ -160,20 +278,35 @@ void Tick()
   just_hit.segment = 0;
   just_hit.offset = 0;
 
-  u8 opcode = Memory::Get<u8>(CS, IP++);
+  Step();
+}
+
+void Step()
+{
+  const auto old_ip = IP;
+  LAST_CS = CS;
+  LAST_IP = IP;
+
+  Debug::Profiler::Tick();
+
+  instructions++;
+
+  const u32 code = CS.GetBase();
+
+  u8 opcode = Memory::ReadAt<u8>(code + IP++);
   Instruction ins(opcode, old_ip);
 
   if (ins.IsPrefix())
-    ins = Instruction(ins, Memory::Get<u8>(CS, IP++), old_ip);
+    ins = Instruction(ins, Memory::ReadAt<u8>(code + IP++), old_ip);
 
   if (!ins.IsResolved()) {
-    u8 mod = Memory::Get<u8>(CS, IP++);
+    u8 mod = Memory::ReadAt<u8>(code + IP++);
     u8 length = ins.GetLength(mod);
 
     std::vector<u8> data;
 
     for (u32 i = 0; i < length; i++)
-      data.push_back(Memory::Get<u8>(CS, IP++));
+      data.push_back(Memory::ReadAt<u8>(code + IP++));
 
     if (!ins.Resolve(mod, data)) {
       LOG("Failed to resolve " + String::ToHex(opcode) + " with mod " +
@@ -185,8 +318,19 @@ void Tick()
   if (ins.GetType() == Instruction::Type::Invalid)
     throw InvalidInstructionException(opcode);
 
-  // LOG(String::ToHex<u16>(CS) + ":" + String::ToHex<u16>(old_ip) + ": " +
-  //     ins.ToString());
+  Debug::Coverage::Mark(CS, old_ip);
+
+  const auto next_ip = IP;
+  const bool trace_branches =
+      Debug::Trace::active &&
+      Debug::Trace::mode == Debug::Trace::Mode::Branches;
+
+  if (Debug::Trace::active && !trace_branches)
+    Debug::Trace::Add(CS, old_ip, static_cast<u8>(next_ip - old_ip));
+
+  Debug::OpCounters::CountInstruction(ins);
+
+  const u16 old_cx = CX;
 
   using Type = Instruction::Type;
   using PType = Instruction::Parameter::Type;
@@ -209,6 +353,12 @@ void Tick()
   case Type::RET:
     RET(ins);
     break;
+  case Type::RETF:
+    RETF(ins);
+    break;
+  case Type::IRET:
+    IRET(ins);
+    break;
   case Type::CBW:
     // Copy the sign bit into all of AH
     AH = AL & (0b1000'0000) ? 0xFF : 0x00;
@@ -233,6 +383,7 @@ void Tick()
     break;
   case Type::STI:
     IF = true;
+    s_interrupt_shadow = instructions;
     break;
   case Type::CMP: {
     auto& dst = ins.GetParameters()[0];
@@ -288,8 +439,25 @@ void Tick()
     CMPSW(ins);
     break;
   case Type::HLT: {
-    LOG("[STUB] CPU halted, stopping for now...");
-    running = false;
+    // Nothing could ever wake the CPU up again
+    if (!IF) {
+      LOG("CPU halted with interrupts disabled, stopping...");
+      running = false;
+      break;
+    }
+
+    s_halted = true;
+    break;
+  }
+  case Type::IN: {
+    auto& dst = ins.GetParameters()[0];
+    const u16 port = GetPort(ins.GetParameters()[1]);
+
+    if (dst.IsWord())
+      AX = HW::IO::ReadWord(port);
+    else
+      AL = HW::IO::Read(port);
+
     break;
   }
   case Type::INC:
@@ -365,7 +533,7 @@ void Tick()
     JL(ins);
     break;
   case Type::JLE:
-    JL(ins);
+    JLE(ins);
     break;
   case Type::JO:
     JO(ins);
@@ -411,10 +579,13 @@ void Tick()
     if (!dst.IsWord())
       throw UnsupportedParameterException(ins, dst);
 
-    u16& dst16 = ParameterTo<u16&>(dst, ins.GetPrefix());
-    u16& src16 = ParameterTo<u16&>(src, ins.GetPrefix());
+    // Only the offset is loaded, memory isn't accessed
+    EffectiveAddress address;
 
-    dst16 = static_cast<u16>(reinterpret_cast<intptr_t>(&src16) - reinterpret_cast<intptr_t>(Memory::GetPtr<u16>(DS, 0)));
+    if (!ParameterToAddress(src, address))
+      throw UnsupportedParameterException(ins, src);
+
+    ParameterTo<u16&>(dst, ins.GetPrefix()) = address.offset;
 
     break;
   }
@@ -490,7 +661,12 @@ void Tick()
     if (dst.IsWord() != src.IsWord())
       throw ParameterLengthMismatchException(ins, dst, src);
 
-    if (dst.IsWord()) {
+    if (Segment* segment = ParameterToSegment(dst)) {
+      *segment = ParameterTo<u16>(src, ins.GetPrefix());
+
+      if (segment == &SS)
+        s_interrupt_shadow = instructions;
+    } else if (dst.IsWord()) {
       u16& dst16 = ParameterTo<u16&>(dst, ins.GetPrefix());
       u16 src16 = ParameterTo<u16>(src, ins.GetPrefix());
 
@@ -540,6 +716,17 @@ void Tick()
   case Type::OR:
     OR(ins);
     break;
+  case Type::OUT: {
+    auto& src = ins.GetParameters()[1];
+    const u16 port = GetPort(ins.GetParameters()[0]);
+
+    if (src.IsWord())
+      HW::IO::WriteWord(port, AX);
+    else
+      HW::IO::Write(port, AL);
+
+    break;
+  }
   case Type::PUSH: {
     auto& data = ins.GetParameters()[0];
 
@@ -549,34 +736,18 @@ void Tick()
     u16 data16 = ParameterTo<u16>(data, ins.GetPrefix());
 
     SP -= sizeof(u16);
-    Memory::Get<u16>(SS, SP) = data16;
+    Memory::GetAt<u16>(SS.GetBase() + SP) = data16;
 
     break;
   }
   case Type::PUSHF: {
-    u16 eflags = static_cast<u16>(CF) | (1 << 1) | (static_cast<u16>(PF) << 2) |
-                 (static_cast<u16>(AF) << 4) | (static_cast<u16>(ZF) << 6) |
-                 (static_cast<u16>(SF) << 7) | (/*TF*/ 0 << 8) |
-                 (static_cast<u16>(IF) << 9) | (static_cast<u16>(DF) << 10) |
-                 (static_cast<u16>(OF) << 11) | (1 << 14) | (1 << 15);
-
     SP -= sizeof(u16);
-    Memory::Get<u16>(SS, SP) = eflags;
+    Memory::GetAt<u16>(SS.GetBase() + SP) = GetFlags();
 
     break;
   }
   case Type::POPF: {
-    u16 eflags = Memory::Get<u16>(SS, SP);
-
-    CF = eflags & 1;
-    PF = eflags & (1 << 2);
-    AF = eflags & (1 << 4);
-    ZF = eflags & (1 << 6);
-    SF = eflags & (1 << 7);
-    // TF = eflags & (1 << 8);
-    IF = eflags & (1 << 9);
-    DF = eflags & (1 << 10);
-    OF = eflags & (1 << 11);
+    SetFlags(Memory::GetAt<u16>(SS.GetBase() + SP));
 
     SP -= sizeof(u16);
 
@@ -588,9 +759,17 @@ void Tick()
     if (!dst.IsWord())
       throw UnsupportedParameterException(ins, dst);
 
-    u16& dst16 = ParameterTo<u16&>(dst, ins.GetPrefix());
+    const u16 value = Memory::GetAt<u16>(SS.GetBase() + SP);
+
+    if (Segment* segment = ParameterToSegment(dst)) {
+      *segment = value;
+
+      if (segment == &SS)
+        s_interrupt_shadow = instructions;
+    } else {
+      ParameterTo<u16&>(dst, ins.GetPrefix()) = value;
+    }
 
-    dst16 = Memory::Get<u16>(SS, SP);
     SP += sizeof(u16);
 
     break;
@@ -628,6 +807,11 @@ void Tick()
   case Type::TEST:
     TEST(ins);
     break;
+  case Type::TRAP: {
+    auto& parameter = ins.GetParameters()[0];
+    CallTrap(parameter.GetData<u8>());
+    break;
+  }
   case Type::XCHG: {
     auto& dst = ins.GetParameters()[0];
     auto& src = ins.GetParameters()[1];
@@ -654,55 +838,161 @@ void Tick()
     throw UnhandledInstructionException(ins);
   }
 
+  Memory::Commit();
+
+  if (trace_branches)
+    Debug::Trace::AddBranch(ins, next_ip);
+
+  if (s_repeat_mode != RepeatMode::None)
+    Debug::OpCounters::CountRepetitions(ins, old_cx - CX);
+
   s_repeat_mode = RepeatMode::None;
 }
 
+// Accept a hardware interrupt unless the current instruction holds it off.
+// A REP prefix counts as a separate instruction here, but the interrupt must
+// not separate it from its string instruction
+static void HandleEvents()
+{
+  if (!IF || s_interrupt_shadow == instructions ||
+      s_repeat_mode != RepeatMode::None)
+    return;
+
+  if (events & EVENT_INTERRUPT)
+    AcceptInterrupt();
+}
+
+void AcceptInterrupt()
+{
+  const u8 vector = HW::PIC::Acknowledge();
+
+  Debug::Checkpoint::RecordInterrupt(vector);
+
+  s_halted = false;
+  DeliverInterrupt(vector);
+  Debug::Trace::AddInterrupt();
+  Memory::Commit();
+  Debug::Lockstep::Sync();
+}
+
+// Sleep through the time until the next event while halted, or until Wake()
+// signals new input. Without throttling there is no sleep, time skips ahead
+// to the next event unless input is waiting
+static void Idle()
+{
+  if (Scheduler::next == Scheduler::NEVER) {
+    LOG("CPU halted with nothing left to wake it up, stopping...");
+    running = false;
+    return;
+  }
+
+  const u64 pending = Scheduler::next - Scheduler::cycles;
+
+  if (clock_speed == 0) {
+    bool woken;
+
+    {
+      std::lock_guard<std::mutex> lock(s_wake_mutex);
+      woken = s_woken;
+      s_woken = false;
+    }
+
+    // The input gets a look before any time passes
+    if (woken)
+      HW::Keyboard::Update();
+    else
+      Scheduler::Advance(pending);
+
+    return;
+  }
+
+  const std::chrono::nanoseconds duration(pending * 1000000000 /
+                                          clock_speed);
+  const auto start = std::chrono::steady_clock::now();
+
+  bool woken;
+
+  {
+    std::unique_lock<std::mutex> lock(s_wake_mutex);
+    woken = s_wake.wait_for(lock, duration, [] { return s_woken; });
+    s_woken = false;
+  }
+
+  if (!woken) {
+    Scheduler::Advance(pending);
+    return;
+  }
+
+  // Only the time actually slept passes, then the input gets a look
+  const auto slept = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  Scheduler::Advance(std::min<u64>(
+      pending, static_cast<u64>(slept.count()) * clock_speed / 1000000000));
+  HW::Keyboard::Update();
+}
+
 void Start()
 {
   running = true;
   TriggerCallbacks();
-  u8 counter = 0;
 
   if (pause_on_boot)
     paused = true;
 
-  while (running) {
-    if (counter++ == 0)
-      Core::HW::VGA::Update();
+  Debug::Trace::Begin();
+  Debug::CallStack::Begin();
+  Debug::Lockstep::Begin();
 
-    if (paused)
+  s_halted = false;
+
+  while (running) {
+    if (paused) {
+      Debug::OpCounters::Publish();
       TriggerCallbacks();
+    }
 
     while (paused && running) {
     }
 
-    Tick();
+    Debug::Checkpoint::Update();
+    Debug::StateHash::Update();
+    Baseline::Update();
+
+    const u64 executed = instructions;
+
+    try {
+      if (events != 0)
+        HandleEvents();
+
+      if (s_halted)
+        Idle();
+      else if (!Debug::Lockstep::active)
+        Tick();
+      else if (!Debug::Lockstep::Step())
+        running = false;
+    } catch (CPUException&) {
+      // Leave the machine stopped so its state can still be inspected
+      running = false;
+      Debug::OpCounters::Publish();
+      TriggerCallbacks();
+      throw;
+    }
 
-    std::this_thread::sleep_for(
-        std::chrono::nanoseconds(1000000000 / clock_speed));
+    // Lockstep executes whole blocks at once
+    Scheduler::Advance(instructions - executed);
+
+    // Idle() sleeps by itself
+    if (clock_speed != 0)
+      std::this_thread::sleep_for(std::chrono::nanoseconds(
+          (instructions - executed) * 1000000000 / clock_speed));
   }
 
+  Debug::OpCounters::Publish();
   TriggerCallbacks();
 
   // Update the output for the last time before stopping so all output gets
   // shown
   Core::HW::VGA::Update();
 }
-
-u16 PrefixToValue(Instruction::SegmentPrefix prefix)
-{
-  using Prefix = Instruction::SegmentPrefix;
-  switch (prefix) {
-  case Prefix::CS:
-    return CS;
-  case Prefix::ES:
-    return ES;
-  case Prefix::SS:
-    return SS;
-
-  case Prefix::DS:
-  default:
-    return DS;
-  }
-}
 } // namespace Core::CPU
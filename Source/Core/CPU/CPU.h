@@ -5,6 +5,7 @@
 #pragma once
 //! \file
 
+#include <any>
 #include <atomic>
 #include <functional>
 
@@ -22,6 +23,9 @@ namespace Core::CPU
 //! Execute one CPU cycle
 void Tick();
 
+//! Execute exactly one instruction, ignoring breakpoints
+void Step();
+
 //! Execute instructions until shutdown is requested
 void Start();
 
@@ -36,71 +40,130 @@ using StateCallbackFunc = std::function<void(State)>;
 void RegisterStateChangedCallback(StateCallbackFunc fnc);
 void UnregisterStateChangedCallback(StateCallbackFunc fnc);
 
-union GPR {
-  u16 X = 0;
-  struct {
-    u8 L;
-    u8 H;
-  } b8;
+//! Segment register, which also keeps the address its segment starts at.
+//! That address only changes when the register is written, so addressing
+//! memory takes a single add
+class Segment
+{
+public:
+  operator u16() const { return m_value; }
+
+  Segment& operator=(u16 value)
+  {
+    m_value = value;
+    m_base = static_cast<u32>(value) << 4;
+    return *this;
+  }
+
+  //! Absolute address of offset 0
+  u32 GetBase() const { return m_base; }
+
+private:
+  u32 m_base = 0;
+  u16 m_value = 0;
+};
+
+//! All registers instructions operate on, packed into one cache line. They
+//! are ordered like the reg field of a ModRM byte numbers them, so operands
+//! are looked up instead of switched on
+struct alignas(64) Registers {
+  union {
+    //! AX, CX, DX, BX, SP, BP, SI, DI
+    u16 word[8];
+    //! Halves of the words, see GetByteRegister()
+    u8 byte[16];
+  };
+
+  //! ES, CS, SS, DS
+  Segment segment[4];
+
+  u16 ip;
 };
 
-extern GPR A;
-extern GPR B;
-extern GPR C;
-extern GPR D;
+static_assert(sizeof(Registers) == 64, "Registers have to fit a cache line");
+
+extern Registers registers;
+
+//! 16 bit register by ModRM number (AX, CX, DX, BX, SP, BP, SI, DI)
+inline u16& GetWordRegister(u8 index) { return registers.word[index]; }
+
+//! 8 bit register by ModRM number (AL, CL, DL, BL, AH, CH, DH, BH)
+inline u8& GetByteRegister(u8 index)
+{
+  return registers.byte[(index & 0b11) * 2 + (index >> 2)];
+}
+
+//! Segment register by ModRM number (ES, CS, SS, DS)
+inline Segment& GetSegmentRegister(u8 index)
+{
+  return registers.segment[index];
+}
 
 //! AX (Accumulator)
-extern u16& AX;
+inline constexpr u16& AX = registers.word[0];
 //! AH (High)
-extern u8& AH;
+inline constexpr u8& AH = registers.byte[1];
 //! AL (Low)
-extern u8& AL;
+inline constexpr u8& AL = registers.byte[0];
 
 //! BX
-extern u16& BX;
+inline constexpr u16& BX = registers.word[3];
 //! BH (High)
-extern u8& BH;
+inline constexpr u8& BH = registers.byte[7];
 //! BL (Low)
-extern u8& BL;
+inline constexpr u8& BL = registers.byte[6];
 
 //! CX
-extern u16& CX;
+inline constexpr u16& CX = registers.word[1];
 //! CH (High)
-extern u8& CH;
+inline constexpr u8& CH = registers.byte[3];
 //! CL (Low)
-extern u8& CL;
+inline constexpr u8& CL = registers.byte[2];
 
 //! DX
-extern u16& DX;
+inline constexpr u16& DX = registers.word[2];
 //! DH (High)
-extern u8& DH;
+inline constexpr u8& DH = registers.byte[5];
 //! DL (Low)
-extern u8& DL;
+inline constexpr u8& DL = registers.byte[4];
 
 //! Code Segment
-extern u16 CS;
+inline constexpr Segment& CS = registers.segment[1];
 //! Data Segment
-extern u16 DS;
+inline constexpr Segment& DS = registers.segment[3];
 //! Extra(?) Segment
-extern u16 ES;
+inline constexpr Segment& ES = registers.segment[0];
 //! Stack Segment
-extern u16 SS;
+inline constexpr Segment& SS = registers.segment[2];
 
 //! Instruction Pointer
-extern u16 IP;
+inline constexpr u16& IP = registers.ip;
 //! Base Pointer
-extern u16 BP;
+inline constexpr u16& BP = registers.word[5];
 //! Stack Pointer
-extern u16 SP;
+inline constexpr u16& SP = registers.word[4];
 //! Source Index
-extern u16 SI;
+inline constexpr u16& SI = registers.word[6];
 //! Destination Index
-extern u16 DI;
+inline constexpr u16& DI = registers.word[7];
 
 //! Last instruction
 extern u16 LAST_CS;
 extern u16 LAST_IP;
 
+//! Amount of instructions executed since boot
+extern u64 instructions;
+
+//! Events which have to be handled between two instructions
+enum Event : u32 {
+  //! The interrupt controller has a request for the CPU
+  EVENT_INTERRUPT = 1 << 0
+};
+
+//! Pending events (see Event). Devices set and clear these, the CPU only
+//! checks this word between instructions
+extern u32 events;
+
 //! Adjust Flag
 extern bool AF;
 //! Carry Flag
@@ -130,20 +193,219 @@ void Stop();
 
 void SetPaused(bool paused);
 
+//! Cut short the sleep of a halted CPU because there is new input. Safe to
+//! call from any thread
+void Wake();
+
 bool IsRunning();
 bool IsPaused();
 State GetState();
 
+//! Instructions executed per second, 0 runs as fast as possible
 extern u64 clock_speed;
 
-u16 PrefixToValue(Instruction::SegmentPrefix prefix);
+//! Complete register state of the CPU
+struct Context {
+  u16 AX, BX, CX, DX;
+  u16 CS, DS, ES, SS;
+  u16 IP, BP, SP, SI, DI;
+  bool AF, CF, IF, DF, OF, PF, SF, ZF;
+  RepeatMode repeat_mode;
+};
+
+//! Pack the flags into the FLAGS register layout
+u16 GetFlags();
+
+//! Unpack the flags from the FLAGS register layout
+void SetFlags(u16 flags);
+
+//! Capture the current register state
+Context SaveContext();
+
+//! Replace the current register state
+void LoadContext(const Context& context);
+
+//! Copy of what the CPU holds besides the registers, like whether it is
+//! halted and the interrupt shadow (see Debug::Checkpoint)
+std::any SaveState();
+
+//! Go back to a state returned by SaveState()
+void LoadState(const std::any& state);
+
+//! Whether HLT is waiting for an interrupt
+bool IsHalted();
+
+//! Deliver the interrupt pending at the PIC, which ends a halt. Only call
+//! this where Start() would accept one
+void AcceptInterrupt();
+
+//! Notify everyone interested in the machine state (e.g. the debugger)
+void TriggerCallbacks();
+
+//! Segment register selected by a prefix, DS without one
+inline const Segment& PrefixToSegment(Instruction::SegmentPrefix prefix)
+{
+  // Indexed by SegmentPrefix (None, CS, DS, ES, SS)
+  constexpr u8 index[] = {3, 1, 3, 0, 2};
+  return registers.segment[index[static_cast<u8>(prefix)]];
+}
+
+//! Segment register parameter refers to, nullptr if it is none. Segment
+//! registers can't be written through ParameterTo() as their bases have to
+//! be kept up to date
+inline Segment* ParameterToSegment(const Instruction::Parameter& parameter)
+{
+  using PType = Instruction::Parameter::Type;
+  const auto type = parameter.GetType();
+
+  if (type < PType::ES || type > PType::DS)
+    return nullptr;
+
+  return &GetSegmentRegister(static_cast<u8>(type) -
+                             static_cast<u8>(PType::ES));
+}
+
+//! Memory location a parameter refers to
+struct EffectiveAddress {
+  //! Offset within the segment
+  u16 offset;
+  //! Whether it is in the stack segment unless there is a prefix (i.e. it is
+  //! based on BP)
+  bool stack;
+};
+
+//! Memory location parameter refers to, computed from the registers and the
+//! displacement without accessing memory. Returns ``false`` if it isn't in
+//! memory
+inline bool ParameterToAddress(const Instruction::Parameter& parameter,
+                               EffectiveAddress& address)
+{
+  using PType = Instruction::Parameter::Type;
+
+  // Offsets wrap around within the segment
+  switch (parameter.GetType()) {
+  case PType::Value_WordAddress:
+  case PType::Value_WordAddress_Word:
+    address = {parameter.GetData<u16>(), false};
+    return true;
+  case PType::Value_BP_Offset:
+  case PType::Value_BP_Offset_Word:
+    address = {static_cast<u16>(BP + static_cast<i8>(parameter.GetData<u8>())),
+               true};
+    return true;
+  case PType::Value_BP_WordOffset:
+  case PType::Value_BP_WordOffset_Word:
+    address = {static_cast<u16>(BP + parameter.GetData<u16>()), true};
+    return true;
+  case PType::Value_BP_DI:
+  case PType::Value_BP_DI_Word:
+    address = {static_cast<u16>(BP + DI), true};
+    return true;
+  case PType::Value_BP_DI_Offset:
+  case PType::Value_BP_DI_Offset_Word:
+    address = {static_cast<u16>(
+                   BP + DI + static_cast<i8>(parameter.GetData<u8>())),
+               true};
+    return true;
+  case PType::Value_BP_DI_WordOffset:
+  case PType::Value_BP_DI_WordOffset_Word:
+    address = {static_cast<u16>(BP + DI + parameter.GetData<u16>()), true};
+    return true;
+  case PType::Value_BP_SI:
+  case PType::Value_BP_SI_Word:
+    address = {static_cast<u16>(BP + SI), true};
+    return true;
+  case PType::Value_BP_SI_Offset:
+  case PType::Value_BP_SI_Offset_Word:
+    address = {static_cast<u16>(
+                   BP + SI + static_cast<i8>(parameter.GetData<u8>())),
+               true};
+    return true;
+  case PType::Value_BP_SI_WordOffset:
+  case PType::Value_BP_SI_WordOffset_Word:
+    address = {static_cast<u16>(BP + SI + parameter.GetData<u16>()), true};
+    return true;
+  case PType::Value_BX:
+  case PType::Value_BX_Word:
+    address = {BX, false};
+    return true;
+  case PType::Value_BX_Offset:
+  case PType::Value_BX_Offset_Word:
+    address = {static_cast<u16>(BX + static_cast<i8>(parameter.GetData<u8>())),
+               false};
+    return true;
+  case PType::Value_BX_WordOffset:
+  case PType::Value_BX_WordOffset_Word:
+    address = {static_cast<u16>(BX + parameter.GetData<u16>()), false};
+    return true;
+  case PType::Value_BX_SI:
+  case PType::Value_BX_SI_Word:
+    address = {static_cast<u16>(BX + SI), false};
+    return true;
+  case PType::Value_BX_SI_Offset:
+  case PType::Value_BX_SI_Offset_Word:
+    address = {static_cast<u16>(
+                   BX + SI + static_cast<i8>(parameter.GetData<u8>())),
+               false};
+    return true;
+  case PType::Value_BX_SI_WordOffset:
+  case PType::Value_BX_SI_WordOffset_Word:
+    address = {static_cast<u16>(BX + SI + parameter.GetData<u16>()), false};
+    return true;
+  case PType::Value_BX_DI:
+  case PType::Value_BX_DI_Word:
+    address = {static_cast<u16>(BX + DI), false};
+    return true;
+  case PType::Value_BX_DI_Offset:
+  case PType::Value_BX_DI_Offset_Word:
+    address = {static_cast<u16>(
+                   BX + DI + static_cast<i8>(parameter.GetData<u8>())),
+               false};
+    return true;
+  case PType::Value_BX_DI_WordOffset:
+  case PType::Value_BX_DI_WordOffset_Word:
+    address = {static_cast<u16>(BX + DI + parameter.GetData<u16>()), false};
+    return true;
+  case PType::Value_DI:
+  case PType::Value_DI_Word:
+    address = {DI, false};
+    return true;
+  case PType::Value_DI_Offset:
+  case PType::Value_DI_Offset_Word:
+    address = {static_cast<u16>(DI + static_cast<i8>(parameter.GetData<u8>())),
+               false};
+    return true;
+  case PType::Value_DI_WordOffset:
+  case PType::Value_DI_WordOffset_Word:
+    address = {static_cast<u16>(DI + parameter.GetData<u16>()), false};
+    return true;
+  case PType::Value_SI:
+  case PType::Value_SI_Word:
+    address = {SI, false};
+    return true;
+  case PType::Value_SI_Offset:
+  case PType::Value_SI_Offset_Word:
+    address = {static_cast<u16>(SI + static_cast<i8>(parameter.GetData<u8>())),
+               false};
+    return true;
+  case PType::Value_SI_WordOffset:
+  case PType::Value_SI_WordOffset_Word:
+    address = {static_cast<u16>(SI + parameter.GetData<u16>()), false};
+    return true;
+  default:
+    return false;
+  }
+}
 
 //! \cond PRIVATE
 template <class T>
 T ParameterTo(const Instruction::Parameter& parameter,
               Instruction::SegmentPrefix prefix)
 {
-  [[maybe_unused]] u16 seg_val = PrefixToValue(prefix);
+  [[maybe_unused]] const u32 base = PrefixToSegment(prefix).GetBase();
+  // Addresses based on BP are in the stack segment unless there is a prefix
+  [[maybe_unused]] const u32 stack_base =
+      prefix == Instruction::SegmentPrefix::None ? SS.GetBase() : base;
 
   if constexpr (std::is_same<T, i8>::value) {
     return static_cast<i8>(ParameterTo<u8>(parameter, prefix));
@@ -168,178 +430,58 @@ T ParameterTo(const Instruction::Parameter& parameter,
       throw ParameterLengthMismatchException(parameter);
     }
 
-    switch (parameter.GetType()) {
-    case PType::AL:
-      return AL;
-    case PType::AH:
-      return AH;
-
-    case PType::BL:
-      return BL;
-    case PType::BH:
-      return BH;
-
-    case PType::CL:
-      return CL;
-    case PType::CH:
-      return CH;
-
-    case PType::DL:
-      return DL;
-    case PType::DH:
-      return DH;
-
-    case PType::Value_WordAddress:
-      return Memory::Get<u8>(seg_val, parameter.GetData<u16>());
-    case PType::Value_BP_Offset:
-      return Memory::Get<u8>(seg_val, BP + parameter.GetData<u8>());
-    case PType::Value_BP_WordOffset:
-      return Memory::Get<u8>(seg_val, BP + parameter.GetData<u16>());
-    case PType::Value_BP_DI:
-      return Memory::Get<u8>(seg_val, BP + DI);
-    case PType::Value_BP_DI_Offset:
-      return Memory::Get<u8>(seg_val, BP + DI + parameter.GetData<u8>());
-    case PType::Value_BP_DI_WordOffset:
-      return Memory::Get<u8>(seg_val, BP + DI + parameter.GetData<u16>());
-    case PType::Value_BP_SI:
-      return Memory::Get<u8>(seg_val, BP + SI);
-    case PType::Value_BP_SI_Offset:
-      return Memory::Get<u8>(seg_val, BP + SI + parameter.GetData<u8>());
-    case PType::Value_BP_SI_WordOffset:
-      return Memory::Get<u8>(seg_val, BP + SI + parameter.GetData<u16>());
-    case PType::Value_BX:
-      return Memory::Get<u8>(seg_val, BX);
-    case PType::Value_BX_Offset:
-      return Memory::Get<u8>(seg_val, BX + parameter.GetData<u8>());
-    case PType::Value_BX_WordOffset:
-      return Memory::Get<u8>(seg_val, BX + parameter.GetData<u16>());
-    case PType::Value_BX_SI:
-      return Memory::Get<u8>(seg_val, BX + SI);
-    case PType::Value_BX_SI_Offset:
-      return Memory::Get<u8>(seg_val, BX + SI + parameter.GetData<u8>());
-    case PType::Value_BX_SI_WordOffset:
-      return Memory::Get<u8>(seg_val, BX + SI + parameter.GetData<u16>());
-    case PType::Value_BX_DI:
-      return Memory::Get<u8>(seg_val, BX + DI);
-    case PType::Value_BX_DI_Offset:
-      return Memory::Get<u8>(seg_val, BX + DI + parameter.GetData<u8>());
-    case PType::Value_BX_DI_WordOffset:
-      return Memory::Get<u8>(seg_val, BX + DI + parameter.GetData<u16>());
-    case PType::Value_DI:
-      return Memory::Get<u8>(seg_val, DI);
-    case PType::Value_DI_Offset:
-      return Memory::Get<u8>(seg_val, DI + parameter.GetData<u8>());
-    case PType::Value_DI_WordOffset:
-      return Memory::Get<u8>(seg_val, DI + parameter.GetData<u16>());
-    case PType::Value_SI:
-      return Memory::Get<u8>(seg_val, SI);
-    case PType::Value_SI_Offset:
-      return Memory::Get<u8>(seg_val, SI + parameter.GetData<u8>());
-    case PType::Value_SI_WordOffset:
-      return Memory::Get<u8>(seg_val, SI + parameter.GetData<u16>());
-    default:
-      if constexpr (std::is_same<T, u8>::value) {
-        switch (parameter.GetType()) {
-        case PType::Implied_0:
-          return 0;
-        case PType::Implied_1:
-          return 1;
-        case PType::Implied_3:
-          return 3;
-        case PType::Literal_Byte:
-        case PType::Literal_Byte_Immediate:
-          return parameter.GetData<u8>();
-        default:
-          break;
-        }
+    const auto type = parameter.GetType();
+
+    // Registers are ordered the way ModRM numbers them
+    if (type <= PType::BH)
+      return GetByteRegister(static_cast<u8>(type) -
+                             static_cast<u8>(PType::AL));
+
+    if (EffectiveAddress address; ParameterToAddress(parameter, address))
+      return Memory::GetAt<u8>((address.stack ? stack_base : base) +
+                               address.offset);
+
+    if constexpr (std::is_same<T, u8>::value) {
+      switch (type) {
+      case PType::Implied_0:
+        return 0;
+      case PType::Implied_1:
+        return 1;
+      case PType::Implied_3:
+        return 3;
+      case PType::Literal_Byte:
+      case PType::Literal_Byte_Immediate:
+        return parameter.GetData<u8>();
+      default:
+        break;
       }
-
-      LOG("[BYTE] Unknown type: " + ParameterTypeToString(parameter.GetType()));
-      throw UnhandledParameterException(parameter);
     }
+
+    LOG("[BYTE] Unknown type: " + ParameterTypeToString(parameter.GetType()));
+    throw UnhandledParameterException(parameter);
   } else if constexpr (std::is_same<T, u16>::value ||
                        std::is_same<T, u16&>::value) {
     if (!parameter.IsWord())
       throw ParameterLengthMismatchException(parameter);
 
-    switch (parameter.GetType()) {
-    case PType::AX:
-      return AX;
-    case PType::BX:
-      return BX;
-    case PType::CX:
-      return CX;
-    case PType::DX:
-      return DX;
-
-    case PType::CS:
-      return CS;
-    case PType::DS:
-      return DS;
-    case PType::ES:
-      return ES;
-    case PType::SS:
-      return SS;
+    const auto type = parameter.GetType();
 
+    if (type >= PType::AX && type <= PType::DI)
+      return GetWordRegister(static_cast<u8>(type) -
+                             static_cast<u8>(PType::AX));
+
+    if constexpr (std::is_same<T, u16>::value) {
+      if (const Segment* segment = ParameterToSegment(parameter))
+        return *segment;
+    }
+
+    if (EffectiveAddress address; ParameterToAddress(parameter, address))
+      return Memory::GetAt<u16>((address.stack ? stack_base : base) +
+                                address.offset);
+
+    switch (type) {
     case PType::IP:
       return IP;
-    case PType::BP:
-      return BP;
-    case PType::SP:
-      return SP;
-    case PType::SI:
-      return SI;
-    case PType::DI:
-      return DI;
-
-    case PType::Value_WordAddress_Word:
-      return Memory::Get<u16>(seg_val, parameter.GetData<u16>());
-    case PType::Value_DI_Word:
-      return Memory::Get<u16>(seg_val, DI);
-    case PType::Value_DI_Offset_Word:
-      return Memory::Get<u16>(seg_val, DI + parameter.GetData<u8>());
-    case PType::Value_DI_WordOffset_Word:
-      return Memory::Get<u16>(seg_val, DI + parameter.GetData<u16>());
-    case PType::Value_SI_Word:
-      return Memory::Get<u16>(seg_val, SI);
-    case PType::Value_SI_Offset_Word:
-      return Memory::Get<u16>(seg_val, SI + parameter.GetData<u8>());
-    case PType::Value_SI_WordOffset_Word:
-      return Memory::Get<u16>(seg_val, SI + parameter.GetData<u16>());
-    case PType::Value_BP_Offset_Word:
-      return Memory::Get<u16>(seg_val, BP + parameter.GetData<u8>());
-    case PType::Value_BP_WordOffset_Word:
-      return Memory::Get<u16>(seg_val, BP + parameter.GetData<u16>());
-    case PType::Value_BP_DI_Word:
-      return Memory::Get<u16>(seg_val, BP + DI);
-    case PType::Value_BP_DI_Offset_Word:
-      return Memory::Get<u16>(seg_val, BP + DI + parameter.GetData<u8>());
-    case PType::Value_BP_DI_WordOffset_Word:
-      return Memory::Get<u16>(seg_val, BP + DI + parameter.GetData<u16>());
-    case PType::Value_BP_SI_Word:
-      return Memory::Get<u16>(seg_val, BP + SI);
-    case PType::Value_BP_SI_Offset_Word:
-      return Memory::Get<u16>(seg_val, BP + SI + parameter.GetData<u8>());
-    case PType::Value_BP_SI_WordOffset_Word:
-      return Memory::Get<u16>(seg_val, BP + SI + parameter.GetData<u16>());
-    case PType::Value_BX_Word:
-      return Memory::Get<u16>(seg_val, BX);
-    case PType::Value_BX_Offset_Word:
-      return Memory::Get<u16>(seg_val, BX + parameter.GetData<u8>());
-    case PType::Value_BX_WordOffset_Word:
-      return Memory::Get<u16>(seg_val, BX + parameter.GetData<u16>());
-    case PType::Value_BX_DI_Word:
-      return Memory::Get<u16>(seg_val, BX + DI);
-    case PType::Value_BX_DI_Offset_Word:
-      return Memory::Get<u16>(seg_val, BX + DI + parameter.GetData<u8>());
-    case PType::Value_BX_DI_WordOffset_Word:
-      return Memory::Get<u16>(seg_val, BX + DI + parameter.GetData<u16>());
-    case PType::Value_BX_SI_Word:
-      return Memory::Get<u16>(seg_val, BX + SI);
-    case PType::Value_BX_SI_Offset_Word:
-      return Memory::Get<u16>(seg_val, BX + SI + parameter.GetData<u8>());
-    case PType::Value_BX_SI_WordOffset_Word:
-      return Memory::Get<u16>(seg_val, BX + SI + parameter.GetData<u16>());
 
     default:
       if constexpr (std::is_same<T, u16>::value) {
@@ -408,6 +550,8 @@ void JNZ(const Instruction& instruction);
 
 void CALL(const Instruction& instruction);
 void RET(const Instruction& instruction);
+void RETF(const Instruction& instruction);
+void IRET(const Instruction& instruction);
 
 //// Bitwise operations
 void AND(const Instruction& instruction);
@@ -440,7 +584,52 @@ void UpdateSF(i16 value);
 template <typename T> void UpdateOF(i32 value);
 template <typename T> void UpdateCF(i32 value);
 
+//! Native handler of an interrupt vector
+using InterruptHandler = void (*)();
+
+//! Segment of the BIOS ROM, which holds the trap stubs
+constexpr u16 TRAP_SEGMENT = 0xF000;
+//! Offset of the trap stub of vector 0, the stubs of the other vectors follow
+constexpr u16 TRAP_OFFSET = 0x1000;
+constexpr u16 TRAP_SIZE = 8;
+
+//! Where the trap stub of vector is (TRAP_SEGMENT:offset)
+constexpr u16 GetTrapOffset(u8 vector)
+{
+  return static_cast<u16>(TRAP_OFFSET + vector * TRAP_SIZE);
+}
+
+/**@brief Drop all native handlers and point every vector to its trap stub
+ *
+ * A trap stub is STI, a TRAP instruction (F1h, undefined on the 8086) with
+ * the vector and a jump to a shared IRET, which restores the caller's flags
+ * except for CF and ZF, the results the handler returns. TRAP calls the
+ * native handler of its vector.
+ *
+ * INT calls the native handler right away as long as the vector table still
+ * points to the stub and interrupts are enabled (so the stub wouldn't change
+ * any flags). Vectors hooked by the guest are called through the table
+ * instead, and a hook chaining to the previous handler still ends up in
+ * native code.
+ */
+void ResetInterruptHandlers();
+
+//! Handle vector natively
+void SetInterruptHandler(u8 vector, InterruptHandler handler);
+
+//! Execute INT vector
 void CallInterrupt(u8 vector);
-bool CallBIOSInterrupt(u8 vector);
-bool CallMSDOSInterrupt(u8 vector);
+//! Execute a TRAP instruction
+void CallTrap(u8 vector);
+//! Call the handler in the interrupt vector table like a hardware interrupt
+void DeliverInterrupt(u8 vector);
+
+//! Let a native handler wait for something a hardware interrupt brings (like
+//! a key press): The CPU halts and calls the interrupt again after the next
+//! one was handled
+void WaitForInterrupt();
+
+//! Native handlers of the emulated BIOS and MS-DOS
+void SetBIOSInterruptHandlers();
+void SetMSDOSInterruptHandlers();
 } // namespace Core::CPU
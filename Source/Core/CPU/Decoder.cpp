@@ -346,6 +346,8 @@ Core::CPU::Instruction::Instruction(u8 opcode, u32 offset)
     reg_op(0xEF, Type::OUT, Parameter::Type::DX, Parameter::Type::AX);
 
     reg_op(0xF0, Type::LOCK);
+    // Undefined on the 8086 (an alias of LOCK), calls a native handler
+    reg_op(0xF1, Type::TRAP, Parameter::Type::Literal_Byte_Immediate);
     reg_op(0xF2, Type::REPNZ);
     reg_op(0xF3, Type::REPZ);
     reg_op(0xF4, Type::HLT);
@@ -0,0 +1,25 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/CPU/Engine.h"
+
+#include "Core/CPU/CPU.h"
+
+using namespace Core;
+
+// New engines get added here so the lockstep checker and the single step
+// tests pick them up
+static const std::vector<CPU::Engine> s_engines = {{"Interpreter", CPU::Step}};
+
+const std::vector<CPU::Engine>& CPU::GetEngines() { return s_engines; }
+
+const CPU::Engine* CPU::GetEngine(const std::string& name)
+{
+  for (const auto& engine : s_engines) {
+    if (name == engine.name)
+      return &engine;
+  }
+
+  return nullptr;
+}
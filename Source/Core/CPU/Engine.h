@@ -0,0 +1,25 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <string>
+#include <vector>
+
+namespace Core::CPU
+{
+//! A way of executing instructions on the machine state
+struct Engine {
+  const char* name;
+  //! Execute exactly one instruction
+  void (*step)();
+};
+
+//! All available engines, the first one is the reference interpreter
+const std::vector<Engine>& GetEngines();
+
+//! Find an engine by name, returns nullptr if there is none
+const Engine* GetEngine(const std::string& name);
+} // namespace Core::CPU
@@ -1,9 +1,22 @@
 #include "Core/CPU/CPU.h"
 
+#include <array>
+
 using namespace Core;
 
 void CPU::UpdateZF(u16 value) { ZF = (value == 0); }
 
-void CPU::UpdatePF(u16 value) { PF = (value % 2 == 0); }
+// Whether a byte has an even number of set bits
+static constexpr std::array<bool, 256> PARITY = [] {
+  std::array<bool, 256> parity{};
+
+  for (size_t i = 0; i < parity.size(); i++)
+    parity[i] = i == 0 || parity[i >> 1] == ((i & 1) == 0);
+
+  return parity;
+}();
+
+// Parity of the low byte only
+void CPU::UpdatePF(u16 value) { PF = PARITY[value & 0xFF]; }
 
 void CPU::UpdateSF(i16 value) { SF = value < 0; }
@@ -416,6 +416,8 @@ std::string Core::CPU::TypeToString(const Instruction::Type& type)
     return "CWD";
   case Type::CBW:
     return "CBW";
+  case Type::TRAP:
+    return "TRAP";
   case Type::WAIT:
     return "WAIT";
 
@@ -610,74 +612,32 @@ bool Instruction::IsPrefix() const
 static bool ResolveRM8(Instruction::Parameter& param, u8 rm_bits, u8 modrm)
 {
   using PType = Instruction::Parameter::Type;
-  switch (rm_bits) {
-  case 0b000: // AL
-    param.Resolve(PType::AL);
-    break;
-  case 0b001: // CL
-    param.Resolve(PType::CL);
-    break;
-  case 0b010: // DL
-    param.Resolve(PType::DL);
-    break;
-  case 0b011: // BL
-    param.Resolve(PType::BL);
-    break;
-  case 0b100: // AH
-    param.Resolve(PType::AH);
-    break;
-  case 0b101: // CH
-    param.Resolve(PType::CH);
-    break;
-  case 0b110: // DH
-    param.Resolve(PType::DH);
-    break;
-  case 0b111: // BH
-    param.Resolve(PType::BH);
-    break;
-  default:
+
+  if (rm_bits > 0b111) {
     std::cerr << "Don't know how to resolve the RB modifier "
               << String::ToBin(rm_bits) << ": " << String::ToHex(modrm)
               << std::endl;
     return false;
   }
+
+  // AL, CL, DL, BL, AH, CH, DH, BH
+  param.Resolve(static_cast<PType>(static_cast<u8>(PType::AL) + rm_bits));
   return true;
 }
 
 static bool ResolveRM16(Instruction::Parameter& param, u8 rm_bits, u8 modrm)
 {
   using PType = Instruction::Parameter::Type;
-  switch (rm_bits) {
-  case 0b000: // AX
-    param.Resolve(PType::AX);
-    break;
-  case 0b001: // CX
-    param.Resolve(PType::CX);
-    break;
-  case 0b010: // DX
-    param.Resolve(PType::DX);
-    break;
-  case 0b011: // BX
-    param.Resolve(PType::BX);
-    break;
-  case 0b100: // SP
-    param.Resolve(PType::SP);
-    break;
-  case 0b101: // BP
-    param.Resolve(PType::BP);
-    break;
-  case 0b110: // SI
-    param.Resolve(PType::SI);
-    break;
-  case 0b111: // DI
-    param.Resolve(PType::DI);
-    break;
-  default:
+
+  if (rm_bits > 0b111) {
     std::cerr << "Don't know how to resolve the RW modifier "
               << String::ToBin(rm_bits) << ": " << String::ToHex(modrm)
               << std::endl;
     return false;
   }
+
+  // AX, CX, DX, BX, SP, BP, SI, DI
+  param.Resolve(static_cast<PType>(static_cast<u8>(PType::AX) + rm_bits));
   return true;
 }
 
@@ -834,6 +794,14 @@ bool Instruction::Resolve(u8 modrm, std::vector<u8> data)
   if (GetType() == Type::Invalid)
     return false;
 
+  // Immediates follow the displacement of the memory operand
+  size_t displacement = 0;
+
+  if (mod_cmb == 0b00'110 || mod_bits == 0b10'000)
+    displacement = sizeof(u16);
+  else if (mod_bits == 0b01'000)
+    displacement = sizeof(u8);
+
   for (auto& param : m_parameters) {
     if (!param.IsResolved()) {
       switch (param.GetType()) {
@@ -1088,13 +1056,13 @@ bool Instruction::Resolve(u8 modrm, std::vector<u8> data)
         param.Resolve(modrm);
         break;
       case PType::Literal_Word:
-        param.Resolve(*reinterpret_cast<u16*>(data.data()));
+        param.Resolve(*reinterpret_cast<u16*>(data.data() + displacement));
         break;
       case PType::Literal_WordOffset:
         param.Resolve(*reinterpret_cast<u8*>(data.data()) << 8 | modrm);
         break;
       case PType::Literal_Byte:
-        param.Resolve(*reinterpret_cast<u16*>(data.data()));
+        param.Resolve(data[displacement]);
         break;
       case PType::Value_WordAddress:
       case PType::Value_WordAddress_Word:
@@ -1145,6 +1113,22 @@ Instruction::Parameter::Type Instruction::Parameter::GetType() const
 }
 bool Instruction::Parameter::IsResolved() const { return m_resolved; }
 
+bool Instruction::Parameter::IsBasedOnBP() const
+{
+  auto t = m_type;
+  return (
+      t == Type::Value_BP_Offset || t == Type::Value_BP_WordOffset ||
+      t == Type::Value_BP_SI || t == Type::Value_BP_SI_Offset ||
+      t == Type::Value_BP_SI_WordOffset || t == Type::Value_BP_DI ||
+      t == Type::Value_BP_DI_Offset || t == Type::Value_BP_DI_WordOffset ||
+
+      t == Type::Value_BP_Offset_Word || t == Type::Value_BP_WordOffset_Word ||
+      t == Type::Value_BP_SI_Word || t == Type::Value_BP_SI_Offset_Word ||
+      t == Type::Value_BP_SI_WordOffset_Word || t == Type::Value_BP_DI_Word ||
+      t == Type::Value_BP_DI_Offset_Word ||
+      t == Type::Value_BP_DI_WordOffset_Word);
+}
+
 bool Instruction::Parameter::IsWord() const
 {
   auto t = m_type;
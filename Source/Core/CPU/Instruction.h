@@ -151,6 +151,7 @@ public:
     NOP,
     CWD,
     CBW,
+    TRAP,
 
     // Prefixes
     PREFIX_DS,
@@ -177,27 +178,28 @@ public:
     //! Enum to determine the types of parameters
     enum class Type : u8 {
       //! \cond PRIVATE
+      // Registers are ordered the way ModRM numbers them, see Registers
       AL,
-      AH,
-      BL,
-      BH,
       CL,
-      CH,
       DL,
+      BL,
+      AH,
+      CH,
       DH,
+      BH,
       AX,
-      BX,
       CX,
       DX,
-      CS,
-      DS,
+      BX,
+      SP,
+      BP,
+      SI,
+      DI,
       ES,
+      CS,
       SS,
+      DS,
       IP,
-      BP,
-      SP,
-      DI,
-      SI,
 
       Literal_Byte,
       Literal_Byte_Immediate,
@@ -300,6 +302,10 @@ public:
     //! Returns ``true`` if this parameter points to or is a word
     bool IsWord() const;
 
+    //! Returns ``true`` if this parameter addresses memory relative to BP,
+    //! which is in the stack segment by default
+    bool IsBasedOnBP() const;
+
     //! Get a human readable form of this parameter
     std::string ToString(SegmentPrefix prefix = SegmentPrefix::None,
                          u32 offset = 0) const;
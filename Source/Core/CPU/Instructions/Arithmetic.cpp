@@ -15,40 +15,37 @@ void CPU::ADC(const Instruction& ins)
 
   if (dst.IsWord()) {
     u16& dst_16 = ParameterTo<u16&>(dst, ins.GetPrefix());
+    const u16 src_16 = src.IsWord() ? ParameterTo<u16>(src, ins.GetPrefix())
+                                    : ParameterTo<u8>(src, ins.GetPrefix());
 
-    u32 sum = dst_16;
+    const u32 sum = dst_16 + src_16 + CF;
+    const u16 result = sum & 0xFFFF;
 
-    if (src.IsWord())
-      sum += ParameterTo<u16>(src, ins.GetPrefix());
-    else
-      sum += ParameterTo<u8>(src, ins.GetPrefix());
-
-    dst_16 = sum & 0xFFFF;
+    CF = sum & 0x10000;
+    OF = (dst_16 ^ result) & (src_16 ^ result) & 0x8000;
+    AF = (dst_16 ^ src_16 ^ result) & 0x10;
 
-    CF = dst_16 & 0x10000;
-    OF = dst_16 & 0x20000;
+    dst_16 = result;
 
-    sum &= 0b1'1111'1111'1111'1111;
-
-    UpdateSF(static_cast<i16>(sum));
-    UpdateZF(static_cast<i16>(sum));
-    UpdatePF(static_cast<i16>(sum));
+    UpdateSF(static_cast<i16>(result));
+    UpdateZF(result);
+    UpdatePF(result);
   } else {
     u8& dst_8 = ParameterTo<u8&>(dst, ins.GetPrefix());
-    u8 src_8 = ParameterTo<u8>(src, ins.GetPrefix());
+    const u8 src_8 = ParameterTo<u8>(src, ins.GetPrefix());
 
-    u16 sum = dst_8 + src_8;
+    const u16 sum = dst_8 + src_8 + CF;
+    const u8 result = sum & 0xFF;
 
     CF = sum & 0x100;
-    OF = sum & 0x200;
-
-    dst_8 = sum & 0xFF;
+    OF = (dst_8 ^ result) & (src_8 ^ result) & 0x80;
+    AF = (dst_8 ^ src_8 ^ result) & 0x10;
 
-    sum &= 0b1'1111'1111;
+    dst_8 = result;
 
-    UpdateSF(sum);
-    UpdateZF(sum);
-    UpdatePF(sum);
+    UpdateSF(static_cast<i8>(result));
+    UpdateZF(result);
+    UpdatePF(result);
   }
 }
 
@@ -173,40 +170,38 @@ void CPU::SBB(const Instruction& ins)
 
   if (dst.IsWord()) {
     u16& dst_16 = ParameterTo<u16&>(dst, ins.GetPrefix());
+    const u16 src_16 = src.IsWord() ? ParameterTo<u16>(src, ins.GetPrefix())
+                                    : ParameterTo<u8>(src, ins.GetPrefix());
 
-    u32 sum = dst_16;
+    // Borrows show up as bits above the word
+    const u32 difference = dst_16 - src_16 - CF;
+    const u16 result = difference & 0xFFFF;
 
-    if (src.IsWord())
-      sum -= ParameterTo<u16>(src, ins.GetPrefix());
-    else
-      sum -= ParameterTo<u8>(src, ins.GetPrefix());
-
-    dst_16 = sum & 0xFFFF;
-
-    CF = dst_16 & 0x10000;
-    OF = dst_16 & 0x20000;
+    CF = difference & 0x10000;
+    OF = (dst_16 ^ src_16) & (dst_16 ^ result) & 0x8000;
+    AF = (dst_16 ^ src_16 ^ result) & 0x10;
 
-    sum &= 0b1111'1111'1111'1111;
+    dst_16 = result;
 
-    UpdateSF(static_cast<i16>(sum));
-    UpdateZF(static_cast<i16>(sum));
-    UpdatePF(static_cast<i16>(sum));
+    UpdateSF(static_cast<i16>(result));
+    UpdateZF(result);
+    UpdatePF(result);
   } else {
     u8& dst_8 = ParameterTo<u8&>(dst, ins.GetPrefix());
-    u8 src_8 = ParameterTo<u8>(src, ins.GetPrefix());
+    const u8 src_8 = ParameterTo<u8>(src, ins.GetPrefix());
 
-    u16 sum = dst_8 - src_8;
-
-    CF = sum & 0x100;
-    OF = sum & 0x200;
+    const u16 difference = dst_8 - src_8 - CF;
+    const u8 result = difference & 0xFF;
 
-    dst_8 = sum & 0xFF;
+    CF = difference & 0x100;
+    OF = (dst_8 ^ src_8) & (dst_8 ^ result) & 0x80;
+    AF = (dst_8 ^ src_8 ^ result) & 0x10;
 
-    sum &= 0b1111'1111;
+    dst_8 = result;
 
-    UpdateSF(static_cast<i8>(sum));
-    UpdateZF(static_cast<i8>(sum));
-    UpdatePF(static_cast<i8>(sum));
+    UpdateSF(static_cast<i8>(result));
+    UpdateZF(result);
+    UpdatePF(result);
   }
 }
 
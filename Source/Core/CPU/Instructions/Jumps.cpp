@@ -9,6 +9,7 @@
 #include "Common/Swap.h"
 
 #include "Core/CPU/Exception.h"
+#include "Core/Debug/CallStack.h"
 
 using namespace Core;
 
@@ -151,17 +152,21 @@ void CPU::CALL(const Instruction& instruction)
 
   if (parameter.GetType() ==
       Instruction::Parameter::Type::Literal_LongAddress_Immediate) {
-    u32 addr = parameter.GetData<u32>();
-
-    u16 offset = static_cast<u16>((addr & 0xFFFF0000) >> 8);
-    u16 segment = (addr & 0xFFFF);
+    u32 address = parameter.GetData<u32>();
 
     SP -= sizeof(u16);
-    Memory::Get<u16>(SS, SP) = IP;
+    Memory::GetAt<u16>(SS.GetBase() + SP) = CS;
+    SP -= sizeof(u16);
+    Memory::GetAt<u16>(SS.GetBase() + SP) = IP;
 
-    CS = segment;
-    IP = offset;
+    const u16 return_segment = CS;
+    const u16 return_offset = IP;
+
+    IP = Swap(static_cast<u16>((address & 0xFFFF0000) >> 16));
+    CS = Swap(static_cast<u16>(address & 0x0000FFFF));
 
+    Debug::CallStack::Call(Debug::CallStack::Kind::Far, return_segment,
+                           return_offset);
     return;
   }
 
@@ -171,14 +176,49 @@ void CPU::CALL(const Instruction& instruction)
   u16 offset = ParameterTo<u16>(parameter, instruction.GetPrefix());
 
   SP -= sizeof(u16);
-  Memory::Get<u16>(SS, SP) = IP;
+  Memory::GetAt<u16>(SS.GetBase() + SP) = IP;
+
+  const u16 return_offset = IP;
 
   IP += offset;
+
+  Debug::CallStack::Call(Debug::CallStack::Kind::Near, CS, return_offset);
+}
+
+void CPU::RET(const Instruction& instruction)
+{
+  IP = Memory::GetAt<u16>(SS.GetBase() + SP);
+
+  SP += sizeof(u16);
+
+  // RET imm16 also releases the callers parameters
+  if (!instruction.GetParameters().empty())
+    SP += instruction.GetParameters()[0].GetData<u16>();
+
+  Debug::CallStack::Return();
 }
 
-void CPU::RET(const Instruction&)
+void CPU::RETF(const Instruction& instruction)
 {
-  IP = Memory::Get<u16>(SS, SP);
+  IP = Memory::GetAt<u16>(SS.GetBase() + SP);
+  SP += sizeof(u16);
+  CS = Memory::GetAt<u16>(SS.GetBase() + SP);
+  SP += sizeof(u16);
+
+  if (!instruction.GetParameters().empty())
+    SP += instruction.GetParameters()[0].GetData<u16>();
 
+  Debug::CallStack::Return();
+}
+
+void CPU::IRET(const Instruction&)
+{
+  IP = Memory::GetAt<u16>(SS.GetBase() + SP);
   SP += sizeof(u16);
+  CS = Memory::GetAt<u16>(SS.GetBase() + SP);
+  SP += sizeof(u16);
+  SetFlags(Memory::GetAt<u16>(SS.GetBase() + SP));
+  SP += sizeof(u16);
+
+  Debug::CallStack::Return();
 }
@@ -9,7 +9,7 @@ using namespace Core;
 void CPU::STOSB(const Instruction&)
 {
   do {
-    Memory::Get<u8>(ES, DI) = AL;
+    Memory::GetAt<u8>(ES.GetBase() + DI) = AL;
 
     DI += (DF ? -1 : 1) * static_cast<int>(sizeof(u8));
   } while (HandleRepetition());
@@ -18,7 +18,7 @@ void CPU::STOSB(const Instruction&)
 void CPU::STOSW(const Instruction&)
 {
   do {
-    Memory::Get<u16>(ES, DI) = AX;
+    Memory::GetAt<u16>(ES.GetBase() + DI) = AX;
 
     DI += (DF ? -1 : 1) * static_cast<int>(sizeof(u16));
   } while (HandleRepetition());
@@ -27,8 +27,8 @@ void CPU::STOSW(const Instruction&)
 void CPU::CMPSB(const Instruction&)
 {
   do {
-    u8 dst = Memory::Get<u8>(DS, SI);
-    u8 src = Memory::Get<u8>(ES, DI);
+    u8 dst = Memory::GetAt<u8>(DS.GetBase() + SI);
+    u8 src = Memory::GetAt<u8>(ES.GetBase() + DI);
     u8 cmp = dst - src;
 
     // LOG("Comparing " + String::ToHex(dst) + " (" + String::ToHex(DS) + ":"
@@ -50,8 +50,8 @@ void CPU::CMPSB(const Instruction&)
 void CPU::CMPSW(const Instruction&)
 {
   do {
-    u16 dst = Memory::Get<u16>(DS, SI);
-    u16 src = Memory::Get<u16>(ES, DI);
+    u16 dst = Memory::GetAt<u16>(DS.GetBase() + SI);
+    u16 src = Memory::GetAt<u16>(ES.GetBase() + DI);
     u16 cmp = dst - src;
 
     // LOG("Comparing " + String::ToHex(dst) + " (" + String::ToHex(DS) + ":"
@@ -73,7 +73,7 @@ void CPU::CMPSW(const Instruction&)
 void CPU::LODSB(const Instruction&)
 {
   do {
-    AL = Memory::Get<u8>(DS, SI);
+    AL = Memory::GetAt<u8>(DS.GetBase() + SI);
 
     SI += (DF ? -1 : 1) * static_cast<int>(sizeof(u8));
   } while (HandleRepetition());
@@ -82,7 +82,7 @@ void CPU::LODSB(const Instruction&)
 void CPU::LODSW(const Instruction&)
 {
   do {
-    AX = Memory::Get<u16>(DS, SI);
+    AX = Memory::GetAt<u16>(DS.GetBase() + SI);
 
     SI += (DF ? -1 : 1) * static_cast<int>(sizeof(u16));
   } while (HandleRepetition());
@@ -90,9 +90,11 @@ void CPU::LODSW(const Instruction&)
 
 void CPU::MOVSB(const Instruction& ins)
 {
+  const u32 source = PrefixToSegment(ins.GetPrefix()).GetBase();
+
   do {
-    u8& dst = Memory::Get<u8>(ES, DI);
-    u8 src = Memory::Get<u8>(PrefixToValue(ins.GetPrefix()), SI);
+    u8& dst = Memory::GetAt<u8>(ES.GetBase() + DI);
+    u8 src = Memory::GetAt<u8>(source + SI);
 
     dst = src;
 
@@ -103,9 +105,11 @@ void CPU::MOVSB(const Instruction& ins)
 
 void CPU::MOVSW(const Instruction& ins)
 {
+  const u32 source = PrefixToSegment(ins.GetPrefix()).GetBase();
+
   do {
-    u16& dst = Memory::Get<u16>(ES, DI);
-    u16 src = Memory::Get<u16>(PrefixToValue(ins.GetPrefix()), SI);
+    u16& dst = Memory::GetAt<u16>(ES.GetBase() + DI);
+    u16 src = Memory::GetAt<u16>(source + SI);
 
     dst = src;
 
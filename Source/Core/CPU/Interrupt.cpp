@@ -4,23 +4,87 @@
 
 #include "Core/CPU/CPU.h"
 
+#include <array>
+
 #include "Common/Logger.h"
 #include "Common/String.h"
 
 #include "Core/CPU/Exception.h"
+#include "Core/Debug/CallStack.h"
+#include "Core/Debug/OpCounters.h"
 
 using namespace Core;
 
+static std::array<CPU::InterruptHandler, 256> s_handlers;
+
+static u32 GetVectorAddress(u8 vector) { return vector * 4u; }
+
+static void CallHandler(u8 vector)
+{
+  Debug::OpCounters::CountInterrupt(vector, CPU::AH);
+
+  if (!s_handlers[vector]) {
+    LOG("Unhandled interrupt vector " + String::ToHex(vector));
+    throw CPU::UnhandledInterruptException();
+  }
+
+  s_handlers[vector]();
+}
+
+void CPU::ResetInterruptHandlers()
+{
+  s_handlers = {};
+
+  for (u16 vector = 0; vector < 256; vector++) {
+    const u32 address = GetVectorAddress(static_cast<u8>(vector));
+
+    Memory::GetAt<u16>(address) = GetTrapOffset(static_cast<u8>(vector));
+    Memory::GetAt<u16>(address + 2) = TRAP_SEGMENT;
+  }
+}
+
+void CPU::SetInterruptHandler(u8 vector, InterruptHandler handler)
+{
+  s_handlers[vector] = handler;
+}
+
 void CPU::CallInterrupt(u8 vector)
 {
-  // TODO: Our Handlers / Software Handlers
-  // TODO: Actually emulate / use interrupt lookups
+  const u32 address = GetVectorAddress(vector);
 
-  if (CallMSDOSInterrupt(vector))
-    return;
-  if (CallBIOSInterrupt(vector))
+  // With interrupts enabled the stub would only call the native handler.
+  // Otherwise it has to run: A handler waiting for an interrupt needs them
+  // enabled until it gets called again, only the stub's IRET disables them
+  // afterwards
+  if (IF && Memory::GetAt<u16>(address) == GetTrapOffset(vector) &&
+      Memory::GetAt<u16>(address + 2) == TRAP_SEGMENT) {
+    CallHandler(vector);
     return;
+  }
+
+  DeliverInterrupt(vector);
+}
+
+void CPU::CallTrap(u8 vector) { CallHandler(vector); }
+
+void CPU::DeliverInterrupt(u8 vector)
+{
+  const u16 return_segment = CS;
+  const u16 return_offset = IP;
+  const u32 address = GetVectorAddress(vector);
+
+  SP -= sizeof(u16);
+  Memory::GetAt<u16>(SS.GetBase() + SP) = GetFlags();
+  SP -= sizeof(u16);
+  Memory::GetAt<u16>(SS.GetBase() + SP) = CS;
+  SP -= sizeof(u16);
+  Memory::GetAt<u16>(SS.GetBase() + SP) = IP;
+
+  IF = false;
+
+  IP = Memory::GetAt<u16>(address);
+  CS = Memory::GetAt<u16>(address + 2);
 
-  LOG("Unhandled interrupt vector " + String::ToHex(vector));
-  throw UnhandledInterruptException();
+  Debug::CallStack::Call(Debug::CallStack::Kind::Interrupt, return_segment,
+                         return_offset);
 }
@@ -4,19 +4,176 @@
 
 #include "Core/Core.h"
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
 #include "Common/Logger.h"
 
+#include "Core/Baseline.h"
 #include "Core/CPU/CPU.h"
+#include "Core/Debug/CallStack.h"
+#include "Core/Debug/Checkpoint.h"
+#include "Core/Debug/OpCounters.h"
+#include "Core/Debug/Profiler.h"
 #include "Core/HW/FloppyDrive.h"
+#include "Core/HW/IO.h"
+#include "Core/HW/Keyboard.h"
+#include "Core/HW/PIC.h"
+#include "Core/HW/PIT.h"
 #include "Core/HW/VGA.h"
+#include "Core/MSDOS/EMS.h"
+#include "Core/MSDOS/XMS.h"
+#include "Core/Memory.h"
+#include "Core/Scheduler.h"
 #include "Core/TTY.h"
 
 namespace Core
 {
+MemoryConfig memory_config;
+
+// Physical address and size of the BIOS ROM
+constexpr u32 BIOS_ROM = 0xF0000;
+constexpr u32 BIOS_ROM_SIZE = 0x10000;
+
+// Handlers of the hardware interrupts in the ROM (F000:offset)
+constexpr u16 TIMER_HANDLER = 0x0030;
+constexpr u16 IRQ_HANDLER = 0x0040;
+constexpr u16 KEYBOARD_HANDLER = 0x0050;
+
+// Segment COM programs get loaded to. The vector table at segment 0 has to
+// stay intact now that interrupts go through it
+constexpr u16 COM_SEGMENT = 0x0800;
+
+// Vector of IRQ 0
+constexpr u8 IRQ_BASE = 0x08;
+
+// The native BIOS tick (TRAP 08h), the user hook (INT 1Ch), EOI and IRET
+constexpr u8 TIMER_STUB[] = {0xF1, 0x08, 0xCD, 0x1C, 0x50, 0xB0,
+                             0x20, 0xE6, 0x20, 0x58, 0xCF};
+
+// PUSH AX, MOV AL,20h, OUT 20h,AL, POP AX, IRET
+constexpr u8 IRQ_STUB[] = {0x50, 0xB0, 0x20, 0xE6, 0x20, 0x58, 0xCF};
+
+// The native BIOS keyboard handler (TRAP 09h), EOI and IRET
+constexpr u8 KEYBOARD_STUB[] = {0xF1, 0x09, 0x50, 0xB0, 0x20,
+                                0xE6, 0x20, 0x58, 0xCF};
+
+// Where the trap stubs return through (F000:offset)
+constexpr u16 TRAP_RETURN = 0x0060;
+
+// IRET, but with CF and ZF of the native handler: PUSH BP, MOV BP,SP,
+// PUSH AX, PUSHF, POP AX, AND AL,41h, AND BYTE [BP+6],BEh, OR [BP+6],AL,
+// POP AX, POP BP, IRET
+constexpr u8 TRAP_RETURN_STUB[] = {0x55, 0x89, 0xE5, 0x50, 0x9C, 0x58,
+                                   0x24, 0x41, 0x80, 0x66, 0x06, 0xBE,
+                                   0x08, 0x46, 0x06, 0x58, 0x5D, 0xCF};
+
+static void InitROM()
+{
+  // The BIOS itself is emulated, its ROM only identifies the machine (the
+  // model byte at F000:FFFE, 0xFF is the original PC)
+  std::vector<u8> rom(BIOS_ROM_SIZE);
+  rom[0xFFFE] = 0xFF;
+
+  // The drivers are emulated too, programs only look for their traces
+  if (MSDOS::EMS::IsPresent())
+    std::copy(std::begin(MSDOS::EMS::NAME), std::end(MSDOS::EMS::NAME),
+              rom.begin() + 0x000A);
+
+  rom[MSDOS::XMS::ENTRY_OFFSET] = 0xF1; // TRAP
+  rom[MSDOS::XMS::ENTRY_OFFSET + 1] = MSDOS::XMS::VECTOR;
+  rom[MSDOS::XMS::ENTRY_OFFSET + 2] = 0xCB; // RETF
+
+  // STI, TRAP vector, JMP TRAP_RETURN
+  for (u16 i = 0; i < 256; i++) {
+    const u8 vector = static_cast<u8>(i);
+    const u16 jump = static_cast<u16>(
+        TRAP_RETURN - (CPU::GetTrapOffset(vector) + 6));
+    const u8 stub[] = {0xFB, 0xF1, vector, 0xE9, static_cast<u8>(jump),
+                       static_cast<u8>(jump >> 8)};
+
+    std::copy(std::begin(stub), std::end(stub),
+              rom.begin() + CPU::GetTrapOffset(vector));
+  }
+
+  std::copy(std::begin(TIMER_STUB), std::end(TIMER_STUB),
+            rom.begin() + TIMER_HANDLER);
+  std::copy(std::begin(IRQ_STUB), std::end(IRQ_STUB),
+            rom.begin() + IRQ_HANDLER);
+  std::copy(std::begin(KEYBOARD_STUB), std::end(KEYBOARD_STUB),
+            rom.begin() + KEYBOARD_HANDLER);
+  std::copy(std::begin(TRAP_RETURN_STUB), std::end(TRAP_RETURN_STUB),
+            rom.begin() + TRAP_RETURN);
+
+  Memory::MapROM(BIOS_ROM, rom.data(), BIOS_ROM_SIZE);
+}
+
+static void InitInterrupts()
+{
+  CPU::ResetInterruptHandlers();
+  CPU::SetBIOSInterruptHandlers();
+  CPU::SetMSDOSInterruptHandlers();
+
+  // Hardware interrupts go to the stubs acknowledging them, only the timer
+  // tick and the keyboard do more than that
+  for (u8 irq = 0; irq < 8; irq++) {
+    const u16 vector = static_cast<u16>((IRQ_BASE + irq) * 4);
+
+    u16 handler = IRQ_HANDLER;
+
+    if (irq == 0)
+      handler = TIMER_HANDLER;
+    else if (irq == 1)
+      handler = KEYBOARD_HANDLER;
+
+    Memory::Get<u16>(0x0000, vector) = handler;
+    Memory::Get<u16>(0x0000, vector + 2) = 0xF000;
+  }
+}
+
+static void InitMemory()
+{
+  // Both drivers hand out whole EMS pages of the extra memory
+  const auto round = [](u32 size) {
+    return (size + Memory::EXTRA_PAGE_SIZE - 1) / Memory::EXTRA_PAGE_SIZE *
+           Memory::EXTRA_PAGE_SIZE;
+  };
+
+  const u32 conventional =
+      memory_config.conventional / Memory::PAGE_SIZE * Memory::PAGE_SIZE;
+  const u32 expanded = round(memory_config.expanded);
+  const u32 extended = round(memory_config.extended);
+
+  Memory::Reset(conventional, expanded + extended);
+
+  // Conventional memory in KiB in the BIOS data area
+  Memory::Get<u16>(0x0040, 0x0013) =
+      static_cast<u16>(Memory::GetConventionalSize() / 1024);
+
+  MSDOS::EMS::Init(0, expanded);
+  MSDOS::XMS::Init(expanded, extended);
+}
+
 void Init()
 {
+  Scheduler::Reset();
+  InitMemory();
+  InitROM();
+  InitInterrupts();
+  HW::IO::Reset();
+  HW::PIC::Init();
+  HW::PIT::Init();
+  HW::Keyboard::Init();
   HW::VGA::Init();
   TTY::Clear();
+  TTY::ClearInput();
+
+  CPU::instructions = 0;
+  Debug::CallStack::Clear();
+  Debug::Checkpoint::Clear();
+  Debug::OpCounters::Clear();
+  Debug::Profiler::Clear();
 }
 
 bool BootFloppy()
@@ -27,6 +184,17 @@ bool BootFloppy()
 
   CPU::CS = 0;
   CPU::IP = 0x7C00;
+  CPU::IF = true;
+
+  CPU::Start();
+
+  return true;
+}
+
+bool BootBaseline(const std::string& path)
+{
+  if (!Baseline::Load(path))
+    return false;
 
   CPU::Start();
 
@@ -46,26 +214,35 @@ bool BootCOM(const std::string& file, const std::string&& parameters)
   if (!ifs.good())
     return false;
 
-  CPU::DS = 0;
+  CPU::CS = COM_SEGMENT;
+  CPU::DS = COM_SEGMENT;
+  CPU::ES = COM_SEGMENT;
+  CPU::SS = COM_SEGMENT;
   CPU::IP = 0x100;
+  CPU::SP = 0xFFFE;
+  CPU::IF = true;
   CPU::simulate_msdos = true;
 
+  // Returning from the program runs INT 20h at the start of the PSP
+  Memory::Get<u16>(COM_SEGMENT, 0x0000) = 0x20CD;
+  Memory::Get<u16>(COM_SEGMENT, 0xFFFE) = 0x0000;
+
   size_t index;
   for (index = 0; !ifs.eof(); index++) {
-    Memory::Get<u8>(0x0000, static_cast<u16>(0x0100 + index)) =
+    Memory::Get<u8>(COM_SEGMENT, static_cast<u16>(0x0100 + index)) =
         static_cast<u8>(ifs.get());
   }
 
   LOG("Loaded " + std::to_string(index - 1) + " bytes into memory");
 
-  Memory::Get<u8>(0x0000, 0x0080) = static_cast<u8>(parameters.size());
+  Memory::Get<u8>(COM_SEGMENT, 0x0080) = static_cast<u8>(parameters.size());
 
   u16 offset;
 
   for (offset = 0x0081; offset < parameters.length(); offset++)
-    Memory::Get<char>(0x0000, offset) = parameters[offset - 0x0081];
+    Memory::Get<char>(COM_SEGMENT, offset) = parameters[offset - 0x0081];
 
-  Memory::Get<char>(0x0000, offset) = '\0';
+  Memory::Get<char>(COM_SEGMENT, offset) = '\0';
 
   LOG("Command line parameters are \"" + parameters + "\"");
 
@@ -7,9 +7,23 @@
 
 #include <string>
 
+#include "Common/Types.h"
+
 //! Representation of a PC
 namespace Core
 {
+//! Memory of the machine, changes take effect on the next Init()
+struct MemoryConfig {
+  //! Conventional memory (up to 640 KiB)
+  u32 conventional = 640 * 1024;
+  //! Expanded memory handed out by the EMS driver, none disables it
+  u32 expanded = 0;
+  //! Extended memory handed out by the XMS driver, none disables it
+  u32 extended = 0;
+};
+
+extern MemoryConfig memory_config;
+
 void Init();
 
 //! Boot the machine from the floppy drive
@@ -21,6 +35,9 @@ void Stop();
 //! Pause the machine (Or unpause it if it's paused already)
 void Pause();
 
+//! Continue from a baseline (see Baseline)
+bool BootBaseline(const std::string& path);
+
 //! Directly execute a COM file
 bool BootCOM(const std::string& file, const std::string&& parameters = "");
 } // namespace Core::Machine
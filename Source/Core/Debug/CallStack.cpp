@@ -0,0 +1,178 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Debug/CallStack.h"
+
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+#include "Common/Logger.h"
+#include "Common/String.h"
+
+#include "Core/CPU/CPU.h"
+
+using namespace Core;
+using namespace Core::Debug::CallStack;
+
+namespace
+{
+struct Cost {
+  u64 calls = 0;
+  u64 inclusive = 0;
+  u64 exclusive = 0;
+};
+
+struct Profile {
+  //! Keyed by segment << 16 | offset of the entry point
+  std::unordered_map<u32, Cost> functions;
+  //! Keyed by caller and callee
+  std::map<std::pair<u32, u32>, Cost> calls;
+};
+} // namespace
+
+// Deeper stacks are almost certainly runaway recursion or a stack switch we
+// failed to notice
+static constexpr size_t MAX_DEPTH = 0x1000;
+
+static std::vector<Frame> s_frames;
+static Frame s_root;
+static bool s_has_root;
+static Profile s_profile;
+
+static u32 ToKey(const Frame& frame)
+{
+  return static_cast<u32>(frame.segment) << 16 | frame.offset;
+}
+
+static std::string ToName(u32 key)
+{
+  return String::ToHex(static_cast<u16>(key >> 16)) + ":" +
+         String::ToHex(static_cast<u16>(key & 0xFFFF));
+}
+
+// Pop the innermost frame and add its costs to profile
+static void Pop(Profile& profile, std::vector<Frame>& frames, Frame& root,
+                u64 now)
+{
+  const auto frame = frames.back();
+  frames.pop_back();
+
+  auto& parent = frames.empty() ? root : frames.back();
+
+  const u64 inclusive = now - frame.start;
+
+  auto& function = profile.functions[ToKey(frame)];
+  function.calls++;
+  function.inclusive += inclusive;
+  function.exclusive += inclusive - frame.children;
+
+  auto& call = profile.calls[{ToKey(parent), ToKey(frame)}];
+  call.calls++;
+  call.inclusive += inclusive;
+
+  parent.children += inclusive;
+}
+
+void Debug::CallStack::Begin()
+{
+  if (s_has_root)
+    return;
+
+  s_root = {CPU::CS, CPU::IP, 0, 0, CPU::SS, CPU::SP, Kind::Far,
+            CPU::instructions, 0};
+  s_has_root = true;
+}
+
+void Debug::CallStack::Call(Kind kind, u16 return_segment, u16 return_offset)
+{
+  if (s_frames.size() == MAX_DEPTH) {
+    WARN("Call stack too deep, discarding it");
+    s_frames.clear();
+  }
+
+  s_frames.push_back({CPU::CS, CPU::IP, return_segment, return_offset,
+                      CPU::SS, CPU::SP, kind, CPU::instructions, 0});
+}
+
+void Debug::CallStack::Return()
+{
+  const size_t depth = s_frames.size();
+
+  // The return address has been popped, so every frame pushed below the
+  // current stack pointer is gone
+  while (!s_frames.empty() && s_frames.back().ss == CPU::SS &&
+         s_frames.back().sp < CPU::SP)
+    Pop(s_profile, s_frames, s_root, CPU::instructions);
+
+  if (s_frames.size() != depth || s_frames.empty())
+    return;
+
+  // The stack got switched, fall back to the return address
+  const auto& frame = s_frames.back();
+
+  if (frame.return_segment == CPU::CS && frame.return_offset == CPU::IP)
+    Pop(s_profile, s_frames, s_root, CPU::instructions);
+}
+
+const Frame& Debug::CallStack::GetRoot() { return s_root; }
+
+const std::vector<Frame>& Debug::CallStack::GetFrames() { return s_frames; }
+
+void Debug::CallStack::SetFrames(const std::vector<Frame>& frames)
+{
+  s_frames = frames;
+}
+
+void Debug::CallStack::Clear()
+{
+  s_frames.clear();
+  s_has_root = false;
+  s_profile = Profile();
+}
+
+bool Debug::CallStack::WriteCallgrind(const std::string& path)
+{
+  std::ofstream ofs(path);
+
+  if (!ofs.good()) {
+    ERROR("Failed to open callgrind file " + path);
+    return false;
+  }
+
+  // Functions that haven't returned yet count up to now
+  Profile profile = s_profile;
+  std::vector<Frame> frames = s_frames;
+  Frame root = s_root;
+
+  while (!frames.empty())
+    Pop(profile, frames, root, CPU::instructions);
+
+  const u64 total = CPU::instructions - root.start;
+
+  auto& main = profile.functions[ToKey(root)];
+  main.calls++;
+  main.inclusive += total;
+  main.exclusive += total - root.children;
+
+  ofs << "# callgrind format" << std::endl
+      << "version: 1" << std::endl
+      << "creator: Ape" << std::endl
+      << "events: Instructions" << std::endl
+      << "summary: " << total << std::endl;
+
+  for (const auto& [key, cost] : profile.functions) {
+    ofs << std::endl << "fn=" << ToName(key) << std::endl;
+    ofs << "0 " << cost.exclusive << std::endl;
+
+    for (auto it = profile.calls.lower_bound({key, 0});
+         it != profile.calls.end() && it->first.first == key; ++it) {
+      ofs << "cfn=" << ToName(it->first.second) << std::endl
+          << "calls=" << it->second.calls << " 0" << std::endl
+          << "0 " << it->second.inclusive << std::endl;
+    }
+  }
+
+  return true;
+}
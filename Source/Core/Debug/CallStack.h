@@ -0,0 +1,66 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <string>
+#include <vector>
+
+#include "Common/Types.h"
+
+/**@brief Shadow call stack of the guest
+ *
+ * Frames are pushed by CALL and interrupts and popped by RET, RETF and IRET.
+ * Guests don't always return the way they were called, so returning unwinds
+ * every frame whose return address lives below the new stack pointer.
+ *
+ * Popping a frame adds its inclusive and exclusive instruction counts to the
+ * profile of the function it belongs to.
+ */
+namespace Core::Debug::CallStack
+{
+enum class Kind : u8 { Near, Far, Interrupt };
+
+struct Frame {
+  //! Entry point of the function
+  u16 segment;
+  u16 offset;
+  //! Where execution continues after returning
+  u16 return_segment;
+  u16 return_offset;
+  //! SS:SP right after the call
+  u16 ss;
+  u16 sp;
+  Kind kind;
+  //! Value of CPU::instructions when the function got called
+  u64 start;
+  //! Instructions spent in functions called by this one
+  u64 children;
+};
+
+//! Called when the CPU starts executing, the current CS:IP becomes the root
+void Begin();
+
+//! Called after a call to CS:IP which returns to return_segment:return_offset
+void Call(Kind kind, u16 return_segment, u16 return_offset);
+
+//! Called after a return to CS:IP
+void Return();
+
+//! Get the frame execution started in
+const Frame& GetRoot();
+
+//! Get all frames, innermost last
+const std::vector<Frame>& GetFrames();
+
+//! Replace all frames (e.g. when restoring a checkpoint)
+void SetFrames(const std::vector<Frame>& frames);
+
+//! Discard all frames and profile data
+void Clear();
+
+//! Write the call graph profile in the callgrind format to path
+bool WriteCallgrind(const std::string& path);
+} // namespace Core::Debug::CallStack
@@ -0,0 +1,420 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Debug/Checkpoint.h"
+
+#include <algorithm>
+#include <any>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "Common/Logger.h"
+
+#include "Core/CPU/Breakpoint.h"
+#include "Core/CPU/CPU.h"
+#include "Core/Debug/CallStack.h"
+#include "Core/Debug/Lockstep.h"
+#include "Core/HW/Keyboard.h"
+#include "Core/HW/PIC.h"
+#include "Core/HW/PIT.h"
+#include "Core/MSDOS/EMS.h"
+#include "Core/MSDOS/XMS.h"
+#include "Core/Memory.h"
+#include "Core/Scheduler.h"
+
+using namespace Core;
+
+namespace
+{
+constexpr size_t PAGE_SIZE = 0x1000;
+constexpr size_t MAX_CHECKPOINTS = 256;
+
+using Page = std::shared_ptr<const std::vector<u8>>;
+
+struct Snapshot {
+  u64 instruction;
+  //! Number of records made before it
+  u64 record;
+  CPU::Context context;
+  std::vector<Debug::CallStack::Frame> frames;
+  //! RAM followed by the HMA
+  std::vector<Page> pages;
+  std::vector<Page> extra_pages;
+  std::vector<Memory::ExtraMapping> mappings;
+  bool a20;
+  std::any cpu, scheduler, pic, pit, keyboard, ems, xms;
+};
+
+enum class Kind : u8 { Interrupt, Key };
+
+//! Input from the host at a point of the execution
+struct Record {
+  u64 instruction;
+  u64 cycle;
+  Kind kind;
+  u8 value;
+};
+} // namespace
+
+bool Debug::Checkpoint::active = false;
+
+// Small enough to replay in well under 50ms
+u64 Debug::Checkpoint::interval = 20'000;
+
+static std::vector<Snapshot> s_checkpoints;
+
+// Records from s_first_record on, older ones were only needed by dropped
+// checkpoints
+static std::vector<Record> s_records;
+static u64 s_first_record = 0;
+
+static bool s_replaying = false;
+// Record the replay has to come across next, and whether it met another one
+static u64 s_next_record;
+static bool s_diverged;
+
+// Copy size bytes at data in pages, sharing the ones which haven't changed
+// since last
+static void SavePages(std::vector<Page>& pages, const std::vector<Page>* last,
+                      const u8* data, size_t size)
+{
+  pages.reserve(size / PAGE_SIZE);
+
+  for (size_t i = 0; i < size / PAGE_SIZE; i++) {
+    const u8* page = data + i * PAGE_SIZE;
+
+    if (last && i < last->size() &&
+        std::memcmp((*last)[i]->data(), page, PAGE_SIZE) == 0) {
+      pages.push_back((*last)[i]);
+      continue;
+    }
+
+    pages.push_back(
+        std::make_shared<const std::vector<u8>>(page, page + PAGE_SIZE));
+  }
+}
+
+static void LoadPages(const std::vector<Page>& pages, u8* data)
+{
+  for (size_t i = 0; i < pages.size(); i++)
+    std::copy(pages[i]->begin(), pages[i]->end(), data + i * PAGE_SIZE);
+}
+
+static Snapshot Take()
+{
+  const Snapshot* last =
+      s_checkpoints.empty() ? nullptr : &s_checkpoints.back();
+
+  Snapshot snapshot{CPU::instructions,
+                    s_first_record + s_records.size(),
+                    CPU::SaveContext(),
+                    Debug::CallStack::GetFrames(),
+                    {},
+                    {},
+                    Memory::GetExtraMappings(),
+                    Memory::IsA20Enabled(),
+                    CPU::SaveState(),
+                    Scheduler::SaveState(),
+                    HW::PIC::SaveState(),
+                    HW::PIT::SaveState(),
+                    HW::Keyboard::SaveState(),
+                    MSDOS::EMS::SaveState(),
+                    MSDOS::XMS::SaveState()};
+
+  // The HMA is only visible with the A20 gate enabled
+  Memory::SetA20Enabled(true);
+  SavePages(snapshot.pages, last ? &last->pages : nullptr, Memory::base,
+            Memory::SIZE + Memory::HMA_SIZE);
+  Memory::SetA20Enabled(snapshot.a20);
+
+  SavePages(snapshot.extra_pages, last ? &last->extra_pages : nullptr,
+            Memory::extra, Memory::GetExtraSize());
+
+  return snapshot;
+}
+
+static void Save()
+{
+  s_checkpoints.push_back(Take());
+
+  // Keep every second checkpoint (and the newest one), so history reaches
+  // twice as far back at twice the spacing
+  if (s_checkpoints.size() > MAX_CHECKPOINTS) {
+    std::vector<Snapshot> thinned;
+    thinned.reserve(s_checkpoints.size() / 2 + 1);
+
+    for (size_t i = 0; i < s_checkpoints.size(); i += 2)
+      thinned.push_back(std::move(s_checkpoints[i]));
+
+    if (s_checkpoints.size() % 2 == 0)
+      thinned.push_back(std::move(s_checkpoints.back()));
+
+    s_checkpoints = std::move(thinned);
+  }
+
+  const u64 first = s_checkpoints.front().record;
+
+  s_records.erase(s_records.begin(),
+                  s_records.begin() + (first - s_first_record));
+  s_first_record = first;
+}
+
+static void Restore(const Snapshot& checkpoint)
+{
+  // Copy RAM while it shows no extra memory, the pages of the page frame
+  // would end up in the extra memory otherwise
+  Memory::UnmapExtra(0, Memory::SIZE);
+  LoadPages(checkpoint.extra_pages, Memory::extra);
+
+  Memory::SetA20Enabled(true);
+  LoadPages(checkpoint.pages, Memory::base);
+
+  for (const auto& mapping : checkpoint.mappings)
+    Memory::MapExtra(mapping.address, mapping.offset, Memory::EXTRA_PAGE_SIZE);
+
+  Memory::SetA20Enabled(checkpoint.a20);
+  Memory::NotifyWrite(0, Memory::SIZE);
+
+  // Devices refer to events of the Scheduler
+  Scheduler::LoadState(checkpoint.scheduler);
+  HW::PIC::LoadState(checkpoint.pic);
+  HW::PIT::LoadState(checkpoint.pit);
+  HW::Keyboard::LoadState(checkpoint.keyboard);
+  MSDOS::EMS::LoadState(checkpoint.ems);
+  MSDOS::XMS::LoadState(checkpoint.xms);
+
+  CPU::LoadContext(checkpoint.context);
+  CPU::instructions = checkpoint.instruction;
+  CPU::LoadState(checkpoint.cpu);
+  Debug::CallStack::SetFrames(checkpoint.frames);
+}
+
+// Record the replay has to come across next, nullptr if there is none
+static const Record* GetNextRecord()
+{
+  const u64 index = s_next_record - s_first_record;
+
+  return index < s_records.size() ? &s_records[index] : nullptr;
+}
+
+// Whether the next record is of kind and was made at this point
+static bool IsDue(Kind kind)
+{
+  const Record* record = GetNextRecord();
+
+  return record && record->kind == kind &&
+         record->instruction == CPU::instructions &&
+         record->cycle == Scheduler::cycles;
+}
+
+static void Add(Kind kind, u8 value)
+{
+  if (!s_replaying) {
+    s_records.push_back({CPU::instructions, Scheduler::cycles, kind, value});
+    return;
+  }
+
+  if (!IsDue(kind) || GetNextRecord()->value != value) {
+    s_diverged = true;
+    return;
+  }
+
+  s_next_record++;
+}
+
+// Restore checkpoint and execute instructions up to end the way CPU::Start()
+// did, with the recorded input instead of the host's. before_step is called
+// ahead of every instruction. Returns false if the machine went a different
+// way than it did before
+static bool Replay(const Snapshot& checkpoint, u64 end,
+                   const std::function<void()>& before_step)
+{
+  Restore(checkpoint);
+
+  s_replaying = true;
+  s_next_record = checkpoint.record;
+  s_diverged = false;
+
+  while (CPU::instructions < end && !s_diverged) {
+    const Record* record = GetNextRecord();
+
+    // An instruction went by without the input it got before
+    if (record && record->instruction < CPU::instructions) {
+      s_diverged = true;
+      break;
+    }
+
+    if (IsDue(Kind::Interrupt))
+      CPU::AcceptInterrupt();
+
+    if (!CPU::IsHalted()) {
+      before_step();
+
+      const u64 executed = CPU::instructions;
+      CPU::Step();
+      Scheduler::Advance(CPU::instructions - executed);
+      continue;
+    }
+
+    // Sleep until the next event or the next input, like CPU::Start() did
+    u64 until = Scheduler::next;
+
+    if (record && record->instruction == CPU::instructions)
+      until = std::min(until, record->cycle);
+
+    if (until == Scheduler::NEVER || until < Scheduler::cycles) {
+      s_diverged = true;
+      break;
+    }
+
+    const u64 position = s_next_record;
+    const bool waited = until != Scheduler::cycles;
+
+    Scheduler::Advance(until - Scheduler::cycles);
+
+    if (IsDue(Kind::Key))
+      HW::Keyboard::Update();
+
+    // Neither time passed nor input arrived, it would never wake up
+    if (!waited && s_next_record == position && !IsDue(Kind::Interrupt))
+      s_diverged = true;
+  }
+
+  s_replaying = false;
+
+  return !s_diverged && CPU::instructions == end;
+}
+
+// Lockstep runs whole blocks between two looks at the Scheduler, replays
+// can't tell where events happened in between
+static bool CanRewind()
+{
+  return !s_checkpoints.empty() && !Debug::Lockstep::active &&
+         (!CPU::IsRunning() || CPU::IsPaused());
+}
+
+// Replay up to target and make it the present. The machine goes back to
+// present if the replay fails
+static bool GoTo(u64 target, const Snapshot& present)
+{
+  auto it = std::find_if(
+      s_checkpoints.rbegin(), s_checkpoints.rend(),
+      [target](const Snapshot& c) { return c.instruction <= target; });
+
+  if (it == s_checkpoints.rend())
+    return false;
+
+  if (!Replay(*it, target, [] {})) {
+    ERROR("Replaying to instruction " + std::to_string(target) +
+          " didn't go like before, staying at " +
+          std::to_string(present.instruction));
+    Restore(present);
+    return false;
+  }
+
+  // Everything after this point is about to be rewritten
+  s_checkpoints.erase(it.base(), s_checkpoints.end());
+  s_records.erase(s_records.begin() + (s_next_record - s_first_record),
+                  s_records.end());
+
+  CPU::SkipCurrentBreakpoint();
+  CPU::TriggerCallbacks();
+
+  return true;
+}
+
+void Debug::Checkpoint::Update()
+{
+  if (!active)
+    return;
+
+  if (!s_checkpoints.empty() &&
+      CPU::instructions - s_checkpoints.back().instruction < interval)
+    return;
+
+  Save();
+}
+
+void Debug::Checkpoint::Clear()
+{
+  s_checkpoints.clear();
+  s_records.clear();
+  s_first_record = 0;
+}
+
+bool Debug::Checkpoint::StepBack()
+{
+  if (!CanRewind() || CPU::instructions == 0)
+    return false;
+
+  return GoTo(CPU::instructions - 1, Take());
+}
+
+bool Debug::Checkpoint::ReverseContinue()
+{
+  if (!CanRewind())
+    return false;
+
+  const Snapshot present = Take();
+
+  // Replay the checkpoint windows from newest to oldest until one of them
+  // contains a breakpoint hit
+  for (size_t i = s_checkpoints.size(); i-- > 0;) {
+    if (s_checkpoints[i].instruction >= present.instruction)
+      continue;
+
+    const u64 end =
+        i + 1 < s_checkpoints.size()
+            ? std::min(present.instruction, s_checkpoints[i + 1].instruction)
+            : present.instruction;
+
+    std::optional<u64> hit;
+
+    const bool replayed = Replay(s_checkpoints[i], end, [&hit] {
+      if (CPU::IsBreakpointHit())
+        hit = CPU::instructions;
+    });
+
+    if (!replayed) {
+      ERROR("Replaying from instruction " +
+            std::to_string(s_checkpoints[i].instruction) +
+            " didn't go like before, staying at " +
+            std::to_string(present.instruction));
+      Restore(present);
+      return false;
+    }
+
+    if (hit)
+      return GoTo(hit.value(), present);
+  }
+
+  return GoTo(s_checkpoints.front().instruction, present);
+}
+
+bool Debug::Checkpoint::IsReplaying() { return s_replaying; }
+
+void Debug::Checkpoint::RecordInterrupt(u8 vector)
+{
+  if (active)
+    Add(Kind::Interrupt, vector);
+}
+
+void Debug::Checkpoint::RecordKey(u8 code)
+{
+  if (active)
+    Add(Kind::Key, code);
+}
+
+bool Debug::Checkpoint::TakeKey(u8& code)
+{
+  if (!IsDue(Kind::Key))
+    return false;
+
+  code = GetNextRecord()->value;
+  s_next_record++;
+  return true;
+}
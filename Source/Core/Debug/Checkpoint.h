@@ -0,0 +1,55 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include "Common/Types.h"
+
+/**@brief Periodic machine checkpoints used for reverse execution
+ *
+ * Going backwards restores the nearest earlier checkpoint and deterministically
+ * re-executes instructions until the requested point is reached. Checkpoints
+ * hold memory (including the extra memory and its mappings), the devices and
+ * the Scheduler. What comes from the host, i.e. interrupts the CPU accepted
+ * and scan codes the keyboard latched, is recorded with the instruction and
+ * cycle it happened at and delivered at the same point again. If the replay
+ * doesn't follow the recording the machine is left as it was. Host side
+ * effects (e.g. MS-DOS file handles) are not rewound.
+ */
+namespace Core::Debug::Checkpoint
+{
+//! Whether checkpoints are taken and input is recorded. Off by default as
+//! only the debugger goes backwards
+extern bool active;
+
+//! Amount of instructions between two checkpoints
+extern u64 interval;
+
+//! Take a new checkpoint if one is due
+void Update();
+
+//! Discard all checkpoints
+void Clear();
+
+//! Go back by one instruction. Returns ``false`` if there is no history left
+bool StepBack();
+
+//! Go back to the last breakpoint hit before the current instruction (or the
+//! beginning of the recorded history if there is none)
+bool ReverseContinue();
+
+//! Whether instructions are being re-executed right now
+bool IsReplaying();
+
+//! Record that the CPU accepted the interrupt vector
+void RecordInterrupt(u8 vector);
+
+//! Record that the keyboard latched a scan code from the frontend
+void RecordKey(u8 code);
+
+//! Get the scan code the keyboard latched at this point of a replay.
+//! Returns ``false`` if it latched none
+bool TakeKey(u8& code);
+} // namespace Core::Debug::Checkpoint
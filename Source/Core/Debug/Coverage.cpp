@@ -0,0 +1,57 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Debug/Coverage.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "Common/Logger.h"
+
+using namespace Core;
+
+bool Debug::Coverage::active = false;
+u8 Debug::Coverage::bitmap[ADDRESS_SPACE / 8];
+
+void Debug::Coverage::Start()
+{
+  std::fill(std::begin(bitmap), std::end(bitmap), 0);
+  active = true;
+}
+
+void Debug::Coverage::Stop() { active = false; }
+
+bool Debug::Coverage::Write(const std::string& path)
+{
+  std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+
+  ofs.write(reinterpret_cast<const char*>(bitmap), sizeof(bitmap));
+
+  if (!ofs.good()) {
+    ERROR("Failed to write coverage bitmap " + path);
+    return false;
+  }
+
+  return true;
+}
+
+bool Debug::Coverage::Merge(const std::string& path)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  std::vector<u8> other(sizeof(bitmap));
+
+  ifs.read(reinterpret_cast<char*>(other.data()), other.size());
+
+  if (!ifs.good() || ifs.peek() != std::ifstream::traits_type::eof()) {
+    ERROR(path + " is not a coverage bitmap");
+    return false;
+  }
+
+  for (size_t i = 0; i < sizeof(bitmap); i++)
+    bitmap[i] |= other[i];
+
+  return true;
+}
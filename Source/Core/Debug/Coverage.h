@@ -0,0 +1,56 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <string>
+
+#include "Common/Types.h"
+
+/**@brief Guest code coverage
+ *
+ * One bit per physical address of the 1 MiB address space is set when an
+ * instruction starting there gets decoded. Bitmap files are the raw bitmap
+ * (bit n % 8 of byte n / 8 for address n), so merging runs is a bitwise OR.
+ */
+namespace Core::Debug::Coverage
+{
+constexpr u32 ADDRESS_SPACE = 0x100000;
+
+//! Whether executed instructions are being recorded
+extern bool active;
+
+//! One bit per physical address
+extern u8 bitmap[ADDRESS_SPACE / 8];
+
+//! Start recording with an empty bitmap
+void Start();
+
+//! Stop recording. The bitmap is kept
+void Stop();
+
+//! Record that an instruction starting at segment:offset got executed
+inline void Mark(u16 segment, u16 offset)
+{
+  if (!active)
+    return;
+
+  const u32 address = ((segment << 4) + offset) & (ADDRESS_SPACE - 1);
+  bitmap[address / 8] |= 1 << (address % 8);
+}
+
+//! Whether an instruction starting at the physical address got executed
+inline bool IsCovered(u32 address)
+{
+  address &= ADDRESS_SPACE - 1;
+  return bitmap[address / 8] & (1 << (address % 8));
+}
+
+//! Write the bitmap to path
+bool Write(const std::string& path);
+
+//! Merge the bitmap stored at path into the current one
+bool Merge(const std::string& path);
+} // namespace Core::Debug::Coverage
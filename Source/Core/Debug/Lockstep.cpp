@@ -0,0 +1,369 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Debug/Lockstep.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include "Common/Hash.h"
+#include "Common/String.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/CPU/Engine.h"
+#include "Core/Debug/CallStack.h"
+#include "Core/Debug/Trace.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+
+constexpr size_t PAGE_SIZE = Memory::PAGE_SIZE;
+
+// Differing bytes listed in a divergence report
+constexpr size_t MAX_REPORTED_BYTES = 32;
+
+bool Debug::Lockstep::active = false;
+
+static const CPU::Engine* s_a;
+static const CPU::Engine* s_b;
+
+// RAM as of the beginning of the current block
+static std::vector<u8> s_shadow;
+
+// RAM as left behind by the first engine (only pages written by the block
+// are up to date)
+static std::vector<u8> s_result;
+
+static u64 s_blocks;
+static std::string s_divergence;
+
+namespace
+{
+//! Executed instruction of a block
+struct Executed {
+  u16 cs, ip;
+  std::string text;
+};
+
+//! Result of one engine executing a block
+struct Result {
+  CPU::Context context;
+  std::string error;
+  std::exception_ptr exception;
+};
+} // namespace
+
+static bool Decode(u16 segment, u16 offset, CPU::Instruction& ins)
+{
+  const u16 base = offset;
+
+  try {
+    ins = CPU::Instruction(Memory::Read<u8>(segment, offset++), base);
+
+    if (ins.IsPrefix())
+      ins = CPU::Instruction(ins, Memory::Read<u8>(segment, offset++), base);
+
+    if (!ins.IsResolved()) {
+      u8 mod = Memory::Read<u8>(segment, offset++);
+      u8 length = ins.GetLength(mod);
+
+      std::vector<u8> data;
+
+      for (u8 i = 0; i < length; i++)
+        data.push_back(Memory::Read<u8>(segment, offset++));
+
+      if (!ins.Resolve(mod, data))
+        return false;
+    }
+
+    return ins.GetType() != CPU::Instruction::Type::Invalid;
+  } catch (CPU::CPUException&) {
+    return false;
+  }
+}
+
+// Instructions whose effects can't be rewound
+static bool HasSideEffects(const CPU::Instruction& ins)
+{
+  using Type = CPU::Instruction::Type;
+
+  switch (ins.GetType()) {
+  case Type::INT:
+  case Type::HLT:
+  case Type::TRAP:
+  case Type::IN:
+  case Type::OUT:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static u64 HashState(const CPU::Context& c, const u8* ram,
+                     const std::vector<size_t>& pages)
+{
+  const u16 registers[] = {c.AX, c.BX, c.CX, c.DX, c.CS, c.DS, c.ES,
+                           c.SS, c.IP, c.BP, c.SP, c.SI, c.DI};
+  const bool flags[] = {c.AF, c.CF, c.IF, c.DF, c.OF, c.PF, c.SF, c.ZF};
+
+  u64 hash = Hash::FNV1a(registers);
+  hash = Hash::FNV1a(flags, hash);
+  hash = Hash::FNV1a(c.repeat_mode, hash);
+
+  for (size_t page : pages) {
+    hash = Hash::FNV1a(page, hash);
+    hash = Hash::FNV1a(ram + page * PAGE_SIZE, PAGE_SIZE, hash);
+  }
+
+  return hash;
+}
+
+// Pages of RAM instructions wrote since the last call. The HMA isn't part of
+// the shadow copy, so it isn't checked either
+static std::vector<size_t> GetWrittenPages()
+{
+  std::vector<size_t> pages;
+
+  for (u32 page : Memory::TakeWrittenPages()) {
+    if (page < Memory::SIZE / PAGE_SIZE)
+      pages.push_back(page);
+  }
+
+  return pages;
+}
+
+// Pages which differ from the shadow copy. Needed where native code may have
+// written memory directly
+static std::vector<size_t> GetDirtyPages()
+{
+  std::vector<size_t> pages;
+
+  for (size_t i = 0; i < Memory::SIZE / PAGE_SIZE; i++) {
+    if (std::memcmp(Memory::base + i * PAGE_SIZE,
+                    s_shadow.data() + i * PAGE_SIZE, PAGE_SIZE) != 0)
+      pages.push_back(i);
+  }
+
+  return pages;
+}
+
+static void CopyPages(u8* dst, const u8* src, const std::vector<size_t>& pages)
+{
+  for (size_t page : pages)
+    std::memcpy(dst + page * PAGE_SIZE, src + page * PAGE_SIZE, PAGE_SIZE);
+}
+
+static Result Run(const CPU::Engine& engine, u32 count)
+{
+  Result result;
+
+  try {
+    for (u32 i = 0; i < count; i++)
+      engine.step();
+  } catch (CPU::CPUException& e) {
+    result.error = e.what();
+    result.exception = std::current_exception();
+  }
+
+  result.context = CPU::SaveContext();
+  return result;
+}
+
+static std::string ToString(const CPU::Context& c)
+{
+  std::ostringstream ss;
+
+  ss << "AX=" << String::ToHex(c.AX) << " BX=" << String::ToHex(c.BX)
+     << " CX=" << String::ToHex(c.CX) << " DX=" << String::ToHex(c.DX)
+     << " SI=" << String::ToHex(c.SI) << " DI=" << String::ToHex(c.DI)
+     << " BP=" << String::ToHex(c.BP) << " SP=" << String::ToHex(c.SP)
+     << std::endl
+     << "  CS=" << String::ToHex(c.CS) << " DS=" << String::ToHex(c.DS)
+     << " ES=" << String::ToHex(c.ES) << " SS=" << String::ToHex(c.SS)
+     << " IP=" << String::ToHex(c.IP) << " "
+     << (c.OF ? 'O' : '-') << (c.DF ? 'D' : '-') << (c.IF ? 'I' : '-')
+     << (c.SF ? 'S' : '-') << (c.ZF ? 'Z' : '-') << (c.AF ? 'A' : '-')
+     << (c.PF ? 'P' : '-') << (c.CF ? 'C' : '-');
+
+  return ss.str();
+}
+
+static void Report(const std::vector<Executed>& block, const Result& a,
+                   const Result& b, const u8* ram_a, const u8* ram_b,
+                   const std::vector<size_t>& pages)
+{
+  std::ostringstream ss;
+
+  ss << "Engines diverged in block " << s_blocks << ":" << std::endl;
+
+  for (const auto& ins : block)
+    ss << "  " << String::ToHex(ins.cs) << ":" << String::ToHex(ins.ip)
+       << "  " << ins.text << std::endl;
+
+  for (const auto& [engine, result] :
+       {std::make_pair(s_a, &a), std::make_pair(s_b, &b)}) {
+    ss << engine->name << ":" << std::endl
+       << "  " << ToString(result->context) << std::endl;
+
+    if (!result->error.empty())
+      ss << "  Stopped with: " << result->error << std::endl;
+  }
+
+  size_t reported = 0;
+
+  for (size_t page : pages) {
+    for (size_t i = page * PAGE_SIZE; i < (page + 1) * PAGE_SIZE; i++) {
+      if (ram_a[i] == ram_b[i] || reported++ >= MAX_REPORTED_BYTES)
+        continue;
+
+      ss << "  [" << String::ToHex(static_cast<u32>(i)) << "] "
+         << String::ToHex(ram_a[i]) << " vs " << String::ToHex(ram_b[i])
+         << std::endl;
+    }
+  }
+
+  if (reported > MAX_REPORTED_BYTES)
+    ss << "  (" << reported - MAX_REPORTED_BYTES << " more bytes differ)"
+       << std::endl;
+
+  s_divergence = ss.str();
+}
+
+bool Debug::Lockstep::Start(const std::string& a, const std::string& b)
+{
+  s_a = CPU::GetEngine(a);
+  s_b = CPU::GetEngine(b);
+
+  if (!s_a || !s_b)
+    return false;
+
+  s_blocks = 0;
+  s_divergence.clear();
+  active = true;
+
+  Memory::TrackWrites(true);
+
+  return true;
+}
+
+void Debug::Lockstep::Stop()
+{
+  active = false;
+  s_shadow = {};
+  s_result = {};
+
+  Memory::TrackWrites(false);
+}
+
+void Debug::Lockstep::Begin()
+{
+  if (!active)
+    return;
+
+  s_shadow.assign(Memory::base, Memory::base + Memory::SIZE);
+  s_result = s_shadow;
+}
+
+void Debug::Lockstep::Sync()
+{
+  if (!active)
+    return;
+
+  CopyPages(s_shadow.data(), Memory::base, GetDirtyPages());
+}
+
+bool Debug::Lockstep::Step()
+{
+  u8* ram = Memory::base;
+
+  CPU::Instruction ins;
+
+  // Leave instructions with side effects and undecodable ones (which throw)
+  // to the first engine
+  if (!Decode(CPU::CS, CPU::IP, ins) || HasSideEffects(ins)) {
+    s_a->step();
+    CopyPages(s_shadow.data(), ram, GetDirtyPages());
+    return true;
+  }
+
+  const CPU::Context context = CPU::SaveContext();
+  const u64 instructions = CPU::instructions;
+  const auto frames = Debug::CallStack::GetFrames();
+
+  // Everything written before is in the shadow copy already
+  Memory::TakeWrittenPages();
+
+  // The first engine defines where the block ends
+  std::vector<Executed> block;
+  Result a;
+
+  while (block.size() < MAX_BLOCK) {
+    if (!block.empty() &&
+        (!Decode(CPU::CS, CPU::IP, ins) || HasSideEffects(ins)))
+      break;
+
+    block.push_back({CPU::CS, CPU::IP, ins.ToString()});
+
+    a = Run(*s_a, 1);
+
+    if (!a.error.empty() ||
+        Debug::Trace::GetBranchKind(ins) != Debug::Trace::BranchKind::None)
+      break;
+  }
+
+  const auto dirty_a = GetWrittenPages();
+  CopyPages(s_result.data(), ram, dirty_a);
+
+  // Rewind and let the second engine execute the same instructions
+  CopyPages(ram, s_shadow.data(), dirty_a);
+  CPU::LoadContext(context);
+  CPU::instructions = instructions;
+  Debug::CallStack::SetFrames(frames);
+
+  // The trace already holds the block, the second run must not record it
+  // again
+  const bool tracing = Debug::Trace::active;
+  Debug::Trace::active = false;
+
+  Result b = Run(*s_b, static_cast<u32>(block.size()));
+
+  Debug::Trace::active = tracing;
+
+  // Pages only the second engine wrote are unchanged for the first one
+  const auto dirty_b = GetWrittenPages();
+  std::vector<size_t> pages;
+
+  for (size_t page : dirty_b) {
+    if (!std::binary_search(dirty_a.begin(), dirty_a.end(), page))
+      CopyPages(s_result.data(), s_shadow.data(), {page});
+  }
+
+  std::set_union(dirty_a.begin(), dirty_a.end(), dirty_b.begin(),
+                 dirty_b.end(), std::back_inserter(pages));
+
+  s_blocks++;
+
+  if (a.error != b.error ||
+      HashState(a.context, s_result.data(), pages) !=
+          HashState(b.context, ram, pages)) {
+    Report(block, a, b, s_result.data(), ram, pages);
+    return false;
+  }
+
+  CopyPages(s_shadow.data(), ram, pages);
+
+  // Both engines failed the same way, stop like a single engine would
+  if (b.exception)
+    std::rethrow_exception(b.exception);
+
+  return true;
+}
+
+u64 Debug::Lockstep::GetBlockCount() { return s_blocks; }
+
+const std::string& Debug::Lockstep::GetDivergence() { return s_divergence; }
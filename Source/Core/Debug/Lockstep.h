@@ -0,0 +1,55 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <string>
+
+#include "Common/Types.h"
+
+/**@brief Differential checking of two execution engines
+ *
+ * Every block (up to and including the next branch) is executed by the first
+ * engine, then the machine is rewound and the second engine executes it again.
+ * The state hashes (registers and the RAM pages written by the block) of both
+ * runs have to match. Written pages are tracked by Memory, so only those get
+ * compared and copied. Only the first run is recorded in a trace.
+ *
+ * Instructions with side effects outside of the machine (e.g. interrupts
+ * handled by the emulator and port I/O) are executed by the first engine
+ * only.
+ */
+namespace Core::Debug::Lockstep
+{
+//! Maximum amount of instructions in one block
+constexpr u32 MAX_BLOCK = 64;
+
+//! Whether blocks get checked. Use Start() and Stop() to change this
+extern bool active;
+
+//! Start comparing the engines named a and b. Returns false if an engine
+//! doesn't exist
+bool Start(const std::string& a, const std::string& b);
+
+//! Stop comparing
+void Stop();
+
+//! Called when the CPU starts executing
+void Begin();
+
+//! Called after the machine changed between instructions (e.g. a hardware
+//! interrupt got delivered), so rewinding a block doesn't undo it
+void Sync();
+
+//! Execute and check the next block. Returns false if the engines diverged
+bool Step();
+
+//! Amount of blocks which have been checked
+u64 GetBlockCount();
+
+//! Description of the divergence (empty if there was none): Disassembly of
+//! the block, both register sets and the differing bytes
+const std::string& GetDivergence();
+} // namespace Core::Debug::Lockstep
@@ -0,0 +1,156 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Debug/OpCounters.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+
+#include "Common/String.h"
+
+using namespace Core;
+using namespace Core::Debug;
+
+static std::mutex s_mutex;
+static OpCounters::Counters s_totals;
+
+#ifdef APE_OP_COUNTERS
+thread_local OpCounters::Counters OpCounters::local;
+
+void OpCounters::Publish()
+{
+  std::lock_guard<std::mutex> lock(s_mutex);
+
+  s_totals.instructions += local.instructions;
+
+  for (size_t i = 0; i < TYPE_COUNT; i++) {
+    s_totals.types[i] += local.types[i];
+    s_totals.repetitions[i] += local.repetitions[i];
+  }
+
+  for (size_t i = 0; i < PTYPE_COUNT; i++)
+    s_totals.parameters[i] += local.parameters[i];
+
+  for (size_t i = 0; i < PREFIX_COUNT; i++)
+    s_totals.prefixes[i] += local.prefixes[i];
+
+  for (size_t i = 0; i < 256; i++)
+    s_totals.interrupts[i] += local.interrupts[i];
+
+  for (const auto& [key, count] : local.functions)
+    s_totals.functions[key] += count;
+
+  local = Counters();
+}
+#endif
+
+void OpCounters::Clear()
+{
+  std::lock_guard<std::mutex> lock(s_mutex);
+
+  s_totals = Counters();
+
+#ifdef APE_OP_COUNTERS
+  local = Counters();
+#endif
+}
+
+std::vector<OpCounters::Entry> OpCounters::GetReport()
+{
+  std::vector<Entry> report;
+
+  std::lock_guard<std::mutex> lock(s_mutex);
+
+  auto Add = [&report](const std::string& group, const std::string& name,
+                       u64 count) {
+    if (count != 0)
+      report.push_back({group, name, count});
+  };
+
+  // Keep groups in this order and sort their entries by count
+  auto Sort = [&report](size_t first) {
+    std::stable_sort(
+        report.begin() + first, report.end(),
+        [](const Entry& a, const Entry& b) { return a.count > b.count; });
+  };
+
+  Add("Total", "Instructions", s_totals.instructions);
+
+  size_t first = report.size();
+  for (size_t i = 0; i < TYPE_COUNT; i++)
+    Add("Instruction", CPU::TypeToString(static_cast<Type>(i)),
+        s_totals.types[i]);
+  Sort(first);
+
+  first = report.size();
+  for (size_t i = 0; i < PTYPE_COUNT; i++)
+    Add("Operand", CPU::ParameterTypeToString(static_cast<PType>(i)),
+        s_totals.parameters[i]);
+  Sort(first);
+
+  // Instructions without a prefix are not interesting
+  first = report.size();
+  Add("Prefix", "CS", s_totals.prefixes[static_cast<size_t>(Prefix::CS)]);
+  Add("Prefix", "DS", s_totals.prefixes[static_cast<size_t>(Prefix::DS)]);
+  Add("Prefix", "ES", s_totals.prefixes[static_cast<size_t>(Prefix::ES)]);
+  Add("Prefix", "SS", s_totals.prefixes[static_cast<size_t>(Prefix::SS)]);
+  Add("Prefix", "REPZ", s_totals.types[static_cast<size_t>(Type::REPZ)]);
+  Add("Prefix", "REPNZ", s_totals.types[static_cast<size_t>(Type::REPNZ)]);
+  Sort(first);
+
+  first = report.size();
+  for (size_t i = 0; i < TYPE_COUNT; i++)
+    Add("Repetition", CPU::TypeToString(static_cast<Type>(i)),
+        s_totals.repetitions[i]);
+  Sort(first);
+
+  first = report.size();
+  for (size_t i = 0; i < 256; i++)
+    Add("Interrupt", String::ToHex(static_cast<u8>(i)),
+        s_totals.interrupts[i]);
+  Sort(first);
+
+  first = report.size();
+  for (const auto& [key, count] : s_totals.functions)
+    Add("Function",
+        String::ToHex(static_cast<u8>(key >> 8)) +
+            " AH=" + String::ToHex(static_cast<u8>(key & 0xFF)),
+        count);
+  Sort(first);
+
+  return report;
+}
+
+void OpCounters::PrintReport(std::ostream& stream)
+{
+  const auto& report = GetReport();
+
+  if (report.empty()) {
+    stream << "No instructions counted" << std::endl;
+    return;
+  }
+
+  // Percentages are relative to the group
+  std::unordered_map<std::string, u64> totals;
+
+  for (const auto& entry : report)
+    totals[entry.group] += entry.count;
+
+  std::string group;
+
+  for (const auto& entry : report) {
+    if (entry.group != group) {
+      group = entry.group;
+      stream << std::endl << group << std::endl;
+    }
+
+    const u64 total = totals[group];
+
+    stream << "  " << std::left << std::setw(32) << entry.name << std::right
+           << std::setw(14) << entry.count << std::setw(9) << std::fixed
+           << std::setprecision(2) << 100.0 * entry.count / total << "%"
+           << std::endl;
+  }
+}
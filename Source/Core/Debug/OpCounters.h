@@ -0,0 +1,105 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/Types.h"
+
+#include "Core/CPU/Instruction.h"
+
+/**@brief Execution counters of the interpreter
+ *
+ * Only compiled in when configured with ENABLE_OP_COUNTERS, otherwise all
+ * counting functions are empty. Counting happens in thread local storage and
+ * is merged into the totals read by GetReport() by Publish().
+ */
+namespace Core::Debug::OpCounters
+{
+//! One line of a report
+struct Entry {
+  std::string group;
+  std::string name;
+  u64 count;
+};
+
+using Type = CPU::Instruction::Type;
+using PType = CPU::Instruction::Parameter::Type;
+using Prefix = CPU::Instruction::SegmentPrefix;
+
+constexpr size_t TYPE_COUNT = static_cast<size_t>(Type::Invalid) + 1;
+constexpr size_t PTYPE_COUNT =
+    static_cast<size_t>(PType::Value_WordAddress_Word) + 1;
+constexpr size_t PREFIX_COUNT = static_cast<size_t>(Prefix::SS) + 1;
+
+//! Raw counters
+struct Counters {
+  u64 instructions = 0;
+  u64 types[TYPE_COUNT] = {};
+  u64 parameters[PTYPE_COUNT] = {};
+  u64 prefixes[PREFIX_COUNT] = {};
+  //! Iterations of repeated instructions by Instruction::Type
+  u64 repetitions[TYPE_COUNT] = {};
+  u64 interrupts[256] = {};
+  //! Interrupt functions keyed by vector << 8 | AH
+  std::unordered_map<u16, u64> functions;
+};
+
+#ifdef APE_OP_COUNTERS
+constexpr bool enabled = true;
+
+extern thread_local Counters local;
+
+//! Merge the counters of the calling thread into the totals
+void Publish();
+
+//! Count an instruction which is about to be executed
+inline void CountInstruction(const CPU::Instruction& ins)
+{
+  local.types[static_cast<size_t>(ins.GetType())]++;
+  local.prefixes[static_cast<size_t>(ins.GetPrefix())]++;
+
+  for (const auto& parameter : ins.GetParameters())
+    local.parameters[static_cast<size_t>(parameter.GetType())]++;
+
+  // Keep the totals reasonably fresh without paying for it every instruction
+  if ((++local.instructions & 0xFFFF) == 0)
+    Publish();
+}
+
+//! Count iterations of a repeated instruction
+inline void CountRepetitions(const CPU::Instruction& ins, u16 count)
+{
+  local.repetitions[static_cast<size_t>(ins.GetType())] += count;
+}
+
+//! Count an interrupt call
+inline void CountInterrupt(u8 vector, u8 function)
+{
+  local.interrupts[vector]++;
+  local.functions[vector << 8 | function]++;
+}
+#else
+constexpr bool enabled = false;
+
+inline void Publish() {}
+inline void CountInstruction(const CPU::Instruction&) {}
+inline void CountRepetitions(const CPU::Instruction&, u16) {}
+inline void CountInterrupt(u8, u8) {}
+#endif
+
+//! Reset the totals and the counters of the calling thread
+void Clear();
+
+//! Get all non-zero totals, grouped and sorted by count
+std::vector<Entry> GetReport();
+
+//! Write GetReport() as a table
+void PrintReport(std::ostream& stream);
+} // namespace Core::Debug::OpCounters
@@ -0,0 +1,210 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Debug/Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/Logger.h"
+#include "Common/String.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/CPU/Instruction.h"
+#include "Core/Debug/CallStack.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+using namespace Core::Debug;
+
+namespace
+{
+struct Hit {
+  //! First CS:IP seen for this address
+  u16 segment;
+  u16 offset;
+  u64 count;
+};
+} // namespace
+
+u64 Debug::Profiler::countdown = 0;
+
+static u64 s_interval;
+static u64 s_samples;
+static std::unordered_map<u32, Hit> s_hits;
+// Entry points of the functions on the call stack, keyed by
+// segment << 16 | offset
+static std::map<std::vector<u32>, u64> s_stacks;
+
+// Size of the ranges in the report
+static constexpr u32 RANGE_SIZE = 0x100;
+
+static u32 ToPhysical(u16 segment, u16 offset)
+{
+  return ((segment << 4) + offset) & 0xFFFFF;
+}
+
+static u32 ToKey(const Debug::CallStack::Frame& frame)
+{
+  return static_cast<u32>(frame.segment) << 16 | frame.offset;
+}
+
+static std::string ToString(u16 segment, u16 offset)
+{
+  return String::ToHex(segment) + ":" + String::ToHex(offset);
+}
+
+static std::string Disassemble(u16 segment, u16 offset)
+{
+  const u16 base = offset;
+
+  try {
+    auto ins = CPU::Instruction(Memory::Read<u8>(segment, offset++), base);
+
+    if (ins.IsPrefix())
+      ins = CPU::Instruction(ins, Memory::Read<u8>(segment, offset++), base);
+
+    if (!ins.IsResolved()) {
+      u8 mod = Memory::Read<u8>(segment, offset++);
+      u8 length = ins.GetLength(mod);
+
+      std::vector<u8> data;
+
+      for (u8 i = 0; i < length; i++)
+        data.push_back(Memory::Read<u8>(segment, offset++));
+
+      if (!ins.Resolve(mod, data))
+        return "(unresolved)";
+    }
+
+    return ins.ToString();
+  } catch (...) {
+    return "(undecodable)";
+  }
+}
+
+void Debug::Profiler::Start(u64 interval)
+{
+  s_interval = std::max<u64>(interval, 1);
+  countdown = s_interval;
+}
+
+void Debug::Profiler::Stop() { countdown = 0; }
+
+void Debug::Profiler::Clear()
+{
+  s_samples = 0;
+  s_hits.clear();
+  s_stacks.clear();
+}
+
+void Debug::Profiler::Sample()
+{
+  countdown = s_interval;
+
+  auto& hit = s_hits[ToPhysical(CPU::CS, CPU::IP)];
+
+  if (hit.count++ == 0) {
+    hit.segment = CPU::CS;
+    hit.offset = CPU::IP;
+  }
+
+  const auto& frames = CallStack::GetFrames();
+  std::vector<u32> stack;
+
+  stack.reserve(frames.size() + 1);
+  stack.push_back(ToKey(CallStack::GetRoot()));
+
+  for (const auto& frame : frames)
+    stack.push_back(ToKey(frame));
+
+  s_stacks[stack]++;
+  s_samples++;
+}
+
+bool Debug::Profiler::WriteReport(const std::string& path, size_t count)
+{
+  std::ofstream ofs(path);
+
+  if (!ofs.good()) {
+    ERROR("Failed to open profile report " + path);
+    return false;
+  }
+
+  std::vector<std::pair<u32, Hit>> hits(s_hits.begin(), s_hits.end());
+  std::unordered_map<u32, u64> ranges;
+
+  for (const auto& [address, hit] : hits)
+    ranges[address / RANGE_SIZE * RANGE_SIZE] += hit.count;
+
+  std::vector<std::pair<u32, u64>> hot_ranges(ranges.begin(), ranges.end());
+
+  std::sort(hits.begin(), hits.end(), [](const auto& a, const auto& b) {
+    return a.second.count > b.second.count ||
+           (a.second.count == b.second.count && a.first < b.first);
+  });
+
+  std::sort(hot_ranges.begin(), hot_ranges.end(),
+            [](const auto& a, const auto& b) {
+              return a.second > b.second ||
+                     (a.second == b.second && a.first < b.first);
+            });
+
+  auto Percent = [](u64 samples) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2) << std::setw(7)
+       << 100.0 * samples / std::max<u64>(s_samples, 1) << "%";
+    return ss.str();
+  };
+
+  ofs << "Samples: " << s_samples << " (1 every " << s_interval
+      << " instructions)" << std::endl
+      << std::endl
+      << "Hot addresses" << std::endl;
+
+  for (size_t i = 0; i < std::min(count, hits.size()); i++) {
+    const auto& [address, hit] = hits[i];
+
+    ofs << "  " << String::ToHex(address) << "  "
+        << ToString(hit.segment, hit.offset) << std::setw(10) << hit.count
+        << Percent(hit.count) << "  " << Disassemble(hit.segment, hit.offset)
+        << std::endl;
+  }
+
+  ofs << std::endl << "Hot ranges" << std::endl;
+
+  for (size_t i = 0; i < std::min(count, hot_ranges.size()); i++) {
+    const auto& [address, samples] = hot_ranges[i];
+
+    ofs << "  " << String::ToHex(address) << "-"
+        << String::ToHex(address + RANGE_SIZE - 1) << std::setw(10) << samples
+        << Percent(samples) << std::endl;
+  }
+
+  return true;
+}
+
+bool Debug::Profiler::WriteCollapsedStacks(const std::string& path)
+{
+  std::ofstream ofs(path);
+
+  if (!ofs.good()) {
+    ERROR("Failed to open collapsed stack file " + path);
+    return false;
+  }
+
+  for (const auto& [stack, count] : s_stacks) {
+    for (size_t i = 0; i < stack.size(); i++)
+      ofs << (i ? ";" : "") << ToString(stack[i] >> 16, stack[i] & 0xFFFF);
+
+    ofs << " " << count << std::endl;
+  }
+
+  return true;
+}
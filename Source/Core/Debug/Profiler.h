@@ -0,0 +1,47 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <string>
+
+#include "Common/Types.h"
+
+/**@brief Sampling profiler for guest code
+ *
+ * Every interval instructions the current CS:IP is recorded into a histogram
+ * keyed by physical address.
+ */
+namespace Core::Debug::Profiler
+{
+//! Instructions left until the next sample, 0 if the profiler is stopped
+extern u64 countdown;
+
+//! Start taking a sample every interval instructions
+void Start(u64 interval = 1000);
+
+//! Stop taking samples. Already taken ones are kept
+void Stop();
+
+//! Discard all samples
+void Clear();
+
+//! Record the current CS:IP
+void Sample();
+
+//! Called before every instruction
+inline void Tick()
+{
+  if (countdown != 0 && --countdown == 0)
+    Sample();
+}
+
+//! Write the hottest addresses and ranges with their disassembly to path
+bool WriteReport(const std::string& path, size_t count = 50);
+
+//! Write the shadow call stacks of all samples as collapsed stacks (as used by
+//! flamegraph.pl) to path
+bool WriteCollapsedStacks(const std::string& path);
+} // namespace Core::Debug::Profiler
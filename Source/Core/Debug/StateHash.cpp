@@ -0,0 +1,196 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Debug/StateHash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "Common/Hash.h"
+#include "Common/Logger.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+
+constexpr size_t PAGE_SIZE = 4096;
+
+// Unchanged bytes between two changes which still get merged into one Span
+constexpr size_t SPAN_GAP = 16;
+
+bool Debug::StateHash::active = false;
+
+static std::ofstream s_file;
+static u64 s_interval;
+static u64 s_next;
+static u64 s_to;
+static u64 s_last;
+static bool s_recorded;
+
+// RAM as of the last Entry
+static std::vector<u8> s_shadow;
+
+// Hash of every page and all of them combined
+static std::vector<u64> s_page_hashes;
+static u64 s_pages_hash;
+
+static u64 HashPage(size_t page, const u8* data)
+{
+  return Hash::FNV1a(data, PAGE_SIZE, Hash::FNV1a(page));
+}
+
+static void Write(const void* data, size_t size)
+{
+  s_file.write(static_cast<const char*>(data), size);
+}
+
+// Find the changes of a page, update the shadow copy and its hash
+static void AddSpans(size_t page, std::vector<Debug::StateHash::Span>& spans)
+{
+  const u8* ram = Memory::base;
+  const size_t begin = page * PAGE_SIZE;
+  const size_t end = begin + PAGE_SIZE;
+
+  for (size_t i = begin; i < end; i++) {
+    if (ram[i] == s_shadow[i])
+      continue;
+
+    if (!spans.empty() &&
+        i - (spans.back().address + spans.back().length) <= SPAN_GAP) {
+      spans.back().length = static_cast<u32>(i + 1 - spans.back().address);
+    } else {
+      spans.push_back({static_cast<u32>(i), 1});
+    }
+  }
+
+  std::memcpy(s_shadow.data() + begin, ram + begin, PAGE_SIZE);
+
+  s_pages_hash ^= s_page_hashes[page];
+  s_page_hashes[page] = HashPage(page, ram + begin);
+  s_pages_hash ^= s_page_hashes[page];
+}
+
+static void Record()
+{
+  using namespace Debug::StateHash;
+
+  const u8* ram = Memory::base;
+  const auto context = CPU::SaveContext();
+
+  Entry entry{};
+  entry.instruction = CPU::instructions;
+  entry.repeat_mode = static_cast<u16>(context.repeat_mode);
+  entry.registers[AX] = context.AX;
+  entry.registers[BX] = context.BX;
+  entry.registers[CX] = context.CX;
+  entry.registers[DX] = context.DX;
+  entry.registers[SI] = context.SI;
+  entry.registers[DI] = context.DI;
+  entry.registers[BP] = context.BP;
+  entry.registers[SP] = context.SP;
+  entry.registers[CS] = context.CS;
+  entry.registers[DS] = context.DS;
+  entry.registers[ES] = context.ES;
+  entry.registers[SS] = context.SS;
+  entry.registers[IP] = context.IP;
+  entry.registers[FLAGS] = CPU::GetFlags();
+
+  // Only pages written since the last Entry need to be hashed again
+  std::vector<Span> spans;
+
+  for (size_t page = 0; page < Memory::SIZE / PAGE_SIZE; page++) {
+    if (std::memcmp(ram + page * PAGE_SIZE,
+                    s_shadow.data() + page * PAGE_SIZE, PAGE_SIZE) != 0)
+      AddSpans(page, spans);
+  }
+
+  u64 hash = Hash::FNV1a(entry.registers);
+  hash = Hash::FNV1a(entry.repeat_mode, hash);
+
+  entry.hash = hash ^ s_pages_hash;
+  entry.spans = static_cast<u32>(spans.size());
+
+  Write(&entry, sizeof(entry));
+
+  for (const auto& span : spans) {
+    Write(&span, sizeof(span));
+    Write(ram + span.address, span.length);
+  }
+
+  s_last = CPU::instructions;
+  s_recorded = true;
+}
+
+bool Debug::StateHash::Start(const std::string& path, u64 interval, u64 from,
+                             u64 to)
+{
+  if (active)
+    Stop();
+
+  s_file.open(path, std::ios::binary | std::ios::trunc);
+
+  if (!s_file.good()) {
+    ERROR("Failed to open state hash file " + path);
+    return false;
+  }
+
+  Header header{};
+  std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+  header.version = VERSION;
+  header.ram_size = Memory::SIZE;
+  header.interval = std::max<u64>(interval, 1);
+
+  Write(&header, sizeof(header));
+
+  // Start out with empty RAM, so the first Entry contains everything else
+  s_shadow.assign(Memory::SIZE, 0);
+  s_page_hashes.resize(Memory::SIZE / PAGE_SIZE);
+  s_pages_hash = 0;
+
+  for (size_t page = 0; page < s_page_hashes.size(); page++) {
+    s_page_hashes[page] = HashPage(page, s_shadow.data());
+    s_pages_hash ^= s_page_hashes[page];
+  }
+
+  s_interval = header.interval;
+  s_next = from;
+  s_to = to;
+  s_recorded = false;
+  active = true;
+
+  return true;
+}
+
+void Debug::StateHash::Stop()
+{
+  if (!active)
+    return;
+
+  // The state a run ended with matters as much as the periodic ones
+  if (CPU::instructions <= s_to &&
+      (!s_recorded || CPU::instructions != s_last))
+    Record();
+
+  active = false;
+
+  s_file.close();
+  s_shadow = {};
+  s_page_hashes = {};
+}
+
+void Debug::StateHash::Update()
+{
+  if (!active || CPU::instructions < s_next || CPU::instructions > s_to)
+    return;
+
+  Record();
+
+  // Blocks of several instructions (e.g. in lockstep) may skip past
+  // multiples of the interval
+  s_next += (CPU::instructions - s_next) / s_interval * s_interval + s_interval;
+}
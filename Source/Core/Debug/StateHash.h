@@ -0,0 +1,95 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <string>
+
+#include "Common/Types.h"
+
+/**@brief Machine state hashes recorded into a side file
+ *
+ * Every interval instructions an Entry with the registers and a hash of the
+ * whole machine state gets written. The hash is kept up to date incrementally:
+ * It is the register hash combined with one hash per RAM page, and only pages
+ * written since the last Entry get hashed again.
+ *
+ * Every Entry is followed by the Spans of RAM that changed since the previous
+ * one, so a reader can reconstruct RAM at each Entry. The first Entry stores
+ * all RAM which isn't zero.
+ *
+ * Two files of the same program can be compared to find where the runs
+ * diverged (see ApeBisect). Recording a window at an interval of 1 narrows
+ * this down to a single instruction.
+ */
+namespace Core::Debug::StateHash
+{
+//! Registers stored in an Entry (in this order)
+enum Register : u8 {
+  AX,
+  BX,
+  CX,
+  DX,
+  SI,
+  DI,
+  BP,
+  SP,
+  CS,
+  DS,
+  ES,
+  SS,
+  IP,
+  FLAGS,
+  COUNT
+};
+
+//! Header at the beginning of every file
+struct Header {
+  char magic[8];
+  u16 version;
+  u16 reserved;
+  u32 ram_size;
+  u64 interval;
+};
+
+//! Machine state after instruction instructions
+struct Entry {
+  u64 instruction;
+  u64 hash;
+  //! Amount of Spans following this Entry
+  u32 spans;
+  //! CPU::RepeatMode of a pending REP prefix
+  u16 repeat_mode;
+  u16 registers[Register::COUNT];
+  u16 reserved[3];
+};
+
+//! Changed RAM, followed by length bytes of data
+struct Span {
+  u32 address;
+  u32 length;
+};
+
+static_assert(sizeof(Header) == 24, "Bad header size");
+static_assert(sizeof(Entry) == 56, "Bad entry size");
+static_assert(sizeof(Span) == 8, "Bad span size");
+
+constexpr char MAGIC[8] = {'A', 'P', 'E', 'H', 'A', 'S', 'H', '\0'};
+constexpr u16 VERSION = 1;
+
+//! Whether hashes are being recorded. Use Start() and Stop() to change this
+extern bool active;
+
+//! Start writing an Entry to path every interval instructions, beginning at
+//! instruction from up to instruction to
+bool Start(const std::string& path, u64 interval, u64 from = 0,
+           u64 to = UINT64_MAX);
+
+//! Write the final state and close the file
+void Stop();
+
+//! Record an Entry if one is due
+void Update();
+} // namespace Core::Debug::StateHash
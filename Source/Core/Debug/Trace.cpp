@@ -0,0 +1,506 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Debug/Trace.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "Common/Logger.h"
+#include "Common/RingBuffer.h"
+#include "Common/String.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+
+namespace
+{
+struct Block {
+  size_t size = 0;
+  std::array<u8, 0x1000> data;
+};
+} // namespace
+
+bool Debug::Trace::active = false;
+Debug::Trace::Mode Debug::Trace::mode = Debug::Trace::Mode::Full;
+
+static RingBuffer<Block, 64> s_buffer;
+static Block s_block;
+static size_t s_record_size;
+
+// Pending TAKEN bits, oldest first
+static u8 s_taken;
+static u8 s_taken_count;
+
+// Instruction count at the last SNAPSHOT
+static u64 s_begin;
+static bool s_begun;
+
+static std::ofstream s_file;
+static std::thread s_writer;
+static std::atomic<bool> s_writing;
+
+static void Flush()
+{
+  if (s_block.size == 0)
+    return;
+
+  // Never drop records, wait for the writer to catch up instead
+  while (!s_buffer.Push(s_block))
+    std::this_thread::yield();
+
+  s_block.size = 0;
+}
+
+static void Append(const void* data, size_t size)
+{
+  auto* bytes = static_cast<const u8*>(data);
+
+  while (size > 0) {
+    if (s_block.size == s_block.data.size())
+      Flush();
+
+    size_t length = std::min(size, s_block.data.size() - s_block.size);
+
+    std::memcpy(s_block.data.data() + s_block.size, bytes, length);
+    s_block.size += length;
+    bytes += length;
+    size -= length;
+  }
+}
+
+template <typename T> static void Append(const T& value)
+{
+  Append(&value, sizeof(value));
+}
+
+static void FlushTaken()
+{
+  if (s_taken_count == 0)
+    return;
+
+  Append<u8>(Debug::Trace::TAKEN | (1 << s_taken_count) | s_taken);
+
+  s_taken = 0;
+  s_taken_count = 0;
+}
+
+static void End()
+{
+  if (!s_begun)
+    return;
+
+  FlushTaken();
+  Append<u8>(Debug::Trace::END);
+  Append<u64>(CPU::instructions - s_begin);
+
+  s_begun = false;
+}
+
+static void WriterThread()
+{
+  Block block;
+
+  while (s_writing || !s_buffer.IsEmpty()) {
+    if (!s_buffer.Pop(block)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+
+    s_file.write(reinterpret_cast<const char*>(block.data.data()),
+                 block.size);
+  }
+}
+
+bool Debug::Trace::Start(const std::string& path, Mode mode)
+{
+  if (active)
+    Stop();
+
+  s_file.open(path, std::ios::binary | std::ios::trunc);
+
+  if (!s_file.good()) {
+    ERROR("Failed to open trace file " + path);
+    return false;
+  }
+
+  Header header;
+  std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+  header.version = VERSION;
+  header.flags = 0;
+  header.record_size = static_cast<u16>(offsetof(Record, registers));
+
+  if (mode == Mode::Registers) {
+    header.flags = HAS_REGISTERS;
+    header.record_size = sizeof(Record);
+  } else if (mode == Mode::Branches) {
+    header.flags = HAS_BRANCHES;
+    header.record_size = 0;
+  }
+
+  s_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  s_record_size = header.record_size;
+  s_block.size = 0;
+  s_taken = 0;
+  s_taken_count = 0;
+  s_begun = false;
+  s_writing = true;
+  s_writer = std::thread(WriterThread);
+
+  Trace::mode = mode;
+  active = true;
+
+  return true;
+}
+
+void Debug::Trace::Begin()
+{
+  if (!active || mode != Mode::Branches)
+    return;
+
+  // Execution may resume after the machine was modified (e.g. a new program
+  // got loaded), so every start gets its own snapshot
+  End();
+
+  Append<u8>(SNAPSHOT);
+  Append<u16>(CPU::CS);
+  Append<u16>(CPU::IP);
+  Append<u32>(Memory::SIZE);
+  Append(Memory::base, Memory::SIZE);
+
+  s_begin = CPU::instructions;
+  s_begun = true;
+}
+
+void Debug::Trace::Stop()
+{
+  if (!active)
+    return;
+
+  active = false;
+
+  End();
+  Flush();
+
+  s_writing = false;
+  s_writer.join();
+  s_file.close();
+}
+
+void Debug::Trace::Add(u16 cs, u16 ip, u8 length)
+{
+  if (s_block.size + s_record_size > s_block.data.size())
+    Flush();
+
+  Record record;
+
+  record.cs = cs;
+  record.ip = ip;
+  record.length = std::min<u8>(length, sizeof(record.bytes));
+
+  for (u8 i = 0; i < record.length; i++)
+    record.bytes[i] = Memory::Read<u8>(cs, static_cast<u16>(ip + i));
+
+  if (s_record_size == sizeof(Record)) {
+    record.registers[Register::AX] = CPU::AX;
+    record.registers[Register::BX] = CPU::BX;
+    record.registers[Register::CX] = CPU::CX;
+    record.registers[Register::DX] = CPU::DX;
+    record.registers[Register::SI] = CPU::SI;
+    record.registers[Register::DI] = CPU::DI;
+    record.registers[Register::BP] = CPU::BP;
+    record.registers[Register::SP] = CPU::SP;
+    record.registers[Register::DS] = CPU::DS;
+    record.registers[Register::ES] = CPU::ES;
+    record.registers[Register::SS] = CPU::SS;
+    record.registers[Register::FLAGS] = CPU::GetFlags();
+  }
+
+  std::memcpy(s_block.data.data() + s_block.size, &record, s_record_size);
+  s_block.size += s_record_size;
+}
+
+void Debug::Trace::AddBranch(const CPU::Instruction& ins, u16 next_ip)
+{
+  switch (GetBranchKind(ins)) {
+  case BranchKind::Conditional:
+    s_taken |= (CPU::IP != next_ip) << s_taken_count;
+
+    if (++s_taken_count == 6)
+      FlushTaken();
+    break;
+  case BranchKind::Indirect:
+    // Keep the stream in execution order
+    FlushTaken();
+
+    Append<u8>(TARGET);
+    Append<u16>(CPU::CS);
+    Append<u16>(CPU::IP);
+    break;
+  default:
+    break;
+  }
+}
+
+void Debug::Trace::AddInterrupt()
+{
+  if (!active || mode != Mode::Branches || !s_begun)
+    return;
+
+  FlushTaken();
+
+  Append<u8>(INTERRUPT);
+  Append<u64>(CPU::instructions - s_begin);
+  Append<u8>(TARGET);
+  Append<u16>(CPU::CS);
+  Append<u16>(CPU::IP);
+}
+
+Debug::Trace::BranchKind
+Debug::Trace::GetBranchKind(const CPU::Instruction& ins)
+{
+  using Type = CPU::Instruction::Type;
+  using PType = CPU::Instruction::Parameter::Type;
+
+  switch (ins.GetType()) {
+  case Type::JZ:
+  case Type::JNZ:
+  case Type::JC:
+  case Type::JNC:
+  case Type::JCXZ:
+  case Type::JPE:
+  case Type::JNS:
+  case Type::JNO:
+  case Type::JNE:
+  case Type::JL:
+  case Type::JLE:
+  case Type::JG:
+  case Type::JGE:
+  case Type::JA:
+  case Type::JB:
+  case Type::JNB:
+  case Type::JPO:
+  case Type::JO:
+  case Type::JS:
+  case Type::JBE:
+  case Type::LOOP:
+  case Type::LOOPZ:
+  case Type::LOOPNZ:
+    return BranchKind::Conditional;
+  case Type::JMP:
+  case Type::CALL: {
+    auto type = ins.GetParameters()[0].GetType();
+
+    if (type == PType::Literal_Offset || type == PType::Literal_WordOffset)
+      return BranchKind::Direct;
+
+    return BranchKind::Indirect;
+  }
+  case Type::RET:
+  case Type::RETF:
+  case Type::IRET:
+  case Type::INT:
+  case Type::INTO:
+  // Native handlers may change CS:IP (like waiting for a key to arrive)
+  case Type::TRAP:
+    return BranchKind::Indirect;
+  default:
+    return BranchKind::None;
+  }
+}
+
+u8 Debug::Trace::Decode(const u8* bytes, const u8* end, u16 ip,
+                        CPU::Instruction& ins)
+{
+  const u8* start = bytes;
+
+  try {
+    ins = CPU::Instruction(*bytes++, ip);
+
+    if (ins.IsPrefix() && bytes < end)
+      ins = CPU::Instruction(ins, *bytes++, ip);
+
+    if (!ins.IsResolved() && bytes < end) {
+      u8 mod = *bytes++;
+      u8 length = ins.GetLength(mod);
+
+      std::vector<u8> data(bytes, std::min(bytes + length, end));
+      data.resize(length);
+      bytes += length;
+
+      if (!ins.Resolve(mod, data))
+        return 0;
+    }
+  } catch (...) {
+    return 0;
+  }
+
+  if (ins.GetType() == CPU::Instruction::Type::Invalid)
+    return 0;
+
+  return static_cast<u8>(std::min(bytes, end) - start);
+}
+
+bool Debug::Trace::DecodeBranches(
+    std::istream& in, const std::function<bool(const Record&)>& show)
+{
+  auto Read = [&in](auto& value) {
+    return static_cast<bool>(
+        in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+  };
+
+  std::vector<u8> ram;
+  u16 cs = 0;
+  u16 ip = 0;
+  u64 end = UINT64_MAX;
+  u64 interrupt = UINT64_MAX;
+  u8 taken = 0;
+  u8 taken_count = 0;
+
+  // END directly follows the last packet of a snapshot, knowing it early
+  // tells where execution stopped after the last branch. Likewise the count
+  // of an INTERRUPT tells when to expect its TARGET
+  auto CheckEnd = [&]() {
+    if (in.peek() == END) {
+      in.get();
+      Read(end);
+    } else if (in.peek() == INTERRUPT) {
+      in.get();
+      Read(interrupt);
+    }
+  };
+
+  auto Expect = [&](u8 expected) {
+    u8 type;
+
+    if (!Read(type)) {
+      WARN("Trace ends unexpectedly at " + String::ToHex(cs) + ":" +
+           String::ToHex(ip));
+      return false;
+    }
+
+    const u8 kind = (type & TAKEN) ? static_cast<u8>(TAKEN) : type;
+
+    if (kind != expected) {
+      ERROR("Unexpected packet " + String::ToHex(type) + " at " +
+            String::ToHex(cs) + ":" + String::ToHex(ip));
+      return false;
+    }
+
+    if (type == TARGET) {
+      Read(cs);
+      Read(ip);
+    } else {
+      taken_count = 6;
+
+      while (!(type & (1 << taken_count)))
+        taken_count--;
+
+      taken = type & ((1 << taken_count) - 1);
+    }
+
+    CheckEnd();
+    return true;
+  };
+
+  u8 type;
+
+  while (Read(type)) {
+    if (type != SNAPSHOT) {
+      ERROR("Expected snapshot, got packet " + String::ToHex(type));
+      return false;
+    }
+
+    u32 size;
+
+    Read(cs);
+    Read(ip);
+    Read(size);
+    ram.resize(size);
+    in.read(reinterpret_cast<char*>(ram.data()), size);
+
+    end = UINT64_MAX;
+    interrupt = UINT64_MAX;
+    taken_count = 0;
+    CheckEnd();
+
+    if (!in.good() || size == 0) {
+      ERROR("Truncated snapshot");
+      return false;
+    }
+
+    for (u64 count = 0; count < end; count++) {
+      Record record;
+      CPU::Instruction ins;
+
+      while (count == interrupt) {
+        interrupt = UINT64_MAX;
+
+        if (!Expect(TARGET))
+          return false;
+      }
+
+      record.cs = cs;
+      record.ip = ip;
+
+      for (u8 i = 0; i < sizeof(record.bytes); i++) {
+        u32 address = (cs << 4) + static_cast<u16>(ip + i);
+        record.bytes[i] = ram[address % ram.size()];
+      }
+
+      record.length = Decode(record.bytes, std::end(record.bytes), ip, ins);
+
+      if (record.length == 0) {
+        ERROR("Failed to decode instruction at " + String::ToHex(cs) + ":" +
+              String::ToHex(ip));
+        return false;
+      }
+
+      if (!show(record))
+        return true;
+
+      // The last instruction may not have completed
+      if (count + 1 == end)
+        break;
+
+      const u16 next_ip = ip + record.length;
+      const auto& parameters = ins.GetParameters();
+
+      switch (GetBranchKind(ins)) {
+      case BranchKind::None:
+        ip = next_ip;
+        break;
+      case BranchKind::Conditional:
+        if (taken_count == 0 && !Expect(TAKEN))
+          return false;
+
+        ip = next_ip + ((taken & 1) ? parameters[0].GetData<i8>() : 0);
+        taken >>= 1;
+        taken_count--;
+        break;
+      case BranchKind::Direct:
+        if (parameters[0].GetType() ==
+            CPU::Instruction::Parameter::Type::Literal_Offset)
+          ip = next_ip + parameters[0].GetData<i8>();
+        else
+          ip = next_ip + parameters[0].GetData<u16>();
+        break;
+      case BranchKind::Indirect:
+        if (!Expect(TARGET))
+          return false;
+        break;
+      }
+    }
+  }
+
+  return true;
+}
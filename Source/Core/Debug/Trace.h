@@ -0,0 +1,147 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <functional>
+#include <istream>
+#include <string>
+
+#include "Common/Types.h"
+
+#include "Core/CPU/Instruction.h"
+
+/**@brief Binary execution trace
+ *
+ * Data is collected into blocks which get handed to a writer thread through a
+ * lock-free ring buffer, so the CPU thread never waits on I/O.
+ *
+ * Full traces store one Record per instruction. Branch traces only store a
+ * Packet stream of control flow decisions together with a snapshot of RAM, the
+ * executed path gets reconstructed by decoding the snapshot offline.
+ */
+namespace Core::Debug::Trace
+{
+enum class Mode : u8 {
+  //! One Record per instruction
+  Full,
+  //! One Record per instruction, including registers
+  Registers,
+  //! Control flow decisions only
+  Branches
+};
+
+//! Registers stored in a Record (in this order)
+enum Register : u8 { AX, BX, CX, DX, SI, DI, BP, SP, DS, ES, SS, FLAGS, COUNT };
+
+//! Header at the beginning of every trace file
+struct Header {
+  char magic[8];
+  u16 version;
+  u16 record_size;
+  u32 flags;
+};
+
+//! Header flags
+enum HeaderFlags : u32 {
+  //! Records contain registers
+  HAS_REGISTERS = 1 << 0,
+  //! File contains packets instead of records
+  HAS_BRANCHES = 1 << 1
+};
+
+//! One executed instruction
+struct Record {
+  u16 cs;
+  u16 ip;
+  //! Raw instruction bytes
+  u8 bytes[7];
+  u8 length;
+  //! Register state before execution (only present with HAS_REGISTERS)
+  u16 registers[Register::COUNT];
+};
+
+/**@brief Packet types of branch traces
+ *
+ * Every packet starts with a byte identifying it. If the top bit of that byte
+ * is set it is a TAKEN packet instead: The highest other bit set marks how
+ * many of the bits below it are taken (1) / not taken (0) decisions of
+ * conditional branches, oldest first.
+ */
+enum Packet : u8 {
+  //! u16 cs, u16 ip: Destination of an indirect branch
+  TARGET = 0x01,
+  //! u16 cs, u16 ip, u32 size, RAM: Machine state to start decoding from
+  SNAPSHOT = 0x02,
+  //! u64 count: Instructions executed since the last SNAPSHOT
+  END = 0x03,
+  //! u64 count, then a TARGET packet: A hardware interrupt entered its
+  //! handler before the instruction that many after the last SNAPSHOT
+  INTERRUPT = 0x04,
+
+  TAKEN = 0x80
+};
+
+//! How an instruction affects control flow
+enum class BranchKind : u8 {
+  //! Continues with the next instruction
+  None,
+  //! Either continues or jumps to a relative target
+  Conditional,
+  //! Always jumps to a relative target
+  Direct,
+  //! Target depends on machine state and is recorded as a TARGET packet
+  Indirect
+};
+
+static_assert(sizeof(Header) == 16, "Bad header size");
+static_assert(sizeof(Record) == 36, "Bad record size");
+
+constexpr char MAGIC[8] = {'A', 'P', 'E', 'T', 'R', 'A', 'C', 'E'};
+constexpr u16 VERSION = 2;
+
+//! Whether a trace is being recorded. Use Start() and Stop() to change this
+extern bool active;
+
+//! The Mode of the trace being recorded
+extern Mode mode;
+
+//! Start writing a trace to path
+bool Start(const std::string& path, Mode mode = Mode::Full);
+
+//! Called when the CPU starts executing
+void Begin();
+
+//! Stop tracing and flush everything to disk
+void Stop();
+
+//! Record the instruction of length bytes at cs:ip
+void Add(u16 cs, u16 ip, u8 length);
+
+//! Record the outcome of an executed instruction that would have continued at
+//! next_ip
+void AddBranch(const CPU::Instruction& ins, u16 next_ip);
+
+//! Record the delivery of a hardware interrupt, call this once CS:IP point
+//! to its handler
+void AddInterrupt();
+
+//! Classify an instruction
+BranchKind GetBranchKind(const CPU::Instruction& ins);
+
+//! Decode the instruction at ip from the bytes up to end, returns its length
+//! or 0 on failure
+u8 Decode(const u8* bytes, const u8* end, u16 ip, CPU::Instruction& ins);
+
+/**@brief Reconstruct the instructions executed in a branch trace
+ *
+ * Reads the packets following the Header from in and passes every executed
+ * instruction to show until it returns false. Instructions are decoded from
+ * the RAM snapshot, the packets only decide where execution continues after
+ * a branch or an interrupt. Returns false if the trace is malformed.
+ */
+bool DecodeBranches(std::istream& in,
+                    const std::function<bool(const Record&)>& show);
+} // namespace Core::Debug::Trace
@@ -0,0 +1,97 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/HW/IO.h"
+
+#include <array>
+#include <bitset>
+#include <vector>
+
+#include "Common/Logger.h"
+#include "Common/String.h"
+
+using namespace Core::HW;
+
+constexpr size_t PORTS = 0x10000;
+
+namespace
+{
+struct Handler {
+  IO::ReadHandler read;
+  IO::WriteHandler write;
+};
+} // namespace
+
+static std::bitset<PORTS> s_logged;
+
+static bool IsFirstAccess(u16 port)
+{
+  if (s_logged[port])
+    return false;
+
+  s_logged[port] = true;
+  return true;
+}
+
+static u8 ReadUnknown(u16 port)
+{
+  if (IsFirstAccess(port))
+    LOG("Read from unknown port " + String::ToHex(port));
+
+  return 0xFF;
+}
+
+static void WriteUnknown(u16 port, u8 value)
+{
+  if (IsFirstAccess(port))
+    LOG("Write of " + String::ToHex(value) + " to unknown port " +
+        String::ToHex(port));
+}
+
+// Index into s_handlers for every port, 0 is the default handler
+static std::array<u8, PORTS> s_ports;
+static std::vector<Handler> s_handlers = {{ReadUnknown, WriteUnknown}};
+
+void IO::Reset()
+{
+  s_ports.fill(0);
+  s_handlers = {{ReadUnknown, WriteUnknown}};
+  s_logged.reset();
+}
+
+void IO::RegisterPortHandler(PortRange range, ReadHandler read,
+                             WriteHandler write)
+{
+  // Handlers only ever get added, devices register once per Init()
+  if (s_handlers.size() > 0xFF) {
+    ERROR("Too many port handlers");
+    return;
+  }
+
+  s_handlers.push_back({read, write});
+
+  for (u32 port = range.first; port <= range.last; port++)
+    s_ports[port] = static_cast<u8>(s_handlers.size() - 1);
+}
+
+u8 IO::Read(u16 port) { return s_handlers[s_ports[port]].read(port); }
+
+u16 IO::ReadWord(u16 port)
+{
+  const u8 low = Read(port);
+  const u8 high = Read(static_cast<u16>(port + 1));
+
+  return static_cast<u16>(low | high << 8);
+}
+
+void IO::Write(u16 port, u8 value)
+{
+  s_handlers[s_ports[port]].write(port, value);
+}
+
+void IO::WriteWord(u16 port, u16 value)
+{
+  Write(port, static_cast<u8>(value));
+  Write(static_cast<u16>(port + 1), static_cast<u8>(value >> 8));
+}
@@ -0,0 +1,44 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include "Common/Types.h"
+
+/**@brief I/O port address space
+ *
+ * Devices register handlers for the ports they decode. Every port maps to
+ * one handler through a table, so an access costs two array lookups and an
+ * indirect call. Ports nobody registered read as FFh and ignore writes,
+ * each of them gets logged the first time it is used.
+ *
+ * The 8088 has an 8 bit bus, so word accesses are two byte accesses: The
+ * low byte at port, the high byte at port + 1.
+ */
+namespace Core::HW::IO
+{
+using ReadHandler = u8 (*)(u16 port);
+using WriteHandler = void (*)(u16 port, u8 value);
+
+//! Ports first to last (inclusive)
+struct PortRange {
+  u16 first;
+  u16 last;
+};
+
+//! Remove all handlers
+void Reset();
+
+//! Route accesses to the ports of range to read and write. Later
+//! registrations replace earlier ones
+void RegisterPortHandler(PortRange range, ReadHandler read,
+                         WriteHandler write);
+
+u8 Read(u16 port);
+u16 ReadWord(u16 port);
+
+void Write(u16 port, u8 value);
+void WriteWord(u16 port, u16 value);
+} // namespace Core::HW::IO
@@ -0,0 +1,222 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/HW/Keyboard.h"
+
+#include "Common/Logger.h"
+#include "Common/RingBuffer.h"
+#include "Common/String.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/Debug/Checkpoint.h"
+#include "Core/HW/IO.h"
+#include "Core/HW/PIC.h"
+#include "Core/Scheduler.h"
+
+using namespace Core;
+using namespace Core::HW;
+
+constexpr u16 DATA_PORT = 0x60;
+constexpr u16 STATUS_PORT = 0x64;
+
+// Bits of the status port
+constexpr u8 OUTPUT_FULL = 1 << 0;
+constexpr u8 SELF_TEST_PASSED = 1 << 2;
+constexpr u8 NOT_INHIBITED = 1 << 4;
+
+// Reply of the keyboard to command bytes
+constexpr u8 ACKNOWLEDGE = 0xFA;
+
+constexpr u8 RELEASED = 0x80;
+constexpr u8 CONTROL = 0x1D;
+constexpr u8 LEFT_SHIFT = 0x2A;
+
+// Cycles between two looks at the queue (1 ms)
+constexpr u64 POLL_INTERVAL = Scheduler::FREQUENCY / 1000;
+
+// Characters of the keys of the US layout by scan code, without and with
+// shift
+constexpr char NORMAL[] = "\0\x1b"
+                          "1234567890-=\b\t"
+                          "qwertyuiop[]\r\0"
+                          "asdfghjkl;'`\0\\"
+                          "zxcvbnm,./\0*\0 ";
+constexpr char SHIFTED[] = "\0\x1b"
+                           "!@#$%^&*()_+\b\t"
+                           "QWERTYUIOP{}\r\0"
+                           "ASDFGHJKL:\"~\0|"
+                           "ZXCVBNM<>?\0*\0 ";
+
+static_assert(sizeof(NORMAL) == sizeof(SHIFTED), "Layouts differ in size");
+
+namespace
+{
+struct State {
+  u8 output;
+  bool full;
+};
+} // namespace
+
+// Keys with a character (the terminator isn't one)
+constexpr u8 KEYS = sizeof(NORMAL) - 1;
+
+constexpr size_t QUEUE_SIZE = 256;
+
+// Scan codes pushed by the frontend, taken out by the emulation thread
+static RingBuffer<u8, QUEUE_SIZE> s_queue;
+
+// Byte waiting in the output buffer for the guest to read port 60h
+static u8 s_output;
+static bool s_full;
+
+static void Latch(u8 value)
+{
+  s_output = value;
+  s_full = true;
+
+  PIC::RaiseIRQ(1);
+}
+
+static void Poll()
+{
+  Keyboard::Update();
+  Scheduler::ScheduleIn(POLL_INTERVAL, Poll);
+}
+
+static u8 Read(u16 port)
+{
+  if (port == STATUS_PORT)
+    return SELF_TEST_PASSED | NOT_INHIBITED | (s_full ? OUTPUT_FULL : 0);
+
+  s_full = false;
+  return s_output;
+}
+
+static void Write(u16 port, u8 value)
+{
+  // Commands (like setting the LEDs) have no effect, but programs wait for
+  // the keyboard to acknowledge them
+  if (port == DATA_PORT) {
+    Latch(ACKNOWLEDGE);
+    return;
+  }
+
+  LOG("[Keyboard] Ignoring controller command " + String::ToHex(value));
+}
+
+void Keyboard::Init()
+{
+  IO::RegisterPortHandler({DATA_PORT, DATA_PORT}, Read, Write);
+  IO::RegisterPortHandler({STATUS_PORT, STATUS_PORT}, Read, Write);
+
+  s_output = 0;
+  s_full = false;
+
+  Scheduler::ScheduleIn(POLL_INTERVAL, Poll);
+}
+
+void Keyboard::Update()
+{
+  u8 code;
+
+  if (s_full)
+    return;
+
+  if (Debug::Checkpoint::IsReplaying()) {
+    if (Debug::Checkpoint::TakeKey(code))
+      Latch(code);
+
+    return;
+  }
+
+  if (!s_queue.Pop(code))
+    return;
+
+  Debug::Checkpoint::RecordKey(code);
+  Latch(code);
+}
+
+bool Keyboard::Push(u8 code)
+{
+  if (!s_queue.Push(code))
+    return false;
+
+  CPU::Wake();
+  return true;
+}
+
+bool Keyboard::PushChar(char c)
+{
+  // Both end a line
+  if (c == '\n')
+    c = '\r';
+
+  u8 code = GetScanCode(c);
+  u8 modifier = 0;
+
+  if (code != 0 && NORMAL[code] != c) {
+    modifier = LEFT_SHIFT;
+  } else if (code == 0 && c >= 0x01 && c <= 0x1A) {
+    modifier = CONTROL;
+    code = GetScanCode(static_cast<char>(c - 0x01 + 'a'));
+  }
+
+  if (code == 0) {
+    LOG("[Keyboard] No key types " + String::ToHex(static_cast<u8>(c)));
+    return true;
+  }
+
+  u8 codes[4];
+  size_t count = 0;
+
+  if (modifier != 0)
+    codes[count++] = modifier;
+
+  codes[count++] = code;
+  codes[count++] = code | RELEASED;
+
+  if (modifier != 0)
+    codes[count++] = modifier | RELEASED;
+
+  // Only the consumer frees up space, so it can't get less in between
+  if (QUEUE_SIZE - s_queue.Size() < count)
+    return false;
+
+  for (size_t i = 0; i < count; i++)
+    s_queue.Push(codes[i]);
+
+  CPU::Wake();
+  return true;
+}
+
+u8 Keyboard::GetScanCode(char c)
+{
+  if (c == '\0')
+    return 0;
+
+  for (u8 code = 0; code < KEYS; code++) {
+    if (NORMAL[code] == c || SHIFTED[code] == c)
+      return code;
+  }
+
+  return 0;
+}
+
+char Keyboard::ToChar(u8 code, bool shift)
+{
+  if (code >= KEYS)
+    return 0;
+
+  return shift ? SHIFTED[code] : NORMAL[code];
+}
+
+std::any Keyboard::SaveState() { return State{s_output, s_full}; }
+
+void Keyboard::LoadState(const std::any& state)
+{
+  const auto& saved = std::any_cast<const State&>(state);
+
+  s_output = saved.output;
+  s_full = saved.full;
+}
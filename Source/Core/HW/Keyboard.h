@@ -0,0 +1,55 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <any>
+
+#include "Common/Types.h"
+
+/**@brief Keyboard and its controller (ports 60h and 64h)
+ *
+ * The frontend pushes scan codes (set 1, bit 7 set for a released key) into
+ * a lock-free queue from its own thread. The emulation thread takes them out
+ * one at a time: Whenever the guest has read the previous one from port 60h,
+ * the next one is latched there and raises IRQ1. The queue is looked at
+ * every millisecond of emulated time and right away when a push wakes up a
+ * halted CPU, so keys reach the guest within a millisecond.
+ *
+ * Turning scan codes into characters is up to the keyboard interrupt of the
+ * BIOS, which uses the US layout of ToChar().
+ */
+namespace Core::HW::Keyboard
+{
+//! Register the ports and start polling the queue. Keys queued before are
+//! kept, so input can be typed ahead of booting
+void Init();
+
+//! Latch the next queued scan code if the guest read the previous one.
+//! While Debug::Checkpoint replays, the code latched at this point before
+//! gets latched instead and the queue is left alone
+void Update();
+
+//! Queue a scan code. Only ever call this from one thread. Returns false if
+//! the queue is full
+bool Push(u8 code);
+
+//! Queue the key presses typing c, holding shift or control if needed.
+//! Characters no key produces are dropped. Only ever call this from the
+//! thread calling Push(). Returns false if the queue is full
+bool PushChar(char c);
+
+//! Key producing c with or without shift, 0 if there is none
+u8 GetScanCode(char c);
+
+//! Character of a key, 0 if it has none (like the function keys)
+char ToChar(u8 code, bool shift);
+
+//! Copy of the output buffer, not of the queue (see Debug::Checkpoint)
+std::any SaveState();
+
+//! Go back to a state returned by SaveState()
+void LoadState(const std::any& state);
+} // namespace Core::HW::Keyboard
@@ -0,0 +1,224 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/HW/PIC.h"
+
+#include "Common/Logger.h"
+#include "Common/String.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/HW/IO.h"
+
+using namespace Core;
+using namespace Core::HW;
+
+constexpr u16 COMMAND_PORT = 0x20;
+constexpr u16 DATA_PORT = 0x21;
+
+// IRQ of the lowest priority, also reported for spurious interrupts
+constexpr u8 LOWEST = 7;
+
+namespace
+{
+//! Initialization command word the controller waits for
+enum class Init : u8 { None, ICW2, ICW3, ICW4 };
+
+struct State {
+  u8 irr, isr, imr;
+  u8 base;
+  bool auto_eoi, read_isr;
+  Init init;
+  bool single, icw4;
+};
+} // namespace
+
+// Requested, in service and masked IRQs
+static u8 s_irr;
+static u8 s_isr;
+static u8 s_imr;
+
+static u8 s_base;
+static bool s_auto_eoi;
+static bool s_read_isr;
+
+static Init s_init;
+static bool s_single;
+static bool s_icw4;
+
+// IRQs of a higher priority than every one in service
+static u8 GetUnblocked()
+{
+  if (s_isr == 0)
+    return 0xFF;
+
+  // Bits below the lowest set one
+  return static_cast<u8>((s_isr & -s_isr) - 1);
+}
+
+static u8 GetDeliverable() { return s_irr & ~s_imr & GetUnblocked(); }
+
+static void Update()
+{
+  if (GetDeliverable() != 0)
+    CPU::events |= CPU::EVENT_INTERRUPT;
+  else
+    CPU::events &= ~CPU::EVENT_INTERRUPT;
+}
+
+static u8 GetHighest(u8 irqs)
+{
+  u8 irq = 0;
+
+  while (irq < LOWEST && (irqs & (1 << irq)) == 0)
+    irq++;
+
+  return irq;
+}
+
+static void WriteCommand(u8 value)
+{
+  // ICW1
+  if (value & 0x10) {
+    s_single = value & 0x02;
+    s_icw4 = value & 0x01;
+
+    if (value & 0x08)
+      WARN("[PIC] Level triggered mode is not supported");
+
+    s_irr = s_isr = s_imr = 0;
+    s_auto_eoi = false;
+    s_read_isr = false;
+    s_init = Init::ICW2;
+    return;
+  }
+
+  // OCW3
+  if (value & 0x08) {
+    if (value & 0x02)
+      s_read_isr = value & 0x01;
+
+    if (value & 0x04)
+      WARN("[PIC] Poll mode is not supported");
+
+    return;
+  }
+
+  // OCW2
+  switch (value >> 5) {
+  case 0b001: // Non-specific EOI
+  case 0b101: // Rotate on non-specific EOI
+    if (s_isr != 0)
+      s_isr &= ~(1 << GetHighest(s_isr));
+    break;
+  case 0b011: // Specific EOI
+  case 0b111: // Rotate on specific EOI
+    s_isr &= ~(1 << (value & 0b111));
+    break;
+  case 0b010: // No operation
+    break;
+  default:
+    LOG("[PIC] Ignoring priority command " + String::ToHex(value));
+    break;
+  }
+}
+
+static void WriteData(u8 value)
+{
+  switch (s_init) {
+  case Init::ICW2:
+    s_base = value & 0xF8;
+    s_init = !s_single ? Init::ICW3 : s_icw4 ? Init::ICW4 : Init::None;
+    break;
+  case Init::ICW3:
+    // There is no second controller to cascade to
+    s_init = s_icw4 ? Init::ICW4 : Init::None;
+    break;
+  case Init::ICW4:
+    s_auto_eoi = value & 0x02;
+    s_init = Init::None;
+    break;
+  default: // OCW1
+    s_imr = value;
+    break;
+  }
+}
+
+void PIC::Init()
+{
+  IO::RegisterPortHandler({COMMAND_PORT, DATA_PORT}, Read, Write);
+
+  // What the BIOS does: Edge triggered, single, vectors 08h-0Fh and only
+  // the timer, keyboard and floppy unmasked
+  Write(COMMAND_PORT, 0x13);
+  Write(DATA_PORT, 0x08);
+  Write(DATA_PORT, 0x09);
+  Write(DATA_PORT, 0xBC);
+}
+
+void PIC::RaiseIRQ(u8 irq)
+{
+  s_irr |= 1 << irq;
+  Update();
+}
+
+u8 PIC::Acknowledge()
+{
+  const u8 deliverable = GetDeliverable();
+
+  // The request went away in the meantime
+  if (deliverable == 0)
+    return s_base + LOWEST;
+
+  const u8 irq = GetHighest(deliverable);
+
+  s_irr &= ~(1 << irq);
+
+  if (!s_auto_eoi)
+    s_isr |= 1 << irq;
+
+  Update();
+
+  return s_base + irq;
+}
+
+u8 PIC::Read(u16 port)
+{
+  if (port == COMMAND_PORT)
+    return s_read_isr ? s_isr : s_irr;
+
+  return s_imr;
+}
+
+void PIC::Write(u16 port, u8 value)
+{
+  if (port == COMMAND_PORT)
+    WriteCommand(value);
+  else
+    WriteData(value);
+
+  Update();
+}
+
+std::any PIC::SaveState()
+{
+  return State{s_irr,      s_isr,  s_imr,    s_base, s_auto_eoi,
+               s_read_isr, s_init, s_single, s_icw4};
+}
+
+void PIC::LoadState(const std::any& state)
+{
+  const auto& saved = std::any_cast<const State&>(state);
+
+  s_irr = saved.irr;
+  s_isr = saved.isr;
+  s_imr = saved.imr;
+  s_base = saved.base;
+  s_auto_eoi = saved.auto_eoi;
+  s_read_isr = saved.read_isr;
+  s_init = saved.init;
+  s_single = saved.single;
+  s_icw4 = saved.icw4;
+
+  Update();
+}
@@ -0,0 +1,45 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <any>
+
+#include "Common/Types.h"
+
+/**@brief 8259 Programmable Interrupt Controller
+ *
+ * Devices raise IRQs 0-7 here. Requests that aren't masked and have a
+ * higher priority (lower number) than every IRQ in service set
+ * CPU::EVENT_INTERRUPT, so the CPU only looks at the controller when there
+ * is something to deliver. Handlers signal the end of an interrupt through
+ * port 20h.
+ *
+ * Only the fixed priority order is supported, rotation commands are
+ * treated like a plain end of interrupt.
+ */
+namespace Core::HW::PIC
+{
+//! Reset the controller to how the BIOS initializes it (IRQ 0 is vector 08h)
+void Init();
+
+//! Signal a rising edge on an IRQ line
+void RaiseIRQ(u8 irq);
+
+//! Accept the highest priority request and get its vector
+u8 Acknowledge();
+
+//! Read one of the ports 20h and 21h
+u8 Read(u16 port);
+
+//! Write one of the ports 20h and 21h
+void Write(u16 port, u8 value);
+
+//! Copy of the registers (see Debug::Checkpoint)
+std::any SaveState();
+
+//! Go back to a state returned by SaveState()
+void LoadState(const std::any& state);
+} // namespace Core::HW::PIC
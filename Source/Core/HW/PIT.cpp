@@ -0,0 +1,356 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/HW/PIT.h"
+
+#include <array>
+#include <optional>
+
+#include "Common/Logger.h"
+
+#include "Core/HW/IO.h"
+#include "Core/HW/PIC.h"
+#include "Core/Scheduler.h"
+
+using namespace Core;
+using namespace Core::HW;
+
+constexpr u16 COUNTER_PORT = 0x40;
+constexpr u16 CONTROL_PORT = 0x43;
+constexpr u16 SPEAKER_PORT = 0x61;
+
+// Bits of the speaker port
+constexpr u8 GATE_2 = 1 << 0;
+constexpr u8 SPEAKER_DATA = 1 << 1;
+constexpr u8 REFRESH = 1 << 4;
+constexpr u8 OUT_2 = 1 << 5;
+
+namespace
+{
+enum class Access : u8 { Latch, Low, High, LowHigh };
+
+struct Channel {
+  u8 mode = 0;
+  Access access = Access::LowHigh;
+
+  //! Value the counter starts from, 0 counts 65536
+  u16 reload = 0;
+  //! Whether the counter has been loaded and is counting
+  bool counting = false;
+  //! Tick the counter was loaded at
+  u64 start = 0;
+
+  bool gate = true;
+
+  //! Which byte a LowHigh access reads or writes next
+  bool read_high = false;
+  bool write_high = false;
+  //! Low byte of a LowHigh write that hasn't been completed
+  u8 low = 0;
+
+  std::optional<u16> latch;
+
+  //! Pending IRQ event and the terminal counts raised so far
+  std::optional<Scheduler::EventID> event;
+  u64 periods = 0;
+};
+
+struct State {
+  std::array<Channel, 3> channels;
+  u8 speaker;
+};
+} // namespace
+
+static std::array<Channel, 3> s_channels;
+static u8 s_speaker;
+
+// Conversion between cycles and ticks of the counters, split so the
+// products can't overflow
+static u64 CyclesToTicks(u64 cycles)
+{
+  return cycles / Scheduler::FREQUENCY * PIT::FREQUENCY +
+         cycles % Scheduler::FREQUENCY * PIT::FREQUENCY /
+             Scheduler::FREQUENCY;
+}
+
+// First cycle at which tick ticks has been reached
+static u64 TicksToCycles(u64 ticks)
+{
+  const u64 rest = ticks % PIT::FREQUENCY * Scheduler::FREQUENCY;
+
+  return ticks / PIT::FREQUENCY * Scheduler::FREQUENCY +
+         (rest + PIT::FREQUENCY - 1) / PIT::FREQUENCY;
+}
+
+static u64 Now() { return CyclesToTicks(Scheduler::cycles); }
+
+static u32 GetPeriod(const Channel& channel)
+{
+  return channel.reload == 0 ? 0x10000 : channel.reload;
+}
+
+// Modes 1 and 5 wait for a rising gate, which only exists on channel 2.
+// They are treated like modes 0 and 4 started by the load
+static bool IsPeriodic(const Channel& channel)
+{
+  return channel.mode == 2 || channel.mode == 3;
+}
+
+static u64 GetElapsed(const Channel& channel) { return Now() - channel.start; }
+
+static u16 GetCount(const Channel& channel)
+{
+  if (!channel.counting)
+    return channel.reload;
+
+  const u64 elapsed = GetElapsed(channel);
+  const u32 period = GetPeriod(channel);
+
+  switch (channel.mode) {
+  case 2:
+    return static_cast<u16>(period - elapsed % period);
+  case 3:
+    // Square waves count down by two, twice per period
+    return static_cast<u16>((period - elapsed * 2 % period) & ~1u);
+  default:
+    return static_cast<u16>(period - elapsed);
+  }
+}
+
+static bool GetOutput(const Channel& channel)
+{
+  if (!channel.counting)
+    return channel.mode != 0;
+
+  const u64 elapsed = GetElapsed(channel);
+  const u32 period = GetPeriod(channel);
+
+  switch (channel.mode) {
+  case 2:
+    return elapsed % period != period - 1;
+  case 3:
+    return elapsed % period < (period + 1) / 2;
+  case 4:
+  case 5:
+    return elapsed != period;
+  default:
+    return elapsed >= period;
+  }
+}
+
+static void ScheduleIRQ(Channel& channel)
+{
+  const u64 tick = channel.start + (channel.periods + 1) * GetPeriod(channel);
+
+  channel.event = Scheduler::Schedule(TicksToCycles(tick), [&channel] {
+    channel.event.reset();
+    channel.periods++;
+
+    PIC::RaiseIRQ(0);
+
+    if (IsPeriodic(channel))
+      ScheduleIRQ(channel);
+  });
+}
+
+static void Start(u8 index)
+{
+  Channel& channel = s_channels[index];
+
+  if (channel.event)
+    Scheduler::Cancel(*channel.event);
+
+  channel.event.reset();
+  channel.periods = 0;
+  channel.start = Now();
+  channel.counting = channel.gate;
+
+  // Only channel 0 is wired to an interrupt
+  if (index == 0 && channel.counting)
+    ScheduleIRQ(channel);
+}
+
+static void SetGate(u8 index, bool gate)
+{
+  Channel& channel = s_channels[index];
+
+  if (gate == channel.gate)
+    return;
+
+  channel.gate = gate;
+
+  // A rising gate restarts the count, a falling one stops it
+  if (gate)
+    Start(index);
+  else
+    channel.counting = false;
+}
+
+static void WriteControl(u8 value)
+{
+  const u8 index = value >> 6;
+
+  if (index == 3) {
+    LOG("[PIT] Ignoring a read-back command, this is an 8253");
+    return;
+  }
+
+  Channel& channel = s_channels[index];
+  const auto access = static_cast<Access>((value >> 4) & 0b11);
+
+  if (access == Access::Latch) {
+    if (!channel.latch)
+      channel.latch = GetCount(channel);
+    return;
+  }
+
+  if (value & 1)
+    WARN("[PIT] BCD counting is not supported");
+
+  // Modes 6 and 7 are aliases of 2 and 3
+  channel.mode = (value >> 1) & 0b111;
+  if (channel.mode > 5)
+    channel.mode -= 4;
+
+  channel.access = access;
+  channel.read_high = channel.write_high = false;
+  channel.latch.reset();
+
+  // Programming a channel stops it until a count is loaded
+  if (channel.event)
+    Scheduler::Cancel(*channel.event);
+
+  channel.event.reset();
+  channel.counting = false;
+}
+
+static void WriteCounter(u8 index, u8 value)
+{
+  Channel& channel = s_channels[index];
+
+  switch (channel.access) {
+  case Access::Low:
+    channel.reload = value;
+    break;
+  case Access::High:
+    channel.reload = static_cast<u16>(value << 8);
+    break;
+  default:
+    channel.write_high = !channel.write_high;
+
+    // Mode 0 stops counting while the count is half written
+    if (channel.write_high) {
+      channel.low = value;
+
+      if (channel.mode == 0)
+        channel.counting = false;
+
+      return;
+    }
+
+    channel.reload = static_cast<u16>(channel.low | value << 8);
+    break;
+  }
+
+  Start(index);
+}
+
+static u8 ReadCounter(u8 index)
+{
+  Channel& channel = s_channels[index];
+  const u16 count = channel.latch ? *channel.latch : GetCount(channel);
+
+  switch (channel.access) {
+  case Access::Low:
+    channel.latch.reset();
+    return static_cast<u8>(count);
+  case Access::High:
+    channel.latch.reset();
+    return static_cast<u8>(count >> 8);
+  default:
+    channel.read_high = !channel.read_high;
+
+    if (channel.read_high)
+      return static_cast<u8>(count);
+
+    channel.latch.reset();
+    return static_cast<u8>(count >> 8);
+  }
+}
+
+void PIT::Init()
+{
+  s_channels = {};
+  s_speaker = 0;
+
+  IO::RegisterPortHandler({COUNTER_PORT, CONTROL_PORT}, Read, Write);
+  IO::RegisterPortHandler({SPEAKER_PORT, SPEAKER_PORT}, Read, Write);
+
+  // Channel 2 only counts while port 61h enables it
+  s_channels[2].gate = false;
+
+  // The BIOS sets up the system tick and DRAM refresh
+  WriteControl(0b00'11'011'0);
+  WriteCounter(0, 0x00);
+  WriteCounter(0, 0x00);
+
+  WriteControl(0b01'01'010'0);
+  WriteCounter(1, 18);
+}
+
+u8 PIT::Read(u16 port)
+{
+  if (port == SPEAKER_PORT) {
+    // Refresh toggles with every period of channel 1
+    const Channel& refresh = s_channels[1];
+    const bool toggle =
+        refresh.counting && GetElapsed(refresh) / GetPeriod(refresh) % 2 != 0;
+
+    return static_cast<u8>((s_speaker & (GATE_2 | SPEAKER_DATA)) |
+                           (toggle ? REFRESH : 0) |
+                           (GetOutput(s_channels[2]) ? OUT_2 : 0));
+  }
+
+  if (port == CONTROL_PORT)
+    return 0xFF;
+
+  return ReadCounter(static_cast<u8>(port - COUNTER_PORT));
+}
+
+void PIT::Write(u16 port, u8 value)
+{
+  if (port == SPEAKER_PORT) {
+    s_speaker = value;
+    SetGate(2, value & GATE_2);
+    return;
+  }
+
+  if (port == CONTROL_PORT) {
+    WriteControl(value);
+    return;
+  }
+
+  WriteCounter(static_cast<u8>(port - COUNTER_PORT), value);
+}
+
+u32 PIT::GetSpeakerFrequency()
+{
+  const Channel& channel = s_channels[2];
+
+  if ((s_speaker & (GATE_2 | SPEAKER_DATA)) != (GATE_2 | SPEAKER_DATA) ||
+      !channel.counting || channel.mode != 3)
+    return 0;
+
+  return static_cast<u32>(FREQUENCY / GetPeriod(channel));
+}
+
+std::any PIT::SaveState() { return State{s_channels, s_speaker}; }
+
+void PIT::LoadState(const std::any& state)
+{
+  const auto& saved = std::any_cast<const State&>(state);
+
+  s_channels = saved.channels;
+  s_speaker = saved.speaker;
+}
@@ -0,0 +1,46 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <any>
+
+#include "Common/Types.h"
+
+/**@brief 8253 Programmable Interval Timer
+ *
+ * Channel 0 raises IRQ0 (the BIOS tick), channel 1 refreshes DRAM and
+ * channel 2 drives the speaker. The counters aren't clocked one by one:
+ * Their values and outputs are computed from the cycles elapsed since they
+ * were loaded, and IRQ0 is an event of the Scheduler. Timing therefore only
+ * depends on the instructions executed, not on the host.
+ *
+ * Port 61h (the speaker control bits of the 8255) gates channel 2 and
+ * switches the speaker on.
+ */
+namespace Core::HW::PIT
+{
+//! Input clock of the counters in Hz
+constexpr u64 FREQUENCY = 1'193'182;
+
+//! Reset the counters to how the BIOS programs them (18.2 Hz on channel 0)
+void Init();
+
+//! Read one of the ports 40h-43h and 61h
+u8 Read(u16 port);
+
+//! Write one of the ports 40h-43h and 61h
+void Write(u16 port, u8 value);
+
+//! Frequency the speaker plays in Hz, 0 if it is silent
+u32 GetSpeakerFrequency();
+
+//! Copy of the counters and port 61h. Their IRQ events belong to the
+//! Scheduler, so save and load its state along with this one
+std::any SaveState();
+
+//! Go back to a state returned by SaveState()
+void LoadState(const std::any& state);
+} // namespace Core::HW::PIT
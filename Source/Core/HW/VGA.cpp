@@ -4,23 +4,88 @@
 
 #include "Core/HW/VGA.h"
 
+#include <algorithm>
+#include <array>
+
 #include "Common/Logger.h"
 #include "Common/String.h"
 
 #include "Core/Core.h"
 #include "Core/Memory.h"
+#include "Core/Scheduler.h"
 
 Core::HW::VGABackend* g_VGABackend = nullptr;
 
+using namespace Core;
 using namespace Core::HW;
 
+// Text buffer at B000:8000
+constexpr u32 BUFFER = 0xB8000;
+constexpr u32 BUFFER_SIZE = 0x8000;
+
+// Cycles between two screen updates (60 Hz)
+constexpr u64 REFRESH_INTERVAL = Scheduler::FREQUENCY / 60;
+
+constexpr u32 CELLS = VGA::COLUMNS * VGA::ROWS;
+
+namespace
+{
+//! Changed columns of a row, none if first is past last
+struct Span {
+  u8 first = VGA::COLUMNS;
+  u8 last = 0;
+};
+} // namespace
+
+static std::array<Span, VGA::ROWS> s_rows;
+static bool s_dirty = false;
+
+// Reused by every update, so updating doesn't allocate
+static std::vector<VGA::Change> s_changes;
+
+// Mark cells first to last (inclusive, counted from the top left) as changed
+static void MarkCells(u32 first, u32 last)
+{
+  last = std::min(last, CELLS - 1);
+
+  for (u32 cell = first; cell <= last;) {
+    const u32 row = cell / VGA::COLUMNS;
+    const u32 end = std::min(last, (row + 1) * VGA::COLUMNS - 1);
+
+    Span& span = s_rows[row];
+    span.first = std::min(span.first, static_cast<u8>(cell % VGA::COLUMNS));
+    span.last = std::max(span.last, static_cast<u8>(end % VGA::COLUMNS));
+
+    s_dirty = true;
+    cell = end + 1;
+  }
+}
+
+static void Refresh()
+{
+  VGA::Update();
+  Scheduler::ScheduleIn(REFRESH_INTERVAL, Refresh);
+}
+
 void VGA::Init()
 {
+  Memory::Device device;
+  // Every cell is a character and its attribute. Only the first page is
+  // shown, writes to the others don't change anything
+  device.write = [](u32 address, const u8*, u32 size) {
+    const u32 offset = address - BUFFER;
+    MarkCells(offset / 2, (offset + size - 1) / 2);
+  };
+  Memory::MapDevice(BUFFER, BUFFER_SIZE, device);
+
   for (size_t y = 0; y < 25; y++)
     for (size_t x = 0; x < 80; x++) {
       GetBuffer()[(y * 80 + x) * sizeof(u16)] = ' ';
       GetBuffer()[(y * 80 + x) * sizeof(u16) + 1] = 0x0F;
     }
+
+  Invalidate();
+  Scheduler::ScheduleIn(REFRESH_INTERVAL, Refresh);
 }
 
 bool VGA::IsPresent() { return g_VGABackend != nullptr; }
@@ -33,8 +98,31 @@ void VGA::SetMode(u8 mode)
 
 void VGA::Update()
 {
-  if (IsPresent())
-    g_VGABackend->Update();
+  if (!IsPresent() || !s_dirty)
+    return;
+
+  s_changes.clear();
+
+  for (u8 row = 0; row < ROWS; row++) {
+    Span& span = s_rows[row];
+
+    if (span.first > span.last)
+      continue;
+
+    s_changes.push_back({row, span.first, span.last});
+    span = {};
+  }
+
+  s_dirty = false;
+  g_VGABackend->Update(s_changes);
 }
 
-u8* VGA::GetBuffer() { return Memory::GetPtr<u8>(0xB000, 0x8000); }
+u8* VGA::GetBuffer() { return Memory::base + BUFFER; }
+
+void VGA::Invalidate() { MarkCells(0, CELLS - 1); }
+
+void VGA::Invalidate(u8 row, u8 column)
+{
+  if (row < ROWS && column < COLUMNS)
+    MarkCells(row * COLUMNS + column, row * COLUMNS + column);
+}
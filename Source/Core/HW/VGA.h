@@ -4,26 +4,53 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Common/Types.h"
 
 namespace Core::HW
 {
 namespace VGA
 {
+//! Size of the text screen in cells
+constexpr u8 COLUMNS = 80;
+constexpr u8 ROWS = 25;
+
+//! Cells of a row that changed, columns first to last (inclusive)
+struct Change {
+  u8 row;
+  u8 first;
+  u8 last;
+};
+
 void Init();
+
+//! Pass the cells which changed since the last update to the backend. Does
+//! nothing if the screen didn't change
 void Update();
 
 bool IsPresent();
 
 void SetMode(u8 mode);
+
+//! Text buffer. Writes through it don't go through the memory map, so
+//! Invalidate() has to be called afterwards
 u8* GetBuffer();
+
+//! Mark the screen as changed
+void Invalidate();
+
+//! Mark one cell as changed
+void Invalidate(u8 row, u8 column);
 } // namespace VGA
 
 class VGABackend
 {
 public:
   virtual void SetMode(u8 mode) = 0;
-  virtual void Update() = 0;
+
+  //! Redraw the cells that changed, ordered by row
+  virtual void Update(const std::vector<VGA::Change>& changes) = 0;
 };
 } // namespace Core::HW
 
@@ -0,0 +1,363 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/MSDOS/EMS.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Common/Logger.h"
+#include "Common/String.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+using namespace Core::MSDOS;
+
+constexpr u32 PAGE_SIZE = Memory::EXTRA_PAGE_SIZE;
+
+// Handle 0 belongs to the operating system and always exists
+constexpr u16 MAX_HANDLES = 255;
+
+constexpr u16 UNMAPPED = 0xFFFF;
+
+// Status codes returned in AH
+enum Status : u8 {
+  OK = 0x00,
+  INVALID_HANDLE = 0x83,
+  UNDEFINED_FUNCTION = 0x84,
+  NO_HANDLES = 0x85,
+  SAVE_ERROR = 0x86,
+  NOT_ENOUGH_PAGES = 0x87,
+  NOT_ENOUGH_FREE_PAGES = 0x88,
+  ZERO_PAGES = 0x89,
+  BAD_LOGICAL_PAGE = 0x8A,
+  BAD_PHYSICAL_PAGE = 0x8B,
+  ALREADY_SAVED = 0x8D,
+  NOT_SAVED = 0x8E,
+  BAD_SUBFUNCTION = 0x8F
+};
+
+namespace
+{
+//! Logical page of a handle shown by a physical page
+struct Mapping {
+  u16 handle = UNMAPPED;
+  u16 page = UNMAPPED;
+};
+
+using FrameMap = std::array<Mapping, EMS::FRAME_PAGES>;
+
+struct Handle {
+  bool used = false;
+  //! Pages of the pool
+  std::vector<u16> pages;
+  //! Page frame stored by function 47h
+  bool saved = false;
+  FrameMap saved_map;
+};
+
+struct State {
+  std::vector<u16> free;
+  std::vector<Handle> handles;
+  FrameMap frame;
+};
+} // namespace
+
+static bool s_present = false;
+static u32 s_offset;
+static u16 s_total_pages;
+
+// Pages of the pool not owned by any handle
+static std::vector<u16> s_free;
+
+static std::vector<Handle> s_handles;
+static FrameMap s_frame;
+
+static bool IsValid(u16 handle)
+{
+  return handle < s_handles.size() && s_handles[handle].used;
+}
+
+static void Map(u8 physical, const Mapping& mapping)
+{
+  const u32 address = Memory::VirtToPhys(EMS::FRAME_SEGMENT, 0) +
+                      physical * PAGE_SIZE;
+
+  if (mapping.handle == UNMAPPED) {
+    Memory::UnmapExtra(address, PAGE_SIZE);
+  } else {
+    const u16 page = s_handles[mapping.handle].pages[mapping.page];
+    Memory::MapExtra(address, s_offset + page * PAGE_SIZE, PAGE_SIZE);
+  }
+
+  s_frame[physical] = mapping;
+}
+
+static Status MapPage(u16 handle, u16 page, u16 physical)
+{
+  if (physical >= EMS::FRAME_PAGES)
+    return BAD_PHYSICAL_PAGE;
+
+  if (page == UNMAPPED) {
+    Map(static_cast<u8>(physical), {});
+    return OK;
+  }
+
+  if (page >= s_handles[handle].pages.size())
+    return BAD_LOGICAL_PAGE;
+
+  Map(static_cast<u8>(physical), {handle, page});
+  return OK;
+}
+
+// Give a handle count pages, dropping the mappings of pages it loses
+static Status Resize(u16 handle, u16 count)
+{
+  auto& pages = s_handles[handle].pages;
+
+  if (count > s_total_pages)
+    return NOT_ENOUGH_PAGES;
+
+  if (count > pages.size() && count - pages.size() > s_free.size())
+    return NOT_ENOUGH_FREE_PAGES;
+
+  for (u8 i = 0; i < EMS::FRAME_PAGES; i++) {
+    if (s_frame[i].handle == handle && s_frame[i].page >= count)
+      Map(i, {});
+  }
+
+  while (pages.size() > count) {
+    s_free.push_back(pages.back());
+    pages.pop_back();
+  }
+
+  while (pages.size() < count) {
+    pages.push_back(s_free.back());
+    s_free.pop_back();
+  }
+
+  return OK;
+}
+
+static Status Allocate(u16 count)
+{
+  if (count == 0)
+    return ZERO_PAGES;
+
+  u16 handle;
+
+  for (handle = 1; handle < s_handles.size(); handle++) {
+    if (!s_handles[handle].used)
+      break;
+  }
+
+  if (handle == s_handles.size())
+    return NO_HANDLES;
+
+  const Status status = Resize(handle, count);
+
+  if (status != OK)
+    return status;
+
+  s_handles[handle].used = true;
+  CPU::DX = handle;
+
+  return OK;
+}
+
+static Status Deallocate(u16 handle)
+{
+  if (s_handles[handle].saved)
+    return SAVE_ERROR;
+
+  Resize(handle, 0);
+
+  if (handle != 0)
+    s_handles[handle] = {};
+
+  return OK;
+}
+
+static Status MapMultiple(u8 mode)
+{
+  if (mode > 1)
+    return BAD_SUBFUNCTION;
+
+  for (u16 i = 0; i < CPU::CX; i++) {
+    const u16 entry = static_cast<u16>(CPU::SI + i * 4);
+    const u16 page = Memory::Read<u16>(CPU::DS, entry);
+    u16 physical = Memory::Read<u16>(CPU::DS, static_cast<u16>(entry + 2));
+
+    // Mode 1 passes the segments of the physical pages
+    if (mode == 1) {
+      physical = static_cast<u16>((physical - EMS::FRAME_SEGMENT) /
+                                  (PAGE_SIZE / 0x10));
+    }
+
+    const Status status = MapPage(CPU::DX, page, physical);
+
+    if (status != OK)
+      return status;
+  }
+
+  return OK;
+}
+
+static Status Call()
+{
+  // Functions that take a handle in DX
+  switch (CPU::AH) {
+  case 0x44:
+  case 0x45:
+  case 0x47:
+  case 0x48:
+  case 0x4C:
+  case 0x50:
+  case 0x51:
+    if (!IsValid(CPU::DX))
+      return INVALID_HANDLE;
+    break;
+  }
+
+  switch (CPU::AH) {
+  case 0x40: // Get status
+    return OK;
+  case 0x41: // Get page frame segment
+    CPU::BX = EMS::FRAME_SEGMENT;
+    return OK;
+  case 0x42: // Get page counts
+    CPU::BX = static_cast<u16>(s_free.size());
+    CPU::DX = s_total_pages;
+    return OK;
+  case 0x43: // Allocate pages
+    return Allocate(CPU::BX);
+  case 0x44: // Map page
+    return MapPage(CPU::DX, CPU::BX, CPU::AL);
+  case 0x45: // Deallocate pages
+    return Deallocate(CPU::DX);
+  case 0x46: // Get version
+    CPU::AL = 0x40;
+    return OK;
+  case 0x47: { // Save page map
+    Handle& handle = s_handles[CPU::DX];
+
+    if (handle.saved)
+      return ALREADY_SAVED;
+
+    handle.saved = true;
+    handle.saved_map = s_frame;
+    return OK;
+  }
+  case 0x48: { // Restore page map
+    Handle& handle = s_handles[CPU::DX];
+
+    if (!handle.saved)
+      return NOT_SAVED;
+
+    for (u8 i = 0; i < EMS::FRAME_PAGES; i++) {
+      const Mapping& mapping = handle.saved_map[i];
+
+      // The pages may be gone by now
+      if (IsValid(mapping.handle) &&
+          mapping.page < s_handles[mapping.handle].pages.size())
+        Map(i, mapping);
+      else
+        Map(i, {});
+    }
+
+    handle.saved = false;
+    return OK;
+  }
+  case 0x4B: { // Get handle count
+    u16 count = 0;
+
+    for (const auto& handle : s_handles)
+      count += handle.used;
+
+    CPU::BX = count;
+    return OK;
+  }
+  case 0x4C: // Get handle pages
+    CPU::BX = static_cast<u16>(s_handles[CPU::DX].pages.size());
+    return OK;
+  case 0x4D: { // Get all handle pages
+    u16 count = 0;
+
+    for (u16 i = 0; i < s_handles.size(); i++) {
+      if (!s_handles[i].used)
+        continue;
+
+      const u16 entry = static_cast<u16>(CPU::DI + count++ * 4);
+      Memory::Get<u16>(CPU::ES, entry) = i;
+      Memory::Get<u16>(CPU::ES, static_cast<u16>(entry + 2)) =
+          static_cast<u16>(s_handles[i].pages.size());
+    }
+
+    CPU::BX = count;
+    return OK;
+  }
+  case 0x50: // Map multiple pages
+    return MapMultiple(CPU::AL);
+  case 0x51: { // Reallocate pages
+    const Status status = Resize(CPU::DX, CPU::BX);
+    CPU::BX = static_cast<u16>(s_handles[CPU::DX].pages.size());
+    return status;
+  }
+  case 0x58: // Get mappable physical addresses
+    if (CPU::AL > 1)
+      return BAD_SUBFUNCTION;
+
+    for (u16 i = 0; CPU::AL == 0 && i < EMS::FRAME_PAGES; i++) {
+      const u16 entry = static_cast<u16>(CPU::DI + i * 4);
+      Memory::Get<u16>(CPU::ES, entry) =
+          static_cast<u16>(EMS::FRAME_SEGMENT + i * (PAGE_SIZE / 0x10));
+      Memory::Get<u16>(CPU::ES, static_cast<u16>(entry + 2)) = i;
+    }
+
+    CPU::CX = EMS::FRAME_PAGES;
+    return OK;
+  default:
+    LOG("[INT 67h] Unknown parameter AH=" + String::ToHex(CPU::AH));
+    return UNDEFINED_FUNCTION;
+  }
+}
+
+void EMS::Init(u32 offset, u32 size)
+{
+  s_present = size != 0;
+  s_offset = offset;
+  s_total_pages = static_cast<u16>(std::min<u32>(size / PAGE_SIZE, 0xFFFF));
+
+  s_free.clear();
+  for (u16 page = s_total_pages; page > 0; page--)
+    s_free.push_back(page - 1);
+
+  s_handles.assign(MAX_HANDLES, {});
+  s_handles[0].used = true;
+  s_frame = {};
+
+  if (!s_present)
+    return;
+
+  LOG("EMS: " + std::to_string(s_total_pages) + " pages");
+}
+
+bool EMS::IsPresent() { return s_present; }
+
+void EMS::CallInterrupt() { CPU::AH = Call(); }
+
+std::any EMS::SaveState() { return State{s_free, s_handles, s_frame}; }
+
+void EMS::LoadState(const std::any& state)
+{
+  const auto& saved = std::any_cast<const State&>(state);
+
+  s_free = saved.free;
+  s_handles = saved.handles;
+  s_frame = saved.frame;
+}
@@ -0,0 +1,45 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <any>
+
+#include "Common/Types.h"
+
+/**@brief LIM EMS 4.0 expanded memory driver (INT 67h)
+ *
+ * Pages are 16 KiB of extra memory (see Memory::MapExtra). Mapping one into
+ * the page frame at D000:0000 switches the host memory behind it, so nothing
+ * gets copied and pages which are never written take up no host memory.
+ */
+namespace Core::MSDOS::EMS
+{
+//! Segment of the page frame
+constexpr u16 FRAME_SEGMENT = 0xD000;
+
+//! Physical pages in the page frame
+constexpr u8 FRAME_PAGES = 4;
+
+//! Programs look for this device name at offset 0x0A of the segment of the
+//! INT 67h handler (the BIOS segment)
+constexpr char NAME[8] = {'E', 'M', 'M', 'X', 'X', 'X', 'X', '0'};
+
+//! Hand out size bytes of extra memory starting at offset, size 0 disables
+//! the driver
+void Init(u32 offset, u32 size);
+
+bool IsPresent();
+
+//! Handle INT 67h
+void CallInterrupt();
+
+//! Copy of the handles and the page frame. The pages shown in the frame are
+//! up to Memory to restore (see Debug::Checkpoint)
+std::any SaveState();
+
+//! Go back to a state returned by SaveState()
+void LoadState(const std::any& state);
+} // namespace Core::MSDOS::EMS
@@ -13,115 +13,154 @@
 
 #include "Core/CPU/Exception.h"
 #include "Core/Core.h"
+#include "Core/MSDOS/EMS.h"
 #include "Core/MSDOS/File.h"
+#include "Core/MSDOS/XMS.h"
 #include "Core/TTY.h"
 
-using namespace Core;
 using namespace Core::MSDOS;
 
-bool CPU::CallMSDOSInterrupt(u8 vector)
+namespace Core::CPU
 {
-  switch (vector) {
-  case 0x20: // Exit program
-    LOG("Exit requested, stopping...");
-    Stop();
+// INT 20h
+static void Exit()
+{
+  LOG("Exit requested, stopping...");
+  Stop();
+}
+
+// INT 21h
+static void DOSServices()
+{
+  switch (AH) {
+  case 0x01: // Read char (echo)
+    if (!TTY::IsCharAvailable()) {
+      WaitForInterrupt();
+      break;
+    }
+
+    AL = TTY::Read();
+    TTY::Write(AL);
+    break;
+  case 0x02: { // Print char
+    TTY::Write(DL);
     break;
-  case 0x21: {
-    switch (AH) {
-    case 0x02: { // Print char
+  }
+  case 0x06: // Direct console I/O
+    if (DL != 0xFF) {
       TTY::Write(DL);
       break;
     }
-    case 0x06: { // Read char
-      AL = TTY::Read();
-      ZF = false;
+
+    ZF = !TTY::IsCharAvailable();
+    AL = ZF ? 0 : TTY::Read();
+    break;
+  case 0x07: // Read char (no echo)
+  case 0x08: // Read char (no echo, checking for Ctrl-C)
+    if (!TTY::IsCharAvailable()) {
+      WaitForInterrupt();
       break;
     }
-    case 0x07: // Read char (no echo)
-      // TODO: Actually does echo
-      AL = TTY::Read();
-      ZF = false;
-      break;
-    case 0x09: // Print string
-    {
-      std::string s = "";
 
-      char* c = Memory::GetPtr<char>(DS, DX);
+    AL = TTY::Read();
+    break;
+  case 0x09: // Print string
+  {
+    std::string s = "";
 
-      while (*c != '$')
-        s += *(c++);
+    char* c = Memory::GetPtr<char>(DS, DX);
 
-      TTY::Write(s);
-      break;
-    }
-    case 0x0b: // See if chars are available in stdin
-      AL = TTY::IsCharAvailable();
-      break;
-    case 0x19: // Get Default drive
-      AL = 0;
-      break;
-    case 0x30: // Get DOS version
-      // Pretend to be MS-DOS 5
-      LOG("DOS version requested; faking 5.0");
-      AL = 5;
-      AH = 0;
-      break;
-    case 0x3D: { // Open file
-      auto handle = File::Open(Memory::GetPtr<char>(DS, DX), AL);
+    while (*c != '$')
+      s += *(c++);
 
-      if (handle) {
-        AX = handle.value();
-      } else {
-        AX = 0x01;
-      }
+    TTY::Write(s);
+    break;
+  }
+  case 0x0b: // See if chars are available in stdin
+    AL = TTY::IsCharAvailable() ? 0xFF : 0x00;
+    break;
+  case 0x19: // Get Default drive
+    AL = 0;
+    break;
+  case 0x30: // Get DOS version
+    // Pretend to be MS-DOS 5
+    LOG("DOS version requested; faking 5.0");
+    AL = 5;
+    AH = 0;
+    break;
+  case 0x3D: { // Open file
+    auto handle = File::Open(Memory::GetPtr<char>(DS, DX), AL);
 
-      CF = !handle.has_value();
-      break;
+    if (handle) {
+      AX = handle.value();
+    } else {
+      AX = 0x01;
     }
-    case 0x3F: { // Read file
-      auto read = File::Read(BX, CX, Memory::GetPtr<u8>(DS, DX));
 
-      if (read) {
-        AX = read.value();
-      } else {
-        AX = 0x05;
-      }
+    CF = !handle.has_value();
+    break;
+  }
+  case 0x3F: { // Read file
+    auto read = File::Read(BX, CX, Memory::GetPtr<u8>(DS, DX));
 
-      CF = !read.has_value();
-      break;
-    }
-    case 0x42: { // Seek file
-      auto offset =
-          File::Seek(BX, static_cast<File::SeekOrigin>(AL), CX << 16 | DX);
-
-      if (offset) {
-        CX = (offset.value() & 0xFFFF0000) >> 16;
-        DX = offset.value() & 0xFFFF;
-      } else {
-        AX = 0x01;
-      }
-
-      CF = !offset.has_value();
-      break;
+    if (read) {
+      AX = read.value();
+    } else {
+      AX = 0x05;
     }
-    case 0x4C: // Exit program with return code
-      Stop();
-      LOG("Program exited with return code " + String::ToHex(AL));
-      break;
-    case 0x50: // Set PSP
-      LOG("[STUB] Set PSP = " + String::ToHex(BX));
-      CF = false;
-      break;
 
-    default:
-      LOG("[INT 0x21] Unhandled parameter AH = " + String::ToHex(AH));
-      throw UnhandledInterruptException();
+    CF = !read.has_value();
+    break;
+  }
+  case 0x42: { // Seek file
+    auto offset =
+        File::Seek(BX, static_cast<File::SeekOrigin>(AL), CX << 16 | DX);
+
+    if (offset) {
+      CX = (offset.value() & 0xFFFF0000) >> 16;
+      DX = offset.value() & 0xFFFF;
+    } else {
+      AX = 0x01;
     }
-    return true;
+
+    CF = !offset.has_value();
+    break;
   }
+  case 0x4C: // Exit program with return code
+    Stop();
+    LOG("Program exited with return code " + String::ToHex(AL));
+    break;
+  case 0x50: // Set PSP
+    LOG("[STUB] Set PSP = " + String::ToHex(BX));
+    CF = false;
+    break;
+
   default:
-    return false;
+    LOG("[INT 0x21] Unhandled parameter AH = " + String::ToHex(AH));
+    throw UnhandledInterruptException();
   }
+}
+
+// INT 2Fh
+static void Multiplex()
+{
+  if (AH == 0x43 && XMS::IsPresent())
+    XMS::CallMultiplex();
+  else
+    LOG("[INT 2Fh] Nobody answers AH=" + String::ToHex(AH));
+}
+
+void SetMSDOSInterruptHandlers()
+{
+  SetInterruptHandler(0x20, Exit);
+  SetInterruptHandler(0x21, DOSServices);
+  SetInterruptHandler(0x2F, Multiplex);
+
+  if (EMS::IsPresent())
+    SetInterruptHandler(0x67, EMS::CallInterrupt);
 
-  return true;
+  // Called by the entry point stub
+  if (XMS::IsPresent())
+    SetInterruptHandler(XMS::VECTOR, XMS::Call);
 }
+} // namespace Core::CPU
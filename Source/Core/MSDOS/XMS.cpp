@@ -0,0 +1,418 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/MSDOS/XMS.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Common/Logger.h"
+#include "Common/String.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+using namespace Core::MSDOS;
+
+constexpr u32 KIB = 1024;
+
+constexpr u16 MAX_HANDLES = 32;
+
+// Address of the first extended memory block as seen by the guest (right
+// after the HMA)
+constexpr u32 EXTENDED_BASE = Memory::SIZE + Memory::HMA_SIZE;
+
+// Error codes returned in BL
+enum Error : u8 {
+  NOT_IMPLEMENTED = 0x80,
+  HMA_IN_USE = 0x91,
+  HMA_NOT_ALLOCATED = 0x93,
+  A20_STILL_ENABLED = 0x94,
+  OUT_OF_MEMORY = 0xA0,
+  NO_HANDLES = 0xA1,
+  INVALID_HANDLE = 0xA2,
+  INVALID_SOURCE_HANDLE = 0xA3,
+  INVALID_SOURCE_OFFSET = 0xA4,
+  INVALID_DEST_HANDLE = 0xA5,
+  INVALID_DEST_OFFSET = 0xA6,
+  INVALID_LENGTH = 0xA7,
+  NOT_LOCKED = 0xAA,
+  LOCKED = 0xAB,
+  LOCK_OVERFLOW = 0xAC,
+  NO_UMB = 0xB1,
+  INVALID_UMB = 0xB2
+};
+
+namespace
+{
+//! Extended memory block, its handle is its index + 1
+struct Block {
+  bool used = false;
+  //! Offset into the extended memory
+  u32 offset = 0;
+  u32 size = 0;
+  u8 locks = 0;
+};
+
+//! Parameters of a move (at DS:SI)
+#pragma pack(push, 1)
+struct Move {
+  u32 length;
+  u16 source_handle;
+  u32 source_offset;
+  u16 dest_handle;
+  u32 dest_offset;
+};
+#pragma pack(pop)
+
+struct State {
+  std::vector<Block> blocks;
+  bool hma_used;
+  u32 a20_locks;
+};
+} // namespace
+
+static bool s_present = false;
+static u8* s_memory;
+static u32 s_size;
+
+static std::vector<Block> s_blocks;
+
+static bool s_hma_used;
+static u32 s_a20_locks;
+
+static Block* GetBlock(u16 handle)
+{
+  if (handle == 0 || handle > s_blocks.size() || !s_blocks[handle - 1].used)
+    return nullptr;
+
+  return &s_blocks[handle - 1];
+}
+
+// Blocks that take up memory, sorted by offset
+static std::vector<const Block*> GetUsedBlocks(const Block* except = nullptr)
+{
+  std::vector<const Block*> blocks;
+
+  for (const auto& block : s_blocks) {
+    if (block.used && block.size != 0 && &block != except)
+      blocks.push_back(&block);
+  }
+
+  std::sort(blocks.begin(), blocks.end(), [](const Block* a, const Block* b) {
+    return a->offset < b->offset;
+  });
+
+  return blocks;
+}
+
+// Call f with the offset and size of every gap between the blocks
+template <typename F> static void ForEachGap(F f, const Block* except = nullptr)
+{
+  u32 offset = 0;
+
+  for (const Block* block : GetUsedBlocks(except)) {
+    f(offset, block->offset - offset);
+    offset = block->offset + block->size;
+  }
+
+  f(offset, s_size - offset);
+}
+
+static std::optional<u32> FindSpace(u32 size, const Block* except = nullptr)
+{
+  std::optional<u32> found;
+
+  ForEachGap(
+      [&](u32 offset, u32 gap) {
+        if (!found && gap >= size)
+          found = offset;
+      },
+      except);
+
+  return found;
+}
+
+static u16 Succeed(u16 value = 1)
+{
+  CPU::BL = 0;
+  return value;
+}
+
+static u16 Fail(Error error)
+{
+  CPU::BL = error;
+  return 0;
+}
+
+// Host memory behind a handle and offset, handle 0 addresses conventional
+// memory with a segment:offset pair
+static u8* Resolve(u16 handle, u32 offset, u32 length, u32* address)
+{
+  if (handle == 0) {
+    *address = Memory::VirtToPhys(static_cast<u16>(offset >> 16),
+                                  static_cast<u16>(offset));
+
+    if (*address + length > Memory::SIZE + Memory::HMA_SIZE)
+      return nullptr;
+
+    return Memory::base + *address;
+  }
+
+  const Block* block = GetBlock(handle);
+
+  if (block == nullptr || offset > block->size ||
+      length > block->size - offset)
+    return nullptr;
+
+  return s_memory + block->offset + offset;
+}
+
+static u16 MoveBlock()
+{
+  Move move;
+  std::memcpy(&move, Memory::GetPtr<u8>(CPU::DS, CPU::SI), sizeof(move));
+
+  if (move.length % 2 != 0)
+    return Fail(INVALID_LENGTH);
+
+  if (move.source_handle != 0 && GetBlock(move.source_handle) == nullptr)
+    return Fail(INVALID_SOURCE_HANDLE);
+
+  if (move.dest_handle != 0 && GetBlock(move.dest_handle) == nullptr)
+    return Fail(INVALID_DEST_HANDLE);
+
+  u32 source_address = 0, dest_address = 0;
+  const u8* source = Resolve(move.source_handle, move.source_offset,
+                             move.length, &source_address);
+  u8* dest =
+      Resolve(move.dest_handle, move.dest_offset, move.length, &dest_address);
+
+  if (source == nullptr)
+    return Fail(INVALID_SOURCE_OFFSET);
+
+  if (dest == nullptr)
+    return Fail(INVALID_DEST_OFFSET);
+
+  std::memmove(dest, source, move.length);
+
+  // The move bypasses the memory map
+  if (move.dest_handle == 0)
+    Memory::NotifyWrite(dest_address, move.length);
+
+  return Succeed();
+}
+
+static u16 Allocate(u32 size)
+{
+  auto free = std::find_if(s_blocks.begin(), s_blocks.end(),
+                           [](const Block& block) { return !block.used; });
+
+  if (free == s_blocks.end())
+    return Fail(NO_HANDLES);
+
+  const auto offset = FindSpace(size);
+
+  if (!offset)
+    return Fail(OUT_OF_MEMORY);
+
+  *free = {true, *offset, size, 0};
+  CPU::DX = static_cast<u16>(free - s_blocks.begin() + 1);
+
+  return Succeed();
+}
+
+static u16 Reallocate(Block& block, u32 size)
+{
+  if (block.locks != 0)
+    return Fail(LOCKED);
+
+  const auto offset = FindSpace(size, &block);
+
+  // Growing in place is preferred, moving is the last resort
+  u32 end = s_size;
+
+  for (const Block* other : GetUsedBlocks(&block)) {
+    if (other->offset >= block.offset) {
+      end = other->offset;
+      break;
+    }
+  }
+
+  if (block.offset + size > end) {
+    if (!offset)
+      return Fail(OUT_OF_MEMORY);
+
+    std::memmove(s_memory + *offset, s_memory + block.offset,
+                 std::min(size, block.size));
+    block.offset = *offset;
+  }
+
+  block.size = size;
+
+  return Succeed();
+}
+
+static u16 Call()
+{
+  switch (CPU::AH) {
+  case 0x00: // Get version
+    CPU::BX = 0x0100;
+    CPU::DX = 1; // HMA exists
+    return 0x0300;
+  case 0x01: // Request HMA
+    if (s_hma_used)
+      return Fail(HMA_IN_USE);
+
+    s_hma_used = true;
+    return Succeed();
+  case 0x02: // Release HMA
+    if (!s_hma_used)
+      return Fail(HMA_NOT_ALLOCATED);
+
+    s_hma_used = false;
+    return Succeed();
+  case 0x03: // Global enable A20
+    Memory::SetA20Enabled(true);
+    return Succeed();
+  case 0x04: // Global disable A20
+    if (s_a20_locks != 0)
+      return Fail(A20_STILL_ENABLED);
+
+    Memory::SetA20Enabled(false);
+    return Succeed();
+  case 0x05: // Local enable A20
+    s_a20_locks++;
+    Memory::SetA20Enabled(true);
+    return Succeed();
+  case 0x06: // Local disable A20
+    if (s_a20_locks == 0 || --s_a20_locks != 0)
+      return Fail(A20_STILL_ENABLED);
+
+    Memory::SetA20Enabled(false);
+    return Succeed();
+  case 0x07: // Query A20
+    CPU::BL = 0;
+    return Memory::IsA20Enabled();
+  case 0x08: { // Query free extended memory
+    u32 largest = 0, total = 0;
+
+    ForEachGap([&](u32, u32 gap) {
+      largest = std::max(largest, gap);
+      total += gap;
+    });
+
+    CPU::DX = static_cast<u16>(total / KIB);
+
+    if (total == 0)
+      return Fail(OUT_OF_MEMORY);
+
+    CPU::BL = 0;
+    return static_cast<u16>(largest / KIB);
+  }
+  case 0x09: // Allocate extended memory block
+    return Allocate(CPU::DX * KIB);
+  case 0x0B: // Move extended memory block
+    return MoveBlock();
+  case 0x0A:
+  case 0x0C:
+  case 0x0D:
+  case 0x0E:
+  case 0x0F: {
+    Block* block = GetBlock(CPU::DX);
+
+    if (block == nullptr)
+      return Fail(INVALID_HANDLE);
+
+    switch (CPU::AH) {
+    case 0x0A: // Free extended memory block
+      if (block->locks != 0)
+        return Fail(LOCKED);
+
+      *block = {};
+      return Succeed();
+    case 0x0C: { // Lock extended memory block
+      if (block->locks == 0xFF)
+        return Fail(LOCK_OVERFLOW);
+
+      block->locks++;
+
+      const u32 address = EXTENDED_BASE + block->offset;
+      CPU::DX = static_cast<u16>(address >> 16);
+      CPU::BX = static_cast<u16>(address);
+      return 1;
+    }
+    case 0x0D: // Unlock extended memory block
+      if (block->locks == 0)
+        return Fail(NOT_LOCKED);
+
+      block->locks--;
+      return Succeed();
+    case 0x0E: // Get handle information
+      CPU::BH = block->locks;
+      CPU::BL = static_cast<u8>(std::count_if(
+          s_blocks.begin(), s_blocks.end(),
+          [](const Block& block) { return !block.used; }));
+      CPU::DX = static_cast<u16>(block->size / KIB);
+      return 1;
+    default: // Reallocate extended memory block
+      return Reallocate(*block, CPU::BX * KIB);
+    }
+  }
+  case 0x10: // Request upper memory block
+    CPU::DX = 0;
+    return Fail(NO_UMB);
+  case 0x11: // Release upper memory block
+    return Fail(INVALID_UMB);
+  default:
+    LOG("[XMS] Unknown function AH=" + String::ToHex(CPU::AH));
+    return Fail(NOT_IMPLEMENTED);
+  }
+}
+
+void XMS::Init(u32 offset, u32 size)
+{
+  s_present = size != 0;
+  s_memory = Memory::extra + offset;
+  s_size = size;
+
+  s_blocks.assign(MAX_HANDLES, {});
+  s_hma_used = false;
+  s_a20_locks = 0;
+
+  if (s_present)
+    LOG("XMS: " + std::to_string(size / KIB) + " KiB");
+}
+
+bool XMS::IsPresent() { return s_present; }
+
+void XMS::CallMultiplex()
+{
+  switch (CPU::AL) {
+  case 0x00: // Installation check
+    CPU::AL = 0x80;
+    break;
+  case 0x10: // Get entry point
+    CPU::ES = 0xF000;
+    CPU::BX = ENTRY_OFFSET;
+    break;
+  }
+}
+
+void XMS::Call() { CPU::AX = ::Call(); }
+
+std::any XMS::SaveState() { return State{s_blocks, s_hma_used, s_a20_locks}; }
+
+void XMS::LoadState(const std::any& state)
+{
+  const auto& saved = std::any_cast<const State&>(state);
+
+  s_blocks = saved.blocks;
+  s_hma_used = saved.hma_used;
+  s_a20_locks = saved.a20_locks;
+}
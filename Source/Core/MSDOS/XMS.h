@@ -0,0 +1,47 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <any>
+
+#include "Common/Types.h"
+
+/**@brief XMS 3.0 extended memory driver
+ *
+ * Programs find the driver through INT 2Fh AX=4300h and get its entry point
+ * through AX=4310h. The entry point is a stub in the BIOS ROM which traps
+ * into the native handler of VECTOR.
+ *
+ * Extended memory blocks are extra memory (see Memory) and block moves are
+ * a single host memmove. The HMA and the A20 gate are managed as well.
+ */
+namespace Core::MSDOS::XMS
+{
+//! Vector of the native handler the entry point stub traps into
+constexpr u8 VECTOR = 0xE0;
+
+//! Location of the entry point stub (F000:ENTRY_OFFSET)
+constexpr u16 ENTRY_OFFSET = 0x0020;
+
+//! Hand out size bytes of extra memory starting at offset, size 0 disables
+//! the driver
+void Init(u32 offset, u32 size);
+
+bool IsPresent();
+
+//! Handle INT 2Fh AH=43h
+void CallMultiplex();
+
+//! Handle a call of the entry point
+void Call();
+
+//! Copy of the blocks, the HMA owner and the A20 locks. The A20 gate itself
+//! is up to Memory (see Debug::Checkpoint)
+std::any SaveState();
+
+//! Go back to a state returned by SaveState()
+void LoadState(const std::any& state);
+} // namespace Core::MSDOS::XMS
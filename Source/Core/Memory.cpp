@@ -1,14 +1,582 @@
 #include "Core/Memory.h"
 
-#include "Core/CPU/Exception.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Common/Logger.h"
 
 using namespace Core;
 
-static std::vector<u8> m_data(1024 * 1024);
+constexpr size_t GUARD_SIZE = 0x1000;
+
+// Accesses to ROM and Devices remembered until the next Commit()
+constexpr u32 MAX_PENDING = 32;
+
+namespace
+{
+struct Page {
+  Memory::PageType type = Memory::PageType::RAM;
+  Memory::Device device;
+};
+
+struct PendingAccess {
+  u32 address;
+  u32 size;
+  u8 old[8];
+};
+} // namespace
+
+// Offset of the extra memory shown by a page
+constexpr u32 NO_EXTRA = UINT32_MAX;
+
+static bool s_a20 = false;
+static u32 s_conventional = Memory::CONVENTIONAL_SIZE;
+static u32 s_extra_size = 0;
+
+static Page s_map[Memory::PAGE_COUNT];
+static PendingAccess s_pending[MAX_PENDING];
+static u32 s_extra_map[Memory::PAGE_COUNT];
+
+// Pages privately mapped from a file by MapFile()
+static bool s_file_map[Memory::PAGE_COUNT];
+
+// Pages changed since the last TakeWrittenPages(), if tracked
+static bool s_track_writes = false;
+static bool s_written[Memory::PAGE_COUNT];
+static std::vector<u32> s_written_pages;
+
+#ifdef _WIN32
+// Without a way to map the same memory twice the HMA is separate memory, so
+// addresses past the end of RAM don't wrap around
+static u8* Map()
+{
+  return static_cast<u8*>(
+      std::calloc(Memory::SIZE + Memory::HMA_SIZE + GUARD_SIZE, 1));
+}
+
+static void MapHMA(u8*) {}
+
+static void Discard(u32 extra_size)
+{
+  std::memset(Memory::base, 0, Memory::SIZE + Memory::HMA_SIZE);
+  std::free(Memory::extra);
+  Memory::extra = static_cast<u8*>(std::calloc(extra_size, 1));
+}
+
+// Pages are copied in and out instead, so a page of extra memory shown at
+// several addresses doesn't stay in sync and the RAM below gets lost
+static void MapPage(u32 address, u32 offset)
+{
+  if (s_extra_map[address >> Memory::PAGE_BITS] != NO_EXTRA) {
+    std::memcpy(Memory::extra + s_extra_map[address >> Memory::PAGE_BITS],
+                Memory::base + address, Memory::PAGE_SIZE);
+  }
+
+  if (offset != NO_EXTRA) {
+    std::memcpy(Memory::base + address, Memory::extra + offset,
+                Memory::PAGE_SIZE);
+  }
+}
+
+// Files can't be mapped, they get read instead
+static bool MapFile(u32 address, const std::string& path, u64 offset,
+                    u32 size)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  ifs.seekg(offset);
+  ifs.read(reinterpret_cast<char*>(Memory::base + address), size);
+
+  return ifs.good();
+}
 
-std::vector<u8>& Memory::Get() { return m_data; }
+static void Unshare(u32) {}
+#else
+// RAM and the HMA, the tail of the RAM mapping maps either of them
+static int s_fd = -1;
 
-u32 Memory::VirtToPhys(u16 segment, u16 offset)
+static void Fail(const std::string& what)
 {
-  return segment * 0x10 + offset;
+  ERROR("Failed to map emulated RAM: " + what);
+  std::abort();
+}
+
+static int CreateBacking()
+{
+#ifdef __linux__
+  const int fd = memfd_create("ape-ram", MFD_CLOEXEC);
+#else
+  const std::string name = "/ape-ram-" + std::to_string(getpid());
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  shm_unlink(name.c_str());
+#endif
+
+  if (fd < 0 || ftruncate(fd, Memory::SIZE + Memory::HMA_SIZE) != 0)
+    Fail("no shared memory");
+
+  return fd;
+}
+
+static void MapHMA(u8* base)
+{
+  const off_t offset = s_a20 ? Memory::SIZE : 0;
+
+  if (mmap(base + Memory::SIZE, Memory::HMA_SIZE, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_FIXED, s_fd, offset) == MAP_FAILED)
+    Fail("HMA");
+}
+
+static u8* Map()
+{
+  // Reserve the whole range up front, so the guard page stays inaccessible
+  void* region = mmap(nullptr, Memory::SIZE + Memory::HMA_SIZE + GUARD_SIZE,
+                      PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                      -1, 0);
+
+  if (region == MAP_FAILED)
+    Fail("no address space");
+
+  u8* base = static_cast<u8*>(region);
+  s_fd = CreateBacking();
+
+  if (mmap(base, Memory::SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+           s_fd, 0) == MAP_FAILED)
+    Fail("RAM");
+
+  MapHMA(base);
+
+#if defined(APE_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+  // Only a hint, shared memory needs shmem_enabled to be "advise" for it
+  madvise(base, Memory::SIZE, MADV_HUGEPAGE);
+#endif
+
+  return base;
+}
+
+static void Discard(u32 extra_size)
+{
+  constexpr off_t EXTRA = Memory::SIZE + Memory::HMA_SIZE;
+
+  if (Memory::extra != nullptr)
+    munmap(Memory::extra, s_extra_size);
+
+#ifdef __linux__
+  // Frees the pages right away, they read as 0 afterwards
+  if (fallocate(s_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, EXTRA) !=
+      0)
+#endif
+    std::memset(Memory::base, 0, EXTRA);
+
+  // Growing the backing again leaves a hole, which isn't committed yet
+  if (ftruncate(s_fd, EXTRA) != 0 || ftruncate(s_fd, EXTRA + extra_size) != 0)
+    Fail("no shared memory");
+
+  Memory::extra = nullptr;
+
+  if (extra_size == 0)
+    return;
+
+  void* extra = mmap(nullptr, extra_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     s_fd, EXTRA);
+
+  if (extra == MAP_FAILED)
+    Fail("extra memory");
+
+  Memory::extra = static_cast<u8*>(extra);
+}
+
+// Map the extra memory (or the RAM) in place of the RAM
+static void MapPage(u32 address, u32 offset)
+{
+  const off_t source = offset == NO_EXTRA
+                           ? address
+                           : Memory::SIZE + Memory::HMA_SIZE + offset;
+
+  if (mmap(Memory::base + address, Memory::PAGE_SIZE, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_FIXED, s_fd, source) == MAP_FAILED)
+    Fail("extra memory");
+}
+
+static void FreeBacking([[maybe_unused]] off_t offset,
+                        [[maybe_unused]] off_t size)
+{
+#ifdef __linux__
+  fallocate(s_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, size);
+#endif
+}
+
+static bool MapFile(u32 address, const std::string& path, u64 offset,
+                    u32 size)
+{
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat info;
+
+  if (fd < 0 || fstat(fd, &info) != 0 || offset + size > u64(info.st_size)) {
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+
+  // The first 64 KiB show up past the end of RAM as well, which only works
+  // with the shared backing, so they are copied
+  const u32 copied = address < Memory::HMA_SIZE
+                         ? std::min(size, Memory::HMA_SIZE - address)
+                         : 0;
+  bool success =
+      pread(fd, Memory::base + address, copied, offset) == ssize_t(copied);
+
+  address += copied;
+  offset += copied;
+  size -= copied;
+
+  // Pages are shared with everyone mapping the file until they get written
+  if (success && size != 0) {
+    if (mmap(Memory::base + address, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_FIXED, fd, offset) == MAP_FAILED)
+      Fail("file");
+
+    FreeBacking(address, size);
+
+    for (u32 i = 0; i < size; i += Memory::PAGE_SIZE)
+      s_file_map[(address + i) >> Memory::PAGE_BITS] = true;
+  }
+
+  close(fd);
+
+  return success;
+}
+
+// Move a page mapped from a file to the shared backing, so it can be
+// replaced by extra memory and mapped again later
+static void Unshare(u32 address)
+{
+  if (pwrite(s_fd, Memory::base + address, Memory::PAGE_SIZE, address) !=
+      Memory::PAGE_SIZE)
+    Fail("file");
+
+  MapPage(address, NO_EXTRA);
+}
+#endif
+
+u8* const Memory::base = Map();
+u8* Memory::extra = nullptr;
+
+u8* Memory::pages[PAGE_COUNT];
+const u8* Memory::read_pages[PAGE_COUNT];
+u32 Memory::pending = 0;
+
+// With the A20 gate disabled the HMA behaves like the first 64 KiB
+static u32 Wrap(u32 address)
+{
+  return !s_a20 && address >= Memory::SIZE ? address - Memory::SIZE : address;
+}
+
+static const Page& GetPage(u32 page)
+{
+  return s_map[Wrap(page << Memory::PAGE_BITS) >> Memory::PAGE_BITS];
+}
+
+// Whether writes to page can go straight to RAM
+static bool IsDirect(u32 page)
+{
+  return GetPage(page).type == Memory::PageType::RAM && !s_track_writes;
+}
+
+// Whether reads from page can go straight to RAM
+static bool IsDirectRead(u32 page)
+{
+  const Page& source = GetPage(page);
+  return source.type != Memory::PageType::Device ||
+         source.device.read == nullptr;
+}
+
+// Accesses at the end of a page reach into the next one, which is right
+// behind it in host memory. So a page is only direct if the next one is as
+// well. Nothing reaches past the HMA
+static void UpdatePages()
+{
+  for (u32 page = 0; page < Memory::PAGE_COUNT; page++) {
+    const bool last = page + 1 == Memory::PAGE_COUNT;
+
+    const bool direct = IsDirect(page) && (last || IsDirect(page + 1));
+    const bool direct_read =
+        IsDirectRead(page) && (last || IsDirectRead(page + 1));
+
+    Memory::pages[page] = direct ? Memory::base : nullptr;
+    Memory::read_pages[page] = direct_read ? Memory::base : nullptr;
+  }
+}
+
+static void Map(u32 address, u32 size, Memory::PageType type,
+                const Memory::Device& device)
+{
+  for (u32 page = address >> Memory::PAGE_BITS;
+       page < (address + size) >> Memory::PAGE_BITS; page++)
+    s_map[page] = {type, device};
+
+  UpdatePages();
+}
+
+static bool Initialize()
+{
+  std::fill(std::begin(s_extra_map), std::end(s_extra_map), NO_EXTRA);
+  UpdatePages();
+
+  return true;
+}
+
+static const bool s_pages_initialized = Initialize();
+
+static void MapExtraPages(u32 address, u32 offset, u32 size)
+{
+  for (u32 i = 0; i < size; i += Memory::PAGE_SIZE) {
+    const u32 page = (address + i) >> Memory::PAGE_BITS;
+    const u32 source = offset == NO_EXTRA ? NO_EXTRA : offset + i;
+
+    if (s_extra_map[page] == source)
+      continue;
+
+    if (s_file_map[page]) {
+      Unshare(address + i);
+      s_file_map[page] = false;
+    }
+
+    MapPage(address + i, source);
+    s_extra_map[page] = source;
+  }
+}
+
+// Call f(page, address, size) for the part of size bytes at address within
+// each page they reach into
+template <typename F> static void ForEachPage(u32 address, u32 size, F f)
+{
+  while (size > 0) {
+    const u32 offset = address & (Memory::PAGE_SIZE - 1);
+    const u32 length = std::min(size, Memory::PAGE_SIZE - offset);
+
+    f(s_map[Wrap(address) >> Memory::PAGE_BITS], address, length);
+
+    address += length;
+    size -= length;
+  }
+}
+
+static void ReadDevices(u32 address, u32 size)
+{
+  ForEachPage(address, size, [](const Page& page, u32 part, u32 length) {
+    if (page.type == Memory::PageType::Device && page.device.read)
+      page.device.read(part, Memory::base + part, length);
+  });
+}
+
+u8* Memory::Access(u32 address, u32 size)
+{
+  address = Wrap(address);
+
+  ReadDevices(address, size);
+
+  // Commit the older half when an instruction accesses a lot of memory (e.g.
+  // REP MOVSB), the most recent references may not have been written yet
+  if (pending == MAX_PENDING) {
+    pending = MAX_PENDING / 2;
+    CommitPending();
+    std::copy(s_pending + MAX_PENDING / 2, s_pending + MAX_PENDING, s_pending);
+    pending = MAX_PENDING / 2;
+  }
+
+  // Only the state before the first access of the instruction matters
+  for (u32 i = 0; i < pending; i++) {
+    if (s_pending[i].address == address && s_pending[i].size >= size)
+      return base;
+  }
+
+  PendingAccess& access = s_pending[pending++];
+  access.address = address;
+  access.size = std::min<u32>(size, sizeof(access.old));
+  std::memcpy(access.old, base + address, access.size);
+
+  return base;
+}
+
+const u8* Memory::AccessRead(u32 address, u32 size)
+{
+  ReadDevices(Wrap(address), size);
+
+  return base;
+}
+
+void Memory::CommitPending()
+{
+  for (u32 i = 0; i < pending; i++) {
+    const PendingAccess& access = s_pending[i];
+
+    const auto commit = [&access](const Page& page, u32 part, u32 length) {
+      const u8* old = access.old + (part - access.address);
+      u8* data = base + part;
+
+      if (std::memcmp(old, data, length) == 0)
+        return;
+
+      if (page.type == PageType::ROM || page.type == PageType::None) {
+        std::memcpy(data, old, length);
+        return;
+      }
+
+      if (page.device.write)
+        page.device.write(part, data, length);
+
+      if (s_track_writes && !s_written[part >> PAGE_BITS]) {
+        s_written[part >> PAGE_BITS] = true;
+        s_written_pages.push_back(part >> PAGE_BITS);
+      }
+    };
+
+    ForEachPage(access.address, access.size, commit);
+  }
+
+  pending = 0;
+}
+
+void Memory::MapRAM(u32 address, u32 size)
+{
+  ::Map(address, size, PageType::RAM, {});
+}
+
+void Memory::MapROM(u32 address, const u8* data, u32 size)
+{
+  std::memcpy(base + address, data, size);
+  ::Map(address, size, PageType::ROM, {});
+}
+
+void Memory::MapDevice(u32 address, u32 size, const Device& device)
+{
+  ::Map(address, size, PageType::Device, device);
+}
+
+void Memory::TrackWrites(bool enabled)
+{
+  s_track_writes = enabled;
+  TakeWrittenPages();
+  UpdatePages();
+}
+
+std::vector<u32> Memory::TakeWrittenPages()
+{
+  std::vector<u32> pages;
+  pages.swap(s_written_pages);
+
+  for (u32 page : pages)
+    s_written[page] = false;
+
+  std::sort(pages.begin(), pages.end());
+  return pages;
+}
+
+Memory::PageType Memory::GetPageType(u32 address)
+{
+  return s_map[Wrap(address) >> PAGE_BITS].type;
+}
+
+void Memory::NotifyWrite(u32 address, u32 size)
+{
+  const u32 end = std::min(address + size, SIZE) + PAGE_SIZE - 1;
+
+  for (u32 page = address >> PAGE_BITS; page < end >> PAGE_BITS; page++) {
+    const Device& device = s_map[page].device;
+
+    if (s_map[page].type == PageType::Device && device.write)
+      device.write(page << PAGE_BITS, base + (page << PAGE_BITS), PAGE_SIZE);
+  }
+}
+
+void Memory::Reset(u32 conventional, u32 extra_size)
+{
+  pending = 0;
+
+  MapExtraPages(0, NO_EXTRA, SIZE);
+
+  for (u32 page = 0; page < PAGE_COUNT; page++) {
+    if (s_file_map[page])
+      MapPage(page << PAGE_BITS, NO_EXTRA);
+
+    s_file_map[page] = false;
+  }
+
+  Discard(extra_size);
+  SetA20Enabled(false);
+
+  s_conventional = std::min(conventional, CONVENTIONAL_SIZE);
+  s_extra_size = extra_size;
+
+  for (u32 page = 0; page < CONVENTIONAL_SIZE >> PAGE_BITS; page++) {
+    s_map[page] = {page < s_conventional >> PAGE_BITS ? PageType::RAM
+                                                      : PageType::None,
+                   {}};
+  }
+
+  UpdatePages();
+}
+
+u32 Memory::GetConventionalSize() { return s_conventional; }
+
+u32 Memory::GetExtraSize() { return s_extra_size; }
+
+void Memory::MapExtra(u32 address, u32 offset, u32 size)
+{
+  MapExtraPages(address, offset, size);
+}
+
+void Memory::UnmapExtra(u32 address, u32 size)
+{
+  MapExtraPages(address, NO_EXTRA, size);
+}
+
+std::vector<Memory::ExtraMapping> Memory::GetExtraMappings()
+{
+  std::vector<ExtraMapping> mappings;
+
+  for (u32 address = 0; address < SIZE; address += EXTRA_PAGE_SIZE) {
+    const u32 offset = s_extra_map[address >> PAGE_BITS];
+
+    if (offset != NO_EXTRA)
+      mappings.push_back({address, offset});
+  }
+
+  return mappings;
+}
+
+bool Memory::MapFile(u32 address, const std::string& path, u64 offset,
+                     u32 size)
+{
+  MapExtraPages(address, NO_EXTRA, size);
+
+  if (!::MapFile(address, path, offset, size))
+    return false;
+
+  NotifyWrite(address, size);
+  return true;
+}
+
+bool Memory::IsA20Enabled() { return s_a20; }
+
+void Memory::SetA20Enabled(bool enabled)
+{
+  if (enabled == s_a20)
+    return;
+
+  Commit();
+
+  s_a20 = enabled;
+  MapHMA(base);
+  UpdatePages();
 }
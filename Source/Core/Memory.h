@@ -1,36 +1,199 @@
 #pragma once
 //! \file
 
+#include <functional>
+#include <string>
 #include <vector>
 
 #include "Common/Types.h"
 
-#include "Core/CPU/Exception.h"
-
 namespace Core
 {
-//! Wrapper around emulated RAM
+/**@brief Wrapper around emulated RAM
+ *
+ * RAM is one mapping starting at base. Segmented addresses reach up to
+ * FFFF:FFFF (0x10FFEF), so the 64 KiB past the end of RAM are always mapped
+ * too: With the A20 gate disabled (like on an 8086) they are a second mapping
+ * of the first 64 KiB, so addresses wrap around without any check. A guard
+ * page follows to catch anything beyond.
+ *
+ * The address space is split into pages which are RAM, ROM or belong to a
+ * memory mapped Device. Accesses to RAM only look up the host pointer of the
+ * page, which takes one predictable branch: Pages needing handling (and the
+ * RAM pages right before them) have none. Get() can't tell reads and writes
+ * apart as it returns a reference, so for other pages it remembers the bytes
+ * and Commit() compares them after the instruction: Writes to ROM get undone,
+ * Devices get notified.
+ *
+ * Memory outside of the address space (extra memory, handed out by the EMS
+ * and XMS drivers) is only reachable by mapping parts of it into the address
+ * space. Host memory is only committed for pages which get written.
+ *
+ * RAM can also be mapped from a file (see MapFile()), e.g. to share a
+ * baseline between many instances.
+ */
 namespace Memory
 {
-//! Get the contents of RAM
-std::vector<u8>& Get();
+//! Size of RAM
+constexpr u32 SIZE = 0x100000;
+
+//! Bytes past the end of RAM reachable by segment:offset addresses
+constexpr u32 HMA_SIZE = 0x10000;
+
+constexpr u32 PAGE_BITS = 12;
+constexpr u32 PAGE_SIZE = 1 << PAGE_BITS;
+constexpr u32 PAGE_COUNT = (SIZE + HMA_SIZE) / PAGE_SIZE;
+
+//! Bytes of conventional memory at most (up to the video buffer)
+constexpr u32 CONVENTIONAL_SIZE = 0xA0000;
+
+//! Granularity of MapExtra()
+constexpr u32 EXTRA_PAGE_SIZE = 0x4000;
+
+//! None is address space without memory, which acts like ROM filled with 0
+enum class PageType : u8 { RAM, ROM, Device, None };
+
+//! Callbacks of a memory mapped device. The device's pages are backed by RAM,
+//! so reads return what was written last unless there is a read callback
+struct Device {
+  //! Fill data with size bytes starting at address
+  std::function<void(u32 address, u8* data, u32 size)> read;
+  //! An instruction changed size bytes starting at address to data
+  std::function<void(u32 address, const u8* data, u32 size)> write;
+};
+
+//! Start of RAM
+extern u8* const base;
+
+//! Start of the extra memory
+extern u8* extra;
+
+//! \cond PRIVATE
+// Host pointer of every page (nullptr if accesses have to be handled). It is
+// also nullptr if the next page needs handling, as accesses at the end of a
+// page reach into it
+extern u8* pages[PAGE_COUNT];
+extern const u8* read_pages[PAGE_COUNT];
+extern u32 pending;
+
+u8* Access(u32 address, u32 size);
+const u8* AccessRead(u32 address, u32 size);
+void CommitPending();
+//! \endcond
 
 //! Converts a virtual address to an absolute one
-u32 VirtToPhys(u16 segment, u16 offset);
+inline u32 VirtToPhys(u16 segment, u16 offset)
+{
+  return segment * 0x10 + offset;
+}
 
-template <typename T> T& Get(u16 segment, u16 offset)
+//! Reference to the memory at an absolute address, which may get written
+template <typename T> T& GetAt(u32 address)
 {
-  u32 address = VirtToPhys(segment, offset);
+  u8* host = pages[address >> PAGE_BITS];
+
+  if (host == nullptr)
+    host = Access(address, sizeof(T));
 
-  if (address + sizeof(T) >= Get().size())
-    throw Core::CPU::MemoryOutOfRangeException();
+  return *reinterpret_cast<T*>(host + address);
+}
+
+//! Value of the memory at an absolute address, ROM is read directly
+template <typename T> T ReadAt(u32 address)
+{
+  const u8* host = read_pages[address >> PAGE_BITS];
 
-  return *reinterpret_cast<T*>(&Get()[address]);
+  if (host == nullptr)
+    host = AccessRead(address, sizeof(T));
+
+  return *reinterpret_cast<const T*>(host + address);
+}
+
+//! Reference to the memory at segment:offset, which may get written
+template <typename T> T& Get(u16 segment, u16 offset)
+{
+  return GetAt<T>(VirtToPhys(segment, offset));
 }
 
 template <typename T> T* GetPtr(u16 segment, u16 offset)
 {
   return &Get<T>(segment, offset);
 }
+
+//! Value of the memory at segment:offset, ROM is read directly
+template <typename T> T Read(u16 segment, u16 offset)
+{
+  return ReadAt<T>(VirtToPhys(segment, offset));
+}
+
+//! Apply the accesses to ROM and Devices made since the last call. Called
+//! after every instruction
+inline void Commit()
+{
+  if (pending != 0)
+    CommitPending();
+}
+
+//! Turn size bytes at address (page aligned) into RAM
+void MapRAM(u32 address, u32 size);
+
+//! Copy size bytes of data to address (page aligned) and make them read only
+void MapROM(u32 address, const u8* data, u32 size);
+
+//! Let device handle size bytes at address (page aligned)
+void MapDevice(u32 address, u32 size, const Device& device);
+
+PageType GetPageType(u32 address);
+
+//! Discard the contents of all memory. conventional bytes (page aligned) are
+//! RAM, the rest below CONVENTIONAL_SIZE is left empty. extra bytes (a
+//! multiple of EXTRA_PAGE_SIZE) of extra memory are set aside
+void Reset(u32 conventional, u32 extra_size);
+
+u32 GetConventionalSize();
+u32 GetExtraSize();
+
+//! Let size bytes at address show the extra memory at offset instead of RAM
+//! (all page aligned to EXTRA_PAGE_SIZE), like a bank switch. Several
+//! addresses may show the same extra memory
+void MapExtra(u32 address, u32 offset, u32 size);
+
+//! Let size bytes at address show RAM again
+void UnmapExtra(u32 address, u32 size);
+
+//! EXTRA_PAGE_SIZE bytes of RAM showing extra memory
+struct ExtraMapping {
+  u32 address;
+  u32 offset;
+};
+
+//! Everything MapExtra() made RAM show, ascending by address
+std::vector<ExtraMapping> GetExtraMappings();
+
+//! Load size bytes of the file at path starting at offset into RAM at
+//! address (both page aligned). The pages are mapped copy-on-write where
+//! possible, so they only take up host memory once for everyone mapping the
+//! file until they get written
+bool MapFile(u32 address, const std::string& path, u64 offset, u32 size);
+
+//! Tell Devices about size bytes at address that were changed through base
+//! (e.g. when restoring a snapshot)
+void NotifyWrite(u32 address, u32 size);
+
+//! Start or stop recording which RAM pages instructions change for
+//! TakeWrittenPages(). While enabled every access through Get() takes the
+//! slow path, only Read() stays fast
+void TrackWrites(bool enabled);
+
+//! Pages (address / PAGE_SIZE, ascending) instructions changed through Get()
+//! since the last call. Writes straight through base aren't seen
+std::vector<u32> TakeWrittenPages();
+
+//! Whether addresses past the end of RAM reach the HMA instead of wrapping
+//! around to 0
+bool IsA20Enabled();
+
+//! Enable or disable the A20 gate
+void SetA20Enabled(bool enabled);
 } // namespace Memory
 } // namespace Core
@@ -0,0 +1,106 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include "Core/Scheduler.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace Core;
+
+namespace
+{
+struct Event {
+  u64 cycle;
+  Scheduler::EventID id;
+  Scheduler::Callback callback;
+};
+
+struct State {
+  u64 cycles;
+  std::vector<Event> events;
+  Scheduler::EventID next_id;
+};
+} // namespace
+
+u64 Scheduler::cycles = 0;
+u64 Scheduler::next = NEVER;
+
+static std::vector<Event> s_events;
+static Scheduler::EventID s_next_id;
+
+// Orders the heap so the earliest event (and the first scheduled of events
+// at the same cycle) is on top
+static bool Later(const Event& a, const Event& b)
+{
+  return a.cycle != b.cycle ? a.cycle > b.cycle : a.id > b.id;
+}
+
+static void UpdateNext()
+{
+  Scheduler::next =
+      s_events.empty() ? Scheduler::NEVER : s_events.front().cycle;
+}
+
+void Scheduler::Reset()
+{
+  cycles = 0;
+  s_events.clear();
+  s_next_id = 0;
+  UpdateNext();
+}
+
+Scheduler::EventID Scheduler::Schedule(u64 cycle, Callback callback)
+{
+  const EventID id = s_next_id++;
+
+  s_events.push_back({cycle, id, std::move(callback)});
+  std::push_heap(s_events.begin(), s_events.end(), Later);
+  UpdateNext();
+
+  return id;
+}
+
+Scheduler::EventID Scheduler::ScheduleIn(u64 delay, Callback callback)
+{
+  return Schedule(cycles + delay, std::move(callback));
+}
+
+void Scheduler::Cancel(EventID id)
+{
+  auto it = std::find_if(s_events.begin(), s_events.end(),
+                         [id](const Event& event) { return event.id == id; });
+
+  if (it == s_events.end())
+    return;
+
+  s_events.erase(it);
+  std::make_heap(s_events.begin(), s_events.end(), Later);
+  UpdateNext();
+}
+
+std::any Scheduler::SaveState() { return State{cycles, s_events, s_next_id}; }
+
+void Scheduler::LoadState(const std::any& state)
+{
+  const auto& saved = std::any_cast<const State&>(state);
+
+  cycles = saved.cycles;
+  s_events = saved.events;
+  s_next_id = saved.next_id;
+  UpdateNext();
+}
+
+void Scheduler::RunDue()
+{
+  // Callbacks may schedule further events, even ones which are due already
+  while (!s_events.empty() && s_events.front().cycle <= cycles) {
+    std::pop_heap(s_events.begin(), s_events.end(), Later);
+    Callback callback = std::move(s_events.back().callback);
+    s_events.pop_back();
+    UpdateNext();
+
+    callback();
+  }
+}
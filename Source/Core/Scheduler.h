@@ -0,0 +1,71 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#pragma once
+//! \file
+
+#include <any>
+#include <functional>
+#include <limits>
+
+#include "Common/Types.h"
+
+/**@brief Events of devices which happen at a given emulated cycle
+ *
+ * Devices schedule callbacks for the cycle they are due instead of being
+ * polled every instruction. The CPU advances the cycle count after every
+ * instruction it executed and only has to check the earliest deadline. As
+ * time is counted in emulated cycles, events happen at the same point of
+ * every run no matter how fast the host is.
+ */
+namespace Core::Scheduler
+{
+//! Emulated cycles per second. Every instruction takes one cycle (see
+//! CPU::clock_speed)
+constexpr u64 FREQUENCY = 5'000'000;
+
+//! Cycle of events which never happen
+constexpr u64 NEVER = std::numeric_limits<u64>::max();
+
+using Callback = std::function<void()>;
+using EventID = u64;
+
+//! Cycles since the machine started
+extern u64 cycles;
+
+//! Cycle of the earliest event, NEVER if there is none
+extern u64 next;
+
+//! Drop all events and start over at cycle 0
+void Reset();
+
+//! Call callback once cycle is reached. Events due at the same cycle run in
+//! the order they were scheduled
+EventID Schedule(u64 cycle, Callback callback);
+
+//! Call callback delay cycles from now
+EventID ScheduleIn(u64 delay, Callback callback);
+
+//! Remove an event which hasn't happened yet
+void Cancel(EventID id);
+
+//! Copy of the cycle count and the pending events (see Debug::Checkpoint)
+std::any SaveState();
+
+//! Go back to a state returned by SaveState()
+void LoadState(const std::any& state);
+
+//! \cond PRIVATE
+void RunDue();
+//! \endcond
+
+//! Let count cycles pass and run the events that became due
+inline void Advance(u64 count)
+{
+  cycles += count;
+
+  if (cycles >= next)
+    RunDue();
+}
+} // namespace Core::Scheduler
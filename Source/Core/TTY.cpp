@@ -10,10 +10,28 @@
 #include "Common/String.h"
 
 #include "Core/HW/VGA.h"
+#include "Core/Memory.h"
+
+// Keyboard buffer in the BIOS data area (segment 40h): Offsets of the oldest
+// key and of the slot after the newest one, and the 16 slots of the buffer
+constexpr u16 BIOS_DATA = 0x0040;
+constexpr u16 BUFFER_HEAD = 0x001A;
+constexpr u16 BUFFER_TAIL = 0x001C;
+constexpr u16 BUFFER_START = 0x001E;
+constexpr u16 BUFFER_END = 0x003E;
 
 static u8 s_column = 0;
 static u8 s_row = 0;
 
+static u16& GetHead() { return Core::Memory::Get<u16>(BIOS_DATA, BUFFER_HEAD); }
+static u16& GetTail() { return Core::Memory::Get<u16>(BIOS_DATA, BUFFER_TAIL); }
+
+static u16 GetNextSlot(u16 slot)
+{
+  slot += sizeof(u16);
+  return slot == BUFFER_END ? BUFFER_START : slot;
+}
+
 void TTY::Write(const std::string& string)
 {
   for (char c : string)
@@ -47,6 +65,7 @@ void TTY::Write(const char c)
   }
 
   Core::HW::VGA::GetBuffer()[(s_row * 80 + s_column) * sizeof(u16)] = c;
+  Core::HW::VGA::Invalidate(s_row, s_column);
   s_column++;
 
   s_column %= 80;
@@ -83,14 +102,37 @@ void TTY::Clear()
       Core::HW::VGA::GetBuffer()[(y * 80 + x) * sizeof(u16)] = 0;
     }
   }
+
+  Core::HW::VGA::Invalidate();
+}
+
+void TTY::ClearInput() { GetHead() = GetTail() = BUFFER_START; }
+
+bool TTY::PushKey(u16 key)
+{
+  u16& tail = GetTail();
+  const u16 next = GetNextSlot(tail);
+
+  // One slot stays free to tell a full buffer from an empty one
+  if (next == GetHead())
+    return false;
+
+  Core::Memory::Get<u16>(BIOS_DATA, tail) = key;
+  tail = next;
+  return true;
 }
 
-char TTY::Read()
+u16 TTY::PeekKey() { return Core::Memory::Get<u16>(BIOS_DATA, GetHead()); }
+
+u16 TTY::ReadKey()
 {
-  LOG("[TTY STUB] Read");
-  return 'A';
+  const u16 key = PeekKey();
+  GetHead() = GetNextSlot(GetHead());
+  return key;
 }
 
+char TTY::Read() { return static_cast<char>(ReadKey()); }
+
 u8 TTY::GetCursorRow() { return s_row; }
 
 void TTY::SetCursorRow(u8 row) { s_row = row; }
@@ -99,8 +141,4 @@ u8 TTY::GetCursorColumn() { return s_column; }
 
 void TTY::SetCursorColumn(u8 column) { s_column = column; }
 
-bool TTY::IsCharAvailable()
-{
-  LOG("[TTY STUB] Char available");
-  return false;
-}
+bool TTY::IsCharAvailable() { return GetHead() != GetTail(); }
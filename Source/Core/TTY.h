@@ -21,6 +21,18 @@ void SetCursorRow(u8 row);
 u8 GetCursorColumn();
 void SetCursorColumn(u8 column);
 void Clear();
-char Read();
+
+//! Empty the keyboard buffer of the BIOS
+void ClearInput();
+//! Append a key (scan code in the high byte, character in the low byte) to
+//! the keyboard buffer. Returns false if it is full
+bool PushKey(u16 key);
+//! Whether the keyboard buffer holds a key
 bool IsCharAvailable();
+//! Oldest key in the keyboard buffer, which must not be empty
+u16 PeekKey();
+//! Remove the oldest key from the keyboard buffer, which must not be empty
+u16 ReadKey();
+//! Character of ReadKey()
+char Read();
 } // namespace TTY
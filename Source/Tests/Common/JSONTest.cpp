@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include "Common/JSON.h"
+
+TEST(JSON, Parse)
+{
+  JSON::Value value;
+
+  ASSERT_TRUE(JSON::Parse(
+      R"({"a": [1, -2.5, 3e2], "b": {"c": "d\"\né"}, "e": true,)"
+      R"( "f": null})",
+      value));
+
+  ASSERT_TRUE(value.IsObject());
+  ASSERT_EQ(value["a"].AsArray().size(), 3u);
+  ASSERT_EQ(value["a"].AsArray()[1].AsNumber(), -2.5);
+  ASSERT_EQ(value["a"].AsArray()[2].AsNumber(), 300);
+  ASSERT_EQ(value["b"]["c"].AsString(), "d\"\n\xc3\xa9");
+  ASSERT_TRUE(value["e"].AsBool());
+  ASSERT_TRUE(value.Has("f"));
+  ASSERT_TRUE(value["f"].IsNull());
+  ASSERT_FALSE(value.Has("g"));
+  ASSERT_TRUE(value["g"].IsNull());
+}
+
+TEST(JSON, Errors)
+{
+  JSON::Value value;
+  std::string error;
+
+  ASSERT_FALSE(JSON::Parse("", value));
+  ASSERT_FALSE(JSON::Parse("[1, 2", value));
+  ASSERT_FALSE(JSON::Parse("{\"a\" 1}", value));
+  ASSERT_FALSE(JSON::Parse("\"abc", value));
+  ASSERT_FALSE(JSON::Parse("1 2", value));
+  ASSERT_FALSE(JSON::Parse("-", value, &error));
+  ASSERT_FALSE(error.empty());
+  ASSERT_FALSE(JSON::Parse(std::string(1000, '['), value));
+}
+
+TEST(JSON, RoundTrip)
+{
+  JSON::Value value;
+
+  value["name"] = "BM_Step/16";
+  value["time"] = 1234.5;
+  value["list"].Append(1);
+  value["list"].Append(false);
+  value["empty"] = JSON::Value::Object();
+
+  ASSERT_EQ(JSON::Write(value, 0),
+            R"({"empty":{},"list":[1,false],)"
+            R"("name":"BM_Step/16","time":1234.5})");
+
+  JSON::Value parsed;
+  ASSERT_TRUE(JSON::Parse(JSON::Write(value), parsed));
+  ASSERT_EQ(JSON::Write(parsed, 0), JSON::Write(value, 0));
+}
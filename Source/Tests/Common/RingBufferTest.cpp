@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "Common/RingBuffer.h"
+#include "Common/Types.h"
+
+TEST(RingBuffer, PushPop)
+{
+  RingBuffer<int, 4> buffer;
+  int value;
+
+  ASSERT_TRUE(buffer.IsEmpty());
+  ASSERT_FALSE(buffer.Pop(value));
+
+  for (int i = 0; i < 4; i++)
+    ASSERT_TRUE(buffer.Push(i));
+
+  ASSERT_FALSE(buffer.Push(4));
+  ASSERT_EQ(buffer.Size(), 4u);
+
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(buffer.Pop(value));
+    ASSERT_EQ(value, i);
+  }
+
+  ASSERT_TRUE(buffer.IsEmpty());
+}
+
+TEST(RingBuffer, Threaded)
+{
+  RingBuffer<u32, 64> buffer;
+  constexpr u32 COUNT = 100'000;
+
+  std::thread producer([&buffer] {
+    for (u32 i = 0; i < COUNT; i++) {
+      while (!buffer.Push(i))
+        std::this_thread::yield();
+    }
+  });
+
+  for (u32 i = 0; i < COUNT; i++) {
+    u32 value;
+
+    while (!buffer.Pop(value))
+      std::this_thread::yield();
+
+    ASSERT_EQ(value, i);
+  }
+
+  producer.join();
+}
@@ -0,0 +1,86 @@
+#include "Core/CPU/CPU.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "Common/Types.h"
+
+#include "Core/CPU/Breakpoint.h"
+#include "Core/Core.h"
+#include "Core/Debug/Checkpoint.h"
+#include "Core/HW/Keyboard.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+
+// STI, MOV AX,40h, MOV ES,AX, then MOV AL,ES:[6Ch], CMP AL,0, JE back until
+// the first timer tick, then HLT, MOV AL,ES:[6Ch], CMP AL,3, JB back until
+// the third one, INT 20h
+constexpr u8 PROGRAM[] = {0xFB, 0xB8, 0x40, 0x00, 0x8E, 0xC0, 0x26,
+                          0xA0, 0x6C, 0x00, 0x3C, 0x00, 0x74, 0xF8,
+                          0xF4, 0x26, 0xA0, 0x6C, 0x00, 0x3C, 0x03,
+                          0x72, 0xF7, 0xCD, 0x20};
+
+constexpr u16 HLT_OFFSET = 0x010E;
+constexpr u16 INT_OFFSET = 0x0117;
+
+// Run the program with a key typed ahead. Replays have to deliver the timer
+// ticks (while spinning and while halted) and the key at the same points
+static void RunProgram(u64 interval)
+{
+  {
+    std::ofstream ofs("CheckpointTest.com", std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char*>(PROGRAM), sizeof(PROGRAM));
+  }
+
+  CPU::clock_speed = 0;
+  Debug::Checkpoint::active = true;
+  Debug::Checkpoint::interval = interval;
+
+  ASSERT_TRUE(HW::Keyboard::PushChar('a'));
+  ASSERT_TRUE(BootCOM("CheckpointTest.com"));
+
+  ASSERT_EQ(Memory::Read<u32>(0x0040, 0x006C), 3u);
+  ASSERT_EQ(static_cast<u16>(CPU::CS), 0x0800);
+  ASSERT_EQ(CPU::IP, INT_OFFSET + 2);
+}
+
+// Keyboard buffer head and tail
+static u32 GetKeys() { return Memory::Read<u32>(0x0040, 0x001A); }
+
+TEST(Checkpoint, StepBackOverInterrupts)
+{
+  // A single checkpoint at the start, so the replay goes through everything
+  RunProgram(1'000'000'000);
+
+  const u64 instructions = CPU::instructions;
+  const u32 keys = GetKeys();
+
+  ASSERT_NE(keys >> 16, keys & 0xFFFF);
+
+  ASSERT_TRUE(Debug::Checkpoint::StepBack());
+
+  ASSERT_EQ(CPU::instructions, instructions - 1);
+  ASSERT_EQ(static_cast<u16>(CPU::CS), 0x0800);
+  ASSERT_EQ(CPU::IP, INT_OFFSET);
+  ASSERT_EQ(Memory::Read<u32>(0x0040, 0x006C), 3u);
+  ASSERT_EQ(GetKeys(), keys);
+}
+
+TEST(Checkpoint, ReverseContinueOverInterrupts)
+{
+  // Enough checkpoints to get thinned out
+  RunProgram(1'000);
+
+  CPU::AddBreakpoint({0x0800, HLT_OFFSET});
+  const bool went_back = Debug::Checkpoint::ReverseContinue();
+  CPU::RemoveBreakpoint({0x0800, HLT_OFFSET});
+
+  ASSERT_TRUE(went_back);
+
+  // The last HLT, waiting for the third tick
+  ASSERT_EQ(static_cast<u16>(CPU::CS), 0x0800);
+  ASSERT_EQ(CPU::IP, HLT_OFFSET);
+  ASSERT_EQ(Memory::Read<u32>(0x0040, 0x006C), 2u);
+}
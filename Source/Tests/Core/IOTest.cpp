@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "Common/Types.h"
+
+#include "Core/HW/IO.h"
+
+using namespace Core;
+
+static std::vector<std::pair<u16, u8>> s_writes;
+
+static u8 ReadPort(u16 port) { return static_cast<u8>(port); }
+
+static void WritePort(u16 port, u8 value) { s_writes.push_back({port, value}); }
+
+TEST(IO, Dispatch)
+{
+  HW::IO::Reset();
+  HW::IO::RegisterPortHandler({0x40, 0x43}, ReadPort, WritePort);
+
+  ASSERT_EQ(HW::IO::Read(0x42), 0x42);
+  ASSERT_EQ(HW::IO::Read(0x44), 0xFF);
+
+  // Word accesses are two byte accesses, low byte first
+  ASSERT_EQ(HW::IO::ReadWord(0x40), 0x4140);
+  ASSERT_EQ(HW::IO::ReadWord(0x43), 0xFF43);
+
+  s_writes.clear();
+  HW::IO::WriteWord(0x42, 0x1234);
+  HW::IO::Write(0x50, 0x56);
+
+  const std::vector<std::pair<u16, u8>> expected = {{0x42, 0x34},
+                                                    {0x43, 0x12}};
+  ASSERT_EQ(s_writes, expected);
+}
+
+TEST(IO, Replace)
+{
+  HW::IO::Reset();
+  HW::IO::RegisterPortHandler({0x60, 0x64}, ReadPort, WritePort);
+  HW::IO::RegisterPortHandler({0x62, 0x62}, [](u16) -> u8 { return 0; },
+                              WritePort);
+
+  ASSERT_EQ(HW::IO::Read(0x61), 0x61);
+  ASSERT_EQ(HW::IO::Read(0x62), 0x00);
+
+  HW::IO::Reset();
+  ASSERT_EQ(HW::IO::Read(0x61), 0xFF);
+}
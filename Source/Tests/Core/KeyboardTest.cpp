@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "Common/Types.h"
+
+#include "Core/HW/IO.h"
+#include "Core/HW/Keyboard.h"
+#include "Core/HW/PIC.h"
+#include "Core/Scheduler.h"
+
+using namespace Core;
+
+TEST(Keyboard, Layout)
+{
+  for (char c = ' '; c <= '~'; c++) {
+    const u8 code = HW::Keyboard::GetScanCode(c);
+    ASSERT_NE(code, 0) << c;
+
+    const bool shift = HW::Keyboard::ToChar(code, false) != c;
+    ASSERT_EQ(HW::Keyboard::ToChar(code, shift), c);
+  }
+
+  ASSERT_EQ(HW::Keyboard::GetScanCode('\r'), 0x1C);
+  ASSERT_EQ(HW::Keyboard::ToChar(0x3B, false), 0); // F1
+}
+
+TEST(Keyboard, Controller)
+{
+  Scheduler::Reset();
+  HW::IO::Reset();
+  HW::PIC::Init();
+  HW::Keyboard::Init();
+
+  ASSERT_TRUE(HW::Keyboard::PushChar('A'));
+
+  // Shift, A, release A, release shift; one at a time
+  for (u8 code : {0x2A, 0x1E, 0x9E, 0xAA}) {
+    HW::Keyboard::Update();
+    ASSERT_EQ(HW::IO::Read(0x64) & 0x01, 0x01);
+
+    HW::Keyboard::Update();
+    ASSERT_EQ(HW::IO::Read(0x60), code);
+    ASSERT_EQ(HW::IO::Read(0x64) & 0x01, 0x00);
+  }
+
+  // The queue is empty now
+  HW::Keyboard::Update();
+  ASSERT_EQ(HW::IO::Read(0x64) & 0x01, 0x00);
+
+  // Command bytes get acknowledged
+  HW::IO::Write(0x60, 0xED);
+  ASSERT_EQ(HW::IO::Read(0x60), 0xFA);
+}
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "Common/Types.h"
+
+#include "Core/Memory.h"
+
+using namespace Core;
+
+TEST(Memory, Wraparound)
+{
+  Memory::Get<u8>(0x0000, 0x0000) = 0x12;
+  Memory::Get<u8>(0x0000, 0xFFEF) = 0x34;
+
+  // FFFF:0010 is 1 MiB, which wraps around to 0 on an 8086
+  ASSERT_EQ(Memory::Get<u8>(0xFFFF, 0x0010), 0x12);
+  ASSERT_EQ(Memory::Get<u8>(0xFFFF, 0xFFFF), 0x34);
+
+  Memory::Get<u16>(0xFFFF, 0x000F) = 0xABCD;
+
+  ASSERT_EQ(Memory::Get<u8>(0xF000, 0xFFFF), 0xCD);
+  ASSERT_EQ(Memory::Get<u8>(0x0000, 0x0000), 0xAB);
+}
+
+TEST(Memory, A20)
+{
+  ASSERT_FALSE(Memory::IsA20Enabled());
+
+  Memory::Get<u8>(0x0000, 0x0100) = 0x56;
+
+  Memory::SetA20Enabled(true);
+
+  // The HMA is memory of its own now
+  ASSERT_EQ(Memory::Get<u8>(0xFFFF, 0x0110), 0x00);
+
+  Memory::Get<u8>(0xFFFF, 0x0110) = 0x78;
+  ASSERT_EQ(Memory::Get<u8>(0x0000, 0x0100), 0x56);
+
+  Memory::SetA20Enabled(false);
+
+  ASSERT_EQ(Memory::Get<u8>(0xFFFF, 0x0110), 0x56);
+
+  // Enabling it again brings back the contents of the HMA
+  Memory::SetA20Enabled(true);
+  ASSERT_EQ(Memory::Get<u8>(0xFFFF, 0x0110), 0x78);
+
+  Memory::SetA20Enabled(false);
+}
+
+TEST(Memory, ROM)
+{
+  const u8 rom[Memory::PAGE_SIZE] = {0x11, 0x22};
+
+  Memory::MapROM(0xE0000, rom, sizeof(rom));
+  ASSERT_EQ(Memory::GetPageType(0xE0000), Memory::PageType::ROM);
+
+  Memory::Get<u16>(0xE000, 0x0000) = 0xFFFF;
+  Memory::Commit();
+
+  ASSERT_EQ(Memory::Read<u16>(0xE000, 0x0000), 0x2211);
+
+  Memory::MapRAM(0xE0000, sizeof(rom));
+  ASSERT_EQ(Memory::GetPageType(0xE0000), Memory::PageType::RAM);
+}
+
+TEST(Memory, Spanning)
+{
+  const u8 rom[Memory::PAGE_SIZE] = {0x11, 0x22};
+
+  Memory::MapROM(0xE1000, rom, sizeof(rom));
+
+  // Only the byte in RAM changes, even though the page of the first byte
+  // needs no handling
+  Memory::Get<u16>(0xE000, 0x0FFF) = 0xABCD;
+  Memory::Commit();
+
+  ASSERT_EQ(Memory::Read<u8>(0xE000, 0x0FFF), 0xCD);
+  ASSERT_EQ(Memory::Read<u16>(0xE000, 0x0FFF), 0x11CD);
+
+  // Reads reaching into a Device let it fill in its byte
+  Memory::Device device;
+  device.read = [](u32, u8* data, u32 size) {
+    for (u32 i = 0; i < size; i++)
+      data[i] = 0x33;
+  };
+
+  Memory::MapDevice(0xE1000, sizeof(rom), device);
+  ASSERT_EQ(Memory::Read<u16>(0xE000, 0x0FFF), 0x33CD);
+
+  Memory::MapRAM(0xE1000, sizeof(rom));
+}
+
+TEST(Memory, Device)
+{
+  u32 written = 0, writes = 0;
+
+  Memory::Device device;
+  device.read = [](u32 address, u8* data, u32 size) {
+    for (u32 i = 0; i < size; i++)
+      data[i] = static_cast<u8>(address + i);
+  };
+  device.write = [&](u32 address, const u8* data, u32) {
+    written = address + data[0];
+    writes++;
+  };
+
+  Memory::MapDevice(0xD0000, Memory::PAGE_SIZE, device);
+
+  ASSERT_EQ(Memory::Read<u8>(0xD000, 0x0012), 0x12);
+
+  // Reads don't count as writes, changes do
+  u8 value = Memory::Get<u8>(0xD000, 0x0034);
+  Memory::Commit();
+  ASSERT_EQ(value, 0x34);
+  ASSERT_EQ(writes, 0u);
+
+  Memory::Get<u8>(0xD000, 0x0056) = 0x01;
+  Memory::Commit();
+  ASSERT_EQ(writes, 1u);
+  ASSERT_EQ(written, 0xD0057u);
+
+  Memory::MapRAM(0xD0000, Memory::PAGE_SIZE);
+}
+
+TEST(Memory, Extra)
+{
+  constexpr u32 FRAME = 0xD0000;
+
+  Memory::Get<u8>(0xD000, 0x0000) = 0x12;
+  Memory::Reset(0x20000, 2 * Memory::EXTRA_PAGE_SIZE);
+
+  ASSERT_EQ(Memory::Get<u8>(0xD000, 0x0000), 0x00);
+  ASSERT_EQ(Memory::GetPageType(0x30000), Memory::PageType::None);
+
+  // Nothing is there above the conventional memory
+  Memory::Get<u8>(0x3000, 0x0000) = 0x34;
+  Memory::Commit();
+  ASSERT_EQ(Memory::Read<u8>(0x3000, 0x0000), 0x00);
+
+  Memory::Get<u8>(0xD000, 0x0000) = 0x56;
+
+  // The same extra page twice
+  Memory::MapExtra(FRAME, Memory::EXTRA_PAGE_SIZE, Memory::EXTRA_PAGE_SIZE);
+  Memory::MapExtra(FRAME + Memory::EXTRA_PAGE_SIZE, Memory::EXTRA_PAGE_SIZE,
+                   Memory::EXTRA_PAGE_SIZE);
+
+  Memory::Get<u8>(0xD000, 0x0000) = 0x78;
+  ASSERT_EQ(Memory::Get<u8>(0xD400, 0x0000), 0x78);
+  ASSERT_EQ(Memory::extra[Memory::EXTRA_PAGE_SIZE], 0x78);
+
+  Memory::UnmapExtra(FRAME, 2 * Memory::EXTRA_PAGE_SIZE);
+  ASSERT_EQ(Memory::Get<u8>(0xD000, 0x0000), 0x56);
+
+  Memory::Reset(Memory::CONVENTIONAL_SIZE, 0);
+}
+
+TEST(Memory, File)
+{
+  const std::string path = "MemoryTest.bin";
+  std::vector<u8> data(2 * Memory::PAGE_SIZE, 0x9A);
+
+  std::ofstream(path, std::ios::binary)
+      .write(reinterpret_cast<const char*>(data.data()), data.size());
+
+  ASSERT_TRUE(Memory::MapFile(0x20000, path, 0, Memory::PAGE_SIZE));
+  ASSERT_EQ(Memory::Get<u8>(0x2000, 0x0000), 0x9A);
+  ASSERT_EQ(Memory::Get<u8>(0x2000, 0x1000), 0x00);
+
+  // Writes stay private
+  Memory::Get<u8>(0x2000, 0x0000) = 0xBC;
+
+  ASSERT_TRUE(Memory::MapFile(0x30000, path, 0, Memory::PAGE_SIZE));
+  ASSERT_EQ(Memory::Get<u8>(0x3000, 0x0000), 0x9A);
+
+  ASSERT_FALSE(Memory::MapFile(0x20000, path, 0, 3 * Memory::PAGE_SIZE));
+
+  Memory::Reset(Memory::CONVENTIONAL_SIZE, 0);
+  ASSERT_EQ(Memory::Get<u8>(0x2000, 0x0000), 0x00);
+
+  std::remove(path.c_str());
+}
@@ -0,0 +1,80 @@
+// CPU.h declares the handler of the TEST instruction, which has to come
+// before the macro of the same name
+#include "Core/CPU/CPU.h"
+
+#include <gtest/gtest.h>
+
+#include "Common/Types.h"
+
+#include "Core/HW/PIC.h"
+
+using namespace Core;
+
+static bool IsPending() { return CPU::events & CPU::EVENT_INTERRUPT; }
+
+TEST(PIC, Priority)
+{
+  HW::PIC::Init();
+  HW::PIC::Write(0x21, 0x00);
+
+  HW::PIC::RaiseIRQ(3);
+  HW::PIC::RaiseIRQ(1);
+  ASSERT_TRUE(IsPending());
+
+  // IRQ 1 blocks IRQ 3 until it ends
+  ASSERT_EQ(HW::PIC::Acknowledge(), 0x09);
+  ASSERT_FALSE(IsPending());
+
+  // A higher priority IRQ still gets through
+  HW::PIC::RaiseIRQ(0);
+  ASSERT_TRUE(IsPending());
+  ASSERT_EQ(HW::PIC::Acknowledge(), 0x08);
+
+  // Non-specific EOIs end the highest priority IRQ in service first
+  HW::PIC::Write(0x20, 0x20);
+  ASSERT_FALSE(IsPending());
+  HW::PIC::Write(0x20, 0x20);
+  ASSERT_TRUE(IsPending());
+  ASSERT_EQ(HW::PIC::Acknowledge(), 0x0B);
+
+  // Reading the ISR through OCW3
+  HW::PIC::Write(0x20, 0x0B);
+  ASSERT_EQ(HW::PIC::Read(0x20), 1 << 3);
+
+  HW::PIC::Write(0x20, 0x63);
+  ASSERT_EQ(HW::PIC::Read(0x20), 0);
+}
+
+TEST(PIC, Mask)
+{
+  HW::PIC::Init();
+  ASSERT_EQ(HW::PIC::Read(0x21), 0xBC);
+
+  // Masked requests stay pending until they are unmasked
+  HW::PIC::RaiseIRQ(2);
+  ASSERT_FALSE(IsPending());
+
+  HW::PIC::Write(0x21, 0xB8);
+  ASSERT_TRUE(IsPending());
+  ASSERT_EQ(HW::PIC::Acknowledge(), 0x0A);
+}
+
+TEST(PIC, Reinitialize)
+{
+  HW::PIC::Init();
+  HW::PIC::RaiseIRQ(0);
+
+  // ICW1-ICW4 as DOS extenders reprogram it: Vectors 70h-77h, auto EOI
+  HW::PIC::Write(0x20, 0x11);
+  HW::PIC::Write(0x21, 0x70);
+  HW::PIC::Write(0x21, 0x04);
+  HW::PIC::Write(0x21, 0x03);
+  ASSERT_FALSE(IsPending());
+  ASSERT_EQ(HW::PIC::Read(0x21), 0x00);
+
+  HW::PIC::RaiseIRQ(0);
+  ASSERT_EQ(HW::PIC::Acknowledge(), 0x70);
+
+  HW::PIC::Write(0x20, 0x0B);
+  ASSERT_EQ(HW::PIC::Read(0x20), 0);
+}
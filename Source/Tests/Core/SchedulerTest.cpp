@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "Common/Types.h"
+
+#include "Core/Scheduler.h"
+
+using namespace Core;
+
+TEST(Scheduler, Order)
+{
+  Scheduler::Reset();
+
+  std::vector<int> order;
+  Scheduler::Schedule(20, [&] { order.push_back(2); });
+  Scheduler::Schedule(10, [&] { order.push_back(0); });
+  Scheduler::Schedule(10, [&] { order.push_back(1); });
+
+  ASSERT_EQ(Scheduler::next, 10u);
+
+  Scheduler::Advance(9);
+  ASSERT_TRUE(order.empty());
+
+  // Events at the same cycle run in the order they were scheduled
+  Scheduler::Advance(1);
+  ASSERT_EQ(order, (std::vector<int>{0, 1}));
+  ASSERT_EQ(Scheduler::next, 20u);
+
+  // Skipping past an event still runs it
+  Scheduler::Advance(15);
+  ASSERT_EQ(order, (std::vector<int>{0, 1, 2}));
+}
+
+TEST(Scheduler, Cancel)
+{
+  Scheduler::Reset();
+
+  int calls = 0;
+  const auto id = Scheduler::ScheduleIn(5, [&] { calls++; });
+  Scheduler::ScheduleIn(8, [&] { calls += 10; });
+  Scheduler::Cancel(id);
+
+  ASSERT_EQ(Scheduler::next, 8u);
+
+  Scheduler::Advance(10);
+  ASSERT_EQ(calls, 10);
+}
+
+TEST(Scheduler, Periodic)
+{
+  Scheduler::Reset();
+
+  int ticks = 0;
+  std::function<void()> tick = [&] {
+    ticks++;
+    Scheduler::ScheduleIn(4, tick);
+  };
+  Scheduler::ScheduleIn(4, tick);
+
+  for (int i = 0; i < 40; i++)
+    Scheduler::Advance(1);
+
+  ASSERT_EQ(ticks, 10);
+}
@@ -0,0 +1,335 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+// Runs 8088 single-step test vectors (the JSON format of the SingleStepTests
+// suites) against every execution engine of CPU::GetEngines(). Every vector
+// sets up registers and RAM, executes one instruction and compares the result.
+//
+// The known failures file lists bugs that are still to be fixed, one line of
+// "engine file part  # reason" each. A part is a register, a flag (CF, PF,
+// AF, ZF, SF, OF, ...), "ram" or "exception". Vectors of that file which only
+// get listed parts wrong are reported as known failures but don't fail the
+// test, so everything else that passes today is protected.
+//
+// Usage: SingleStepTest [--metadata metadata.json]
+//                       [--known-failures known-failures.txt] vectors.json...
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Common/JSON.h"
+#include "Common/String.h"
+#include "Common/Types.h"
+
+#include "Core/CPU/CPU.h"
+#include "Core/CPU/Engine.h"
+#include "Core/Memory.h"
+
+using namespace Core;
+
+// Flags which exist on an 8088 and are emulated (TF is not)
+constexpr u16 FLAGS_MASK = 0x0ED5;
+
+// Mismatches printed per file, the rest are only counted
+constexpr int MAX_REPORTS = 5;
+
+static const char* const s_registers[] = {"ax", "bx", "cx", "dx", "cs",
+                                          "ds", "es", "ss", "ip", "bp",
+                                          "sp", "si", "di", "flags"};
+
+// Names of the flag bits, mismatches are reported per flag
+static const std::pair<u16, const char*> s_flags[] = {
+    {1 << 0, "CF"}, {1 << 2, "PF"},  {1 << 4, "AF"},  {1 << 6, "ZF"},
+    {1 << 7, "SF"}, {1 << 9, "IF"}, {1 << 10, "DF"}, {1 << 11, "OF"}};
+
+namespace
+{
+//! Outcome of one vector
+struct Mismatch {
+  //! First difference found, empty if there was none
+  std::string description;
+  //! Everything that differs (see the known failures file)
+  std::set<std::string> parts;
+};
+} // namespace
+
+// Parts of each "engine file" which are known to be wrong
+using KnownFailures = std::map<std::string, std::set<std::string>>;
+
+static std::map<std::string, u16> GetRegisters()
+{
+  return {{"ax", CPU::AX}, {"bx", CPU::BX}, {"cx", CPU::CX},
+          {"dx", CPU::DX}, {"cs", CPU::CS}, {"ds", CPU::DS},
+          {"es", CPU::ES}, {"ss", CPU::SS}, {"ip", CPU::IP},
+          {"bp", CPU::BP}, {"sp", CPU::SP}, {"si", CPU::SI},
+          {"di", CPU::DI}, {"flags", CPU::GetFlags()}};
+}
+
+static void SetRegisters(const JSON::Value& regs)
+{
+  auto Get = [&regs](const char* name) {
+    return static_cast<u16>(regs[name].AsNumber());
+  };
+
+  CPU::Context context{Get("ax"), Get("bx"), Get("cx"), Get("dx"),
+                       Get("cs"), Get("ds"), Get("es"), Get("ss"),
+                       Get("ip"), Get("bp"), Get("sp"), Get("si"),
+                       Get("di"), false,     false,     false,
+                       false,     false,     false,     false,
+                       false,     CPU::RepeatMode::None};
+  CPU::LoadContext(context);
+  CPU::SetFlags(Get("flags"));
+}
+
+static std::string GetFileName(const std::string& path)
+{
+  return path.substr(path.find_last_of('/') + 1);
+}
+
+static bool LoadKnownFailures(const std::string& path, KnownFailures& known)
+{
+  std::ifstream ifs(path);
+
+  if (!ifs.good()) {
+    std::cerr << "Failed to open " << path << std::endl;
+    return false;
+  }
+
+  for (std::string line; std::getline(ifs, line);) {
+    const auto comment = line.find('#');
+    std::istringstream ss(line.substr(0, comment));
+    std::string engine, file, part;
+
+    if (!(ss >> engine >> file >> part))
+      continue;
+
+    // Known failures without an explanation tend to stay forever
+    if (comment == std::string::npos ||
+        line.find_first_not_of(" #", comment) == std::string::npos) {
+      std::cerr << path << ": No reason given for '" << line << "'"
+                << std::endl;
+      return false;
+    }
+
+    known[engine + " " + file].insert(part);
+  }
+
+  return true;
+}
+
+// Get the flags that are defined after executing the opcode of file (e.g.
+// "80.7.json") according to the metadata of the suite
+static u16 GetFlagsMask(const JSON::Value& metadata, const std::string& file)
+{
+  std::string name = GetFileName(file);
+  name = name.substr(0, name.rfind(".json"));
+
+  const std::string opcode = name.substr(0, 2);
+  const std::string reg = name.size() > 3 ? name.substr(3) : "";
+
+  const auto& entry = metadata["opcodes"][opcode];
+  const auto& reg_entry = entry["reg"][reg];
+
+  if (reg_entry["flags-mask"].IsNumber())
+    return static_cast<u16>(reg_entry["flags-mask"].AsNumber()) & FLAGS_MASK;
+
+  if (entry["flags-mask"].IsNumber())
+    return static_cast<u16>(entry["flags-mask"].AsNumber()) & FLAGS_MASK;
+
+  return FLAGS_MASK;
+}
+
+// Run one vector and compare the outcome
+static Mismatch Run(const CPU::Engine& engine, const JSON::Value& test,
+                    u16 flags_mask)
+{
+  u8* ram = Memory::base;
+  const auto& initial = test["initial"];
+  const auto& final = test["final"];
+
+  SetRegisters(initial["regs"]);
+
+  for (const auto& entry : initial["ram"].AsArray()) {
+    const auto& pair = entry.AsArray();
+    ram[static_cast<u32>(pair[0].AsNumber())] =
+        static_cast<u8>(pair[1].AsNumber());
+  }
+
+  Mismatch mismatch;
+
+  auto Add = [&mismatch](const std::string& part,
+                         const std::string& description) {
+    if (mismatch.description.empty())
+      mismatch.description = description;
+
+    mismatch.parts.insert(part);
+  };
+
+  // Keep logging of the emulator out of the report
+  std::cout.setstate(std::ios::failbit);
+
+  try {
+    engine.step();
+  } catch (CPU::CPUException& e) {
+    Add("exception", std::string("Exception: ") + e.what());
+  }
+
+  std::cout.clear();
+
+  const auto& registers = GetRegisters();
+
+  for (const char* name : s_registers) {
+    if (mismatch.parts.count("exception"))
+      break;
+
+    const auto& regs =
+        final["regs"].Has(name) ? final["regs"] : initial["regs"];
+    u16 expected = static_cast<u16>(regs[name].AsNumber());
+    u16 actual = registers.at(name);
+
+    if (std::string(name) == "flags") {
+      expected &= flags_mask;
+      actual &= flags_mask;
+    }
+
+    if (expected == actual)
+      continue;
+
+    const std::string description = std::string(name) + " is " +
+                                    String::ToHex(actual) + ", expected " +
+                                    String::ToHex(expected);
+
+    if (std::string(name) != "flags") {
+      Add(name, description);
+      continue;
+    }
+
+    for (const auto& [bit, flag] : s_flags) {
+      if ((expected ^ actual) & bit)
+        Add(flag, description);
+    }
+  }
+
+  for (const auto& entry : final["ram"].AsArray()) {
+    const auto& pair = entry.AsArray();
+    const u32 address = static_cast<u32>(pair[0].AsNumber());
+    const u8 expected = static_cast<u8>(pair[1].AsNumber());
+
+    if (!mismatch.parts.count("exception") && ram[address] != expected) {
+      Add("ram", "[" + String::ToHex(address) + "] is " +
+                     String::ToHex(ram[address]) + ", expected " +
+                     String::ToHex(expected));
+    }
+  }
+
+  // Leave RAM clean for the next vector
+  for (const auto& entry : initial["ram"].AsArray())
+    ram[static_cast<u32>(entry.AsArray()[0].AsNumber())] = 0;
+  for (const auto& entry : final["ram"].AsArray())
+    ram[static_cast<u32>(entry.AsArray()[0].AsNumber())] = 0;
+
+  return mismatch;
+}
+
+int main(int argc, char** argv)
+{
+  JSON::Value metadata;
+  KnownFailures known;
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+
+    if (arg == "--metadata" && i + 1 < argc) {
+      std::string error;
+      if (!JSON::ParseFile(argv[++i], metadata, &error)) {
+        std::cerr << error << std::endl;
+        return 1;
+      }
+    } else if (arg == "--known-failures" && i + 1 < argc) {
+      if (!LoadKnownFailures(argv[++i], known))
+        return 1;
+    } else {
+      files.push_back(arg);
+    }
+  }
+
+  if (files.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--metadata metadata.json] [--known-failures file] "
+                 "vectors.json..."
+              << std::endl;
+    return 1;
+  }
+
+  size_t total_failed = 0;
+
+  for (const auto& file : files) {
+    JSON::Value tests;
+    std::string error;
+
+    if (!JSON::ParseFile(file, tests, &error)) {
+      std::cerr << file << ": " << error << std::endl;
+      return 1;
+    }
+
+    const u16 flags_mask = GetFlagsMask(metadata, file);
+
+    for (const auto& engine : CPU::GetEngines()) {
+      const std::string key = std::string(engine.name) + " " + GetFileName(file);
+      const auto& allowed = known[key];
+      std::set<std::string> seen;
+      size_t failed = 0, known_failed = 0;
+
+      for (const auto& test : tests.AsArray()) {
+        const auto& mismatch = Run(engine, test, flags_mask);
+
+        if (mismatch.parts.empty())
+          continue;
+
+        seen.insert(mismatch.parts.begin(), mismatch.parts.end());
+
+        if (std::includes(allowed.begin(), allowed.end(),
+                          mismatch.parts.begin(), mismatch.parts.end())) {
+          known_failed++;
+          continue;
+        }
+
+        if (failed++ < MAX_REPORTS) {
+          std::cout << key << " "
+                    << static_cast<int>(test["idx"].AsNumber()) << " ("
+                    << test["name"].AsString()
+                    << "): " << mismatch.description << std::endl;
+        }
+      }
+
+      for (const auto& part : allowed) {
+        if (!seen.count(part))
+          std::cout << key << " gets " << part
+                    << " right now, remove it from the known failures"
+                    << std::endl;
+      }
+
+      std::cout << std::left << std::setw(12) << engine.name << file << ": "
+                << tests.AsArray().size() - failed - known_failed << "/"
+                << tests.AsArray().size() << " passed";
+
+      if (known_failed != 0)
+        std::cout << ", " << known_failed << " known failures";
+
+      std::cout << std::endl;
+
+      total_failed += failed;
+    }
+  }
+
+  return total_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+#include "Core/CPU/CPU.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <vector>
+
+#include "Common/Types.h"
+
+#include "Core/Core.h"
+#include "Core/Debug/Trace.h"
+
+using namespace Core;
+
+// STI, MOV AX,40h, MOV ES,AX, then MOV AL,ES:[6Ch], CMP AL,0, JE back until
+// the first timer tick, INT 20h
+constexpr u8 PROGRAM[] = {0xFB, 0xB8, 0x40, 0x00, 0x8E, 0xC0, 0x26, 0xA0,
+                          0x6C, 0x00, 0x3C, 0x00, 0x74, 0xF8, 0xCD, 0x20};
+
+TEST(Trace, Interrupts)
+{
+  {
+    std::ofstream ofs("TraceTest.com", std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char*>(PROGRAM), sizeof(PROGRAM));
+  }
+
+  CPU::clock_speed = 0;
+
+  ASSERT_TRUE(
+      Debug::Trace::Start("TraceTest.trace", Debug::Trace::Mode::Branches));
+  ASSERT_TRUE(BootCOM("TraceTest.com"));
+  Debug::Trace::Stop();
+
+  std::ifstream ifs("TraceTest.trace", std::ios::binary);
+  Debug::Trace::Header header;
+
+  ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+  ASSERT_EQ(header.version, Debug::Trace::VERSION);
+
+  std::vector<Debug::Trace::Record> records;
+
+  ASSERT_TRUE(Debug::Trace::DecodeBranches(
+      ifs, [&](const Debug::Trace::Record& record) {
+        records.push_back(record);
+        return true;
+      }));
+
+  // Decoding only follows the program through the timer tick if the
+  // interrupt got recorded
+  ASSERT_EQ(records.size(), CPU::instructions);
+
+  bool ticked = false;
+
+  for (const auto& record : records)
+    ticked |= record.cs == 0xF000 && record.ip == 0x0030;
+
+  ASSERT_TRUE(ticked);
+
+  // INT 20h
+  ASSERT_EQ(records.back().cs, 0x0800);
+  ASSERT_EQ(records.back().ip, 0x010E);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "Common/Types.h"
+
+#include "Core/HW/VGA.h"
+#include "Core/Memory.h"
+#include "Core/Scheduler.h"
+
+using namespace Core;
+
+namespace
+{
+class Backend : public HW::VGABackend
+{
+public:
+  void SetMode(u8) override {}
+
+  void Update(const std::vector<HW::VGA::Change>& changes) override
+  {
+    updates++;
+    last = changes;
+  }
+
+  int updates = 0;
+  std::vector<HW::VGA::Change> last;
+};
+} // namespace
+
+static void ExpectChange(const HW::VGA::Change& change, u8 row, u8 first,
+                         u8 last)
+{
+  EXPECT_EQ(change.row, row);
+  EXPECT_EQ(change.first, first);
+  EXPECT_EQ(change.last, last);
+}
+
+TEST(VGA, DirtyCells)
+{
+  Backend backend;
+  g_VGABackend = &backend;
+
+  Scheduler::Reset();
+  Memory::Reset(0xA0000, 0);
+  HW::VGA::Init();
+
+  // Everything is new at first
+  HW::VGA::Update();
+  ASSERT_EQ(backend.updates, 1);
+  ASSERT_EQ(backend.last.size(), HW::VGA::ROWS);
+  ExpectChange(backend.last[24], 24, 0, 79);
+
+  // Nothing changed, so the backend doesn't get called
+  HW::VGA::Update();
+  ASSERT_EQ(backend.updates, 1);
+
+  // A character and, further along row 2, an attribute
+  Memory::GetAt<u8>(0xB8000 + (2 * 80 + 5) * 2) = 'A';
+  Memory::GetAt<u8>(0xB8000 + (2 * 80 + 9) * 2 + 1) = 0x1F;
+  Memory::Commit();
+
+  HW::VGA::Update();
+  ASSERT_EQ(backend.updates, 2);
+  ASSERT_EQ(backend.last.size(), 1u);
+  ExpectChange(backend.last[0], 2, 5, 9);
+
+  // A write across the end of row 0
+  Memory::GetAt<u32>(0xB8000 + 79 * 2) = 0x07410741;
+  Memory::Commit();
+
+  HW::VGA::Update();
+  ASSERT_EQ(backend.last.size(), 2u);
+  ExpectChange(backend.last[0], 0, 79, 79);
+  ExpectChange(backend.last[1], 1, 0, 0);
+
+  // Pages after the first one aren't shown
+  Memory::GetAt<u8>(0xB8000 + 0x1000) = 'B';
+  Memory::Commit();
+
+  HW::VGA::Update();
+  ASSERT_EQ(backend.updates, 3);
+
+  g_VGABackend = nullptr;
+}
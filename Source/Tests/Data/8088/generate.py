@@ -0,0 +1,601 @@
+#!/usr/bin/env python3
+# Generates 8088 single-step test vectors in the layout of the SingleStepTests
+# suites from an independent model of the instructions below.
+#
+# python3 generate.py <output directory> <vectors per opcode>
+import json, random, os, sys, hashlib
+
+R16 = ["ax", "cx", "dx", "bx", "sp", "bp", "si", "di"]
+SEG = ["es", "cs", "ss", "ds"]
+
+CF, PF, AF, ZF, SF, TF, IF, DF, OF = 1, 4, 0x10, 0x40, 0x80, 0x100, 0x200, 0x400, 0x800
+DEFINED = 0xFD5
+LIMIT = 0xFFF00
+
+
+class Overlap(Exception):
+    pass
+
+
+def parity(v):
+    return bin(v & 0xFF).count("1") % 2 == 0
+
+
+class M:
+    def __init__(self, rnd):
+        self.r = rnd
+        self.regs = {}
+        for n in R16:
+            self.regs[n] = rnd.randrange(0x10000)
+        for n in SEG:
+            self.regs[n] = rnd.randrange(0x0000, 0xF000)
+        self.regs["ip"] = rnd.randrange(0, 0xFF00)
+        self.regs["sp"] = rnd.randrange(0x100, 0xFF00) & ~1
+        self.regs["flags"] = (rnd.randrange(0x10000) & (DEFINED & ~TF)) | 0xF002
+        self.ram = {}
+        self.used = set()
+
+    # registers
+    def r8(self, i):
+        v = self.regs[R16[i & 3]]
+        return (v >> 8) & 0xFF if i & 4 else v & 0xFF
+
+    def w8(self, i, val):
+        n = R16[i & 3]
+        if i & 4:
+            self.regs[n] = (self.regs[n] & 0xFF) | (val & 0xFF) << 8
+        else:
+            self.regs[n] = (self.regs[n] & 0xFF00) | (val & 0xFF)
+
+    def r16(self, i):
+        return self.regs[R16[i]]
+
+    def w16(self, i, val):
+        self.regs[R16[i]] = val & 0xFFFF
+
+    def flag(self, f):
+        return bool(self.regs["flags"] & f)
+
+    def setf(self, f, v):
+        if v:
+            self.regs["flags"] |= f
+        else:
+            self.regs["flags"] &= ~f
+
+    # memory
+    def phys(self, seg, off, size):
+        if off + size > 0x10000:
+            raise Overlap()
+        a = (self.regs[seg] << 4) + off
+        if a + size > LIMIT:
+            raise Overlap()
+        return a
+
+    def touch(self, a, size):
+        # Memory operand, random initial contents
+        for i in range(size):
+            if a + i not in self.ram:
+                if a + i in self.used:
+                    raise Overlap()
+                self.ram[a + i] = self.r.randrange(256)
+                self.used.add(a + i)
+
+    def rd(self, seg, off, size):
+        a = self.phys(seg, off, size)
+        self.touch(a, size)
+        v = self.ram[a]
+        if size == 2:
+            v |= self.ram[a + 1] << 8
+        return v
+
+    def wr(self, seg, off, size, val):
+        a = self.phys(seg, off, size)
+        self.touch(a, size)
+        self.ram[a] = val & 0xFF
+        if size == 2:
+            self.ram[a + 1] = (val >> 8) & 0xFF
+
+    def push(self, val):
+        self.regs["sp"] = (self.regs["sp"] - 2) & 0xFFFF
+        self.wr("ss", self.regs["sp"], 2, val)
+
+    def pop(self):
+        v = self.rd("ss", self.regs["sp"], 2)
+        self.regs["sp"] = (self.regs["sp"] + 2) & 0xFFFF
+        return v
+
+
+def gen_modrm(rnd, reg=None, allow_reg=True, allow_mem=True):
+    while True:
+        mod = rnd.randrange(4)
+        if mod == 3 and not allow_reg:
+            continue
+        if mod != 3 and not allow_mem:
+            continue
+        break
+    rm = rnd.randrange(8)
+    if reg is None:
+        reg = rnd.randrange(8)
+    b = [(mod << 6) | (reg << 3) | rm]
+    if mod == 1:
+        b.append(rnd.randrange(256))
+    elif mod == 2 or (mod == 0 and rm == 6):
+        b += [rnd.randrange(256), rnd.randrange(256)]
+    return b
+
+
+class Operand:
+    def __init__(self, m, modrm, prefix_seg=None):
+        mod = modrm[0] >> 6
+        rm = modrm[0] & 7
+        self.m = m
+        self.reg = (modrm[0] >> 3) & 7
+        if mod == 3:
+            self.is_reg = True
+            self.rm = rm
+            return
+        self.is_reg = False
+        r = m.regs
+        base = {0: r["bx"] + r["si"], 1: r["bx"] + r["di"], 2: r["bp"] + r["si"],
+                3: r["bp"] + r["di"], 4: r["si"], 5: r["di"], 6: r["bp"], 7: r["bx"]}[rm]
+        seg = "ss" if rm in (2, 3, 6) else "ds"
+        if mod == 0 and rm == 6:
+            base = modrm[1] | modrm[2] << 8
+            seg = "ds"
+        elif mod == 1:
+            d = modrm[1]
+            base += d - 256 if d & 0x80 else d
+        elif mod == 2:
+            base += modrm[1] | modrm[2] << 8
+        self.ea = base & 0xFFFF
+        self.seg = prefix_seg or seg
+
+    def get(self, size):
+        if self.is_reg:
+            return self.m.r8(self.rm) if size == 1 else self.m.r16(self.rm)
+        return self.m.rd(self.seg, self.ea, size)
+
+    def set(self, size, v):
+        if self.is_reg:
+            if size == 1:
+                self.m.w8(self.rm, v)
+            else:
+                self.m.w16(self.rm, v)
+        else:
+            self.m.wr(self.seg, self.ea, size, v)
+
+
+def szp(m, res, size):
+    mask = 0xFF if size == 1 else 0xFFFF
+    sign = 0x80 if size == 1 else 0x8000
+    res &= mask
+    m.setf(ZF, res == 0)
+    m.setf(SF, res & sign)
+    m.setf(PF, parity(res))
+    return res
+
+
+def alu(m, op, a, b, size):
+    mask = 0xFF if size == 1 else 0xFFFF
+    sign = 0x80 if size == 1 else 0x8000
+    cf = 1 if m.flag(CF) else 0
+    if op in ("add", "adc"):
+        c = cf if op == "adc" else 0
+        res = a + b + c
+        m.setf(CF, res > mask)
+        m.setf(OF, (a ^ res) & (b ^ res) & sign)
+        m.setf(AF, (a ^ b ^ res) & 0x10)
+    elif op in ("sub", "sbb", "cmp"):
+        c = cf if op == "sbb" else 0
+        res = a - b - c
+        m.setf(CF, res < 0)
+        m.setf(OF, (a ^ b) & (a ^ res) & sign)
+        m.setf(AF, (a ^ b ^ res) & 0x10)
+    elif op in ("and", "or", "xor", "test"):
+        res = {"and": a & b, "test": a & b, "or": a | b, "xor": a ^ b}[op]
+        m.setf(CF, 0)
+        m.setf(OF, 0)
+    res = szp(m, res, size)
+    return None if op in ("cmp", "test") else res
+
+
+ALU = ["add", "or", "adc", "sbb", "and", "sub", "xor", "cmp"]
+LOGIC_MASK = DEFINED & ~AF
+
+# Each generator executes one instruction on m and returns the bytes after the
+# opcode. Overlap means the random state was unusable and gets retried.
+
+
+def g_alu(op, form):
+    def f(m, rnd):
+        size = 1 if form in (0, 2, 4) else 2
+        if form in (4, 5):
+            imm = [rnd.randrange(256) for _ in range(size)]
+            a = m.r8(0) if size == 1 else m.r16(0)
+            b = imm[0] | (imm[1] << 8 if size == 2 else 0)
+            res = alu(m, op, a, b, size)
+            if res is not None:
+                (m.w8(0, res) if size == 1 else m.w16(0, res))
+            return imm
+        modrm = gen_modrm(rnd)
+        o = Operand(m, modrm)
+        regv = m.r8(o.reg) if size == 1 else m.r16(o.reg)
+        rmv = o.get(size)
+        if form in (0, 1):
+            res = alu(m, op, rmv, regv, size)
+            if res is not None:
+                o.set(size, res)
+        else:
+            res = alu(m, op, regv, rmv, size)
+            if res is not None:
+                (m.w8(o.reg, res) if size == 1 else m.w16(o.reg, res))
+        return modrm
+    return f
+
+
+def g_grp1(opcode, reg):
+    def f(m, rnd):
+        size = 1 if opcode == 0x80 else 2
+        modrm = gen_modrm(rnd, reg)
+        o = Operand(m, modrm)
+        if opcode == 0x81:
+            imm = [rnd.randrange(256), rnd.randrange(256)]
+            b = imm[0] | imm[1] << 8
+        else:
+            imm = [rnd.randrange(256)]
+            b = imm[0]
+            if opcode == 0x83 and b & 0x80:
+                b |= 0xFF00
+        res = alu(m, ALU[reg], o.get(size), b, size)
+        if res is not None:
+            o.set(size, res)
+        return modrm + imm
+    return f
+
+
+def g_incdec16(opcode):
+    def f(m, rnd):
+        i = opcode & 7
+        a = m.r16(i)
+        dec = opcode >= 0x48
+        res = (a - 1 if dec else a + 1) & 0xFFFF
+        m.setf(OF, res == (0x7FFF if dec else 0x8000))
+        m.setf(AF, (a ^ 1 ^ res) & 0x10)
+        szp(m, res, 2)
+        m.w16(i, res)
+        return []
+    return f
+
+
+def g_incdec_rm(opcode, reg):
+    def f(m, rnd):
+        size = 1 if opcode == 0xFE else 2
+        sign = 0x80 if size == 1 else 0x8000
+        mask = 0xFF if size == 1 else 0xFFFF
+        modrm = gen_modrm(rnd, reg)
+        o = Operand(m, modrm)
+        a = o.get(size)
+        res = (a - 1 if reg else a + 1) & mask
+        m.setf(OF, res == ((sign - 1) if reg else sign))
+        m.setf(AF, (a ^ 1 ^ res) & 0x10)
+        szp(m, res, size)
+        o.set(size, res)
+        return modrm
+    return f
+
+
+def g_mov(opcode):
+    def f(m, rnd):
+        size = 1 if opcode in (0x88, 0x8A) else 2
+        modrm = gen_modrm(rnd)
+        o = Operand(m, modrm)
+        if opcode in (0x88, 0x89):
+            o.set(size, m.r8(o.reg) if size == 1 else m.r16(o.reg))
+        else:
+            v = o.get(size)
+            (m.w8(o.reg, v) if size == 1 else m.w16(o.reg, v))
+        return modrm
+    return f
+
+
+def g_movimm(opcode):
+    def f(m, rnd):
+        if opcode < 0xB8:
+            imm = [rnd.randrange(256)]
+            m.w8(opcode & 7, imm[0])
+        else:
+            imm = [rnd.randrange(256), rnd.randrange(256)]
+            m.w16(opcode & 7, imm[0] | imm[1] << 8)
+        return imm
+    return f
+
+
+def g_movrm_imm(opcode):
+    def f(m, rnd):
+        size = 1 if opcode == 0xC6 else 2
+        modrm = gen_modrm(rnd, 0)
+        o = Operand(m, modrm)
+        imm = [rnd.randrange(256) for _ in range(size)]
+        o.set(size, imm[0] | (imm[1] << 8 if size == 2 else 0))
+        return modrm + imm
+    return f
+
+
+def g_test(opcode):
+    def f(m, rnd):
+        size = 1 if opcode in (0x84, 0xA8) else 2
+        if opcode in (0xA8, 0xA9):
+            imm = [rnd.randrange(256) for _ in range(size)]
+            a = m.r8(0) if size == 1 else m.r16(0)
+            alu(m, "test", a, imm[0] | (imm[1] << 8 if size == 2 else 0), size)
+            return imm
+        modrm = gen_modrm(rnd)
+        o = Operand(m, modrm)
+        alu(m, "test", o.get(size), m.r8(o.reg) if size == 1 else m.r16(o.reg), size)
+        return modrm
+    return f
+
+
+def g_push(opcode):
+    def f(m, rnd):
+        m.push(m.r16(opcode & 7))
+        return []
+    return f
+
+
+def g_pop(opcode):
+    def f(m, rnd):
+        m.w16(opcode & 7, m.pop())
+        return []
+    return f
+
+
+def g_xchg(opcode):
+    def f(m, rnd):
+        i = opcode & 7
+        a, b = m.r16(0), m.r16(i)
+        m.w16(0, b)
+        m.w16(i, a)
+        return []
+    return f
+
+
+def g_lea(m, rnd):
+    modrm = gen_modrm(rnd, allow_reg=False)
+    o = Operand(m, modrm)
+    m.w16(o.reg, o.ea)
+    return modrm
+
+
+def g_string(opcode):
+    def f(m, rnd):
+        size = 1 if opcode & 1 == 0 else 2
+        step = -size if m.flag(DF) else size
+        r = m.regs
+        if opcode in (0xA4, 0xA5):
+            v = m.rd("ds", r["si"], size)
+            m.wr("es", r["di"], size, v)
+            r["si"] = (r["si"] + step) & 0xFFFF
+            r["di"] = (r["di"] + step) & 0xFFFF
+        elif opcode in (0xAA, 0xAB):
+            m.wr("es", r["di"], size, m.r8(0) if size == 1 else m.r16(0))
+            r["di"] = (r["di"] + step) & 0xFFFF
+        elif opcode in (0xAC, 0xAD):
+            v = m.rd("ds", r["si"], size)
+            (m.w8(0, v) if size == 1 else m.w16(0, v))
+            r["si"] = (r["si"] + step) & 0xFFFF
+        elif opcode in (0xA6, 0xA7):
+            a = m.rd("ds", r["si"], size)
+            b = m.rd("es", r["di"], size)
+            alu(m, "cmp", a, b, size)
+            r["si"] = (r["si"] + step) & 0xFFFF
+            r["di"] = (r["di"] + step) & 0xFFFF
+        return []
+    return f
+
+
+def cond(m, c):
+    f = m.flag
+    t = [f(OF), f(CF), f(ZF), f(CF) or f(ZF), f(SF), f(PF), f(SF) != f(OF),
+         f(ZF) or f(SF) != f(OF)][c >> 1]
+    return t != bool(c & 1)
+
+
+def g_jcc(opcode):
+    def f(m, rnd):
+        rel = rnd.randrange(256)
+        if cond(m, opcode & 0xF):
+            m.jump = rel - 256 if rel & 0x80 else rel
+        return [rel]
+    return f
+
+
+def g_jmp_short(m, rnd):
+    rel = rnd.randrange(256)
+    m.jump = rel - 256 if rel & 0x80 else rel
+    return [rel]
+
+
+def g_loop(m, rnd):
+    rel = rnd.randrange(256)
+    if rnd.randrange(4) == 0:
+        m.regs["cx"] = 1
+    m.regs["cx"] = (m.regs["cx"] - 1) & 0xFFFF
+    if m.regs["cx"] != 0:
+        m.jump = rel - 256 if rel & 0x80 else rel
+    return [rel]
+
+
+def g_call(m, rnd):
+    rel = [rnd.randrange(256), rnd.randrange(256)]
+    m.push((m.regs["ip"] + 3) & 0xFFFF)
+    m.jump = rel[0] | rel[1] << 8
+    return rel
+
+
+def g_ret(m, rnd):
+    m.ip_override = m.pop()
+    return []
+
+
+def g_shift(opcode, reg):
+    def f(m, rnd):
+        size = 1 if opcode == 0xD0 else 2
+        sign = 0x80 if size == 1 else 0x8000
+        mask = 0xFF if size == 1 else 0xFFFF
+        modrm = gen_modrm(rnd, reg)
+        o = Operand(m, modrm)
+        a = o.get(size)
+        if reg == 4:
+            res = (a << 1) & mask
+            m.setf(CF, a & sign)
+            m.setf(OF, bool(res & sign) != bool(a & sign))
+        else:
+            res = a >> 1
+            m.setf(CF, a & 1)
+            m.setf(OF, a & sign)
+        szp(m, res, size)
+        o.set(size, res)
+        return modrm
+    return f
+
+
+def g_cbw(m, rnd):
+    al = m.r8(0)
+    m.w16(0, al | (0xFF00 if al & 0x80 else 0))
+    return []
+
+
+def g_flagop(opcode):
+    def f(m, rnd):
+        if opcode == 0xF5:
+            m.setf(CF, not m.flag(CF))
+        else:
+            flag = {0xF8: CF, 0xF9: CF, 0xFA: IF, 0xFB: IF, 0xFC: DF, 0xFD: DF}[opcode]
+            m.setf(flag, opcode & 1)
+        return []
+    return f
+
+
+TESTS = {}
+for i, op in enumerate(ALU):
+    for form in range(6):
+        TESTS["%02X" % (i * 8 + form)] = (op, g_alu(op, form), DEFINED if op not in ("and", "or", "xor") else LOGIC_MASK)
+for opcode in (0x80, 0x81, 0x83):
+    for reg in range(8):
+        TESTS["%02X.%d" % (opcode, reg)] = (ALU[reg], g_grp1(opcode, reg), LOGIC_MASK if ALU[reg] in ("and", "or", "xor") else DEFINED)
+for opcode in range(0x40, 0x50):
+    TESTS["%02X" % opcode] = ("inc" if opcode < 0x48 else "dec", g_incdec16(opcode), DEFINED)
+for opcode in range(0x50, 0x58):
+    if opcode != 0x54:
+        TESTS["%02X" % opcode] = ("push", g_push(opcode), DEFINED)
+for opcode in range(0x58, 0x60):
+    if opcode != 0x5C:
+        TESTS["%02X" % opcode] = ("pop", g_pop(opcode), DEFINED)
+for opcode in range(0x70, 0x80):
+    TESTS["%02X" % opcode] = ("jcc", g_jcc(opcode), DEFINED)
+for opcode in (0x84, 0x85, 0xA8, 0xA9):
+    TESTS["%02X" % opcode] = ("test", g_test(opcode), LOGIC_MASK)
+for opcode in (0x88, 0x89, 0x8A, 0x8B):
+    TESTS["%02X" % opcode] = ("mov", g_mov(opcode), DEFINED)
+TESTS["8D"] = ("lea", g_lea, DEFINED)
+for opcode in range(0x91, 0x98):
+    TESTS["%02X" % opcode] = ("xchg", g_xchg(opcode), DEFINED)
+TESTS["98"] = ("cbw", g_cbw, DEFINED)
+for opcode in (0xA4, 0xA5, 0xA6, 0xA7, 0xAA, 0xAB, 0xAC, 0xAD):
+    TESTS["%02X" % opcode] = ({0xA4: "movsb", 0xA5: "movsw", 0xA6: "cmpsb", 0xA7: "cmpsw", 0xAA: "stosb", 0xAB: "stosw", 0xAC: "lodsb", 0xAD: "lodsw"}[opcode], g_string(opcode), DEFINED)
+for opcode in range(0xB0, 0xC0):
+    TESTS["%02X" % opcode] = ("mov", g_movimm(opcode), DEFINED)
+TESTS["C3"] = ("ret", g_ret, DEFINED)
+TESTS["C6"] = ("mov", g_movrm_imm(0xC6), DEFINED)
+TESTS["C7"] = ("mov", g_movrm_imm(0xC7), DEFINED)
+for opcode in (0xD0, 0xD1):
+    for reg in (4, 5):
+        TESTS["%02X.%d" % (opcode, reg)] = ("shl" if reg == 4 else "shr", g_shift(opcode, reg), DEFINED & ~AF)
+TESTS["E2"] = ("loop", g_loop, DEFINED)
+TESTS["E8"] = ("call", g_call, DEFINED)
+TESTS["EB"] = ("jmp", g_jmp_short, DEFINED)
+for opcode in (0xF5, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD):
+    TESTS["%02X" % opcode] = ({0xF5: "cmc", 0xF8: "clc", 0xF9: "stc", 0xFA: "cli", 0xFB: "sti", 0xFC: "cld", 0xFD: "std"}[opcode], g_flagop(opcode), DEFINED)
+for opcode in (0xFE, 0xFF):
+    for reg in (0, 1):
+        TESTS["%02X.%d" % (opcode, reg)] = ("inc" if reg == 0 else "dec", g_incdec_rm(opcode, reg), DEFINED)
+
+
+def vector(key, name, gen, rnd):
+    opcode = int(key.split(".")[0], 16)
+    while True:
+        m = M(rnd)
+        init_regs = dict(m.regs)
+        m.jump = None
+        m.ip_override = None
+        # Remember the initial contents of every byte that gets accessed
+        created = {}
+
+        def touch(a, size, m=m):
+            for i in range(size):
+                if a + i not in m.ram:
+                    if a + i in m.used:
+                        raise Overlap()
+                    v = m.r.randrange(256)
+                    m.ram[a + i] = v
+                    created[a + i] = v
+                    m.used.add(a + i)
+        m.touch = touch
+        try:
+            rest = gen(m, rnd)
+        except Overlap:
+            continue
+        code = [opcode] + rest
+        if init_regs["ip"] + len(code) > 0x10000:
+            continue
+        start = (init_regs["cs"] << 4) + init_regs["ip"]
+        if start + len(code) > LIMIT or any(start + i in created for i in range(len(code))):
+            continue
+        break
+
+    length = len(code)
+    ip = (init_regs["ip"] + length) & 0xFFFF
+    if m.jump is not None:
+        ip = (ip + m.jump) & 0xFFFF
+    if m.ip_override is not None:
+        ip = m.ip_override
+    m.regs["ip"] = ip
+
+    init_ram = sorted([[start + i, b] for i, b in enumerate(code)] + [[a, v] for a, v in created.items()])
+    final_ram = sorted([[start + i, b] for i, b in enumerate(code)] + [[a, m.ram[a]] for a in created])
+    final_regs = {k: v for k, v in m.regs.items() if init_regs[k] != v}
+    t = {
+        "name": name,
+        "bytes": code,
+        "initial": {"regs": init_regs, "ram": init_ram, "queue": []},
+        "final": {"regs": final_regs, "ram": final_ram, "queue": []},
+    }
+    t["hash"] = hashlib.sha1(json.dumps(t, sort_keys=True).encode()).hexdigest()
+    return t
+
+
+def main(out, count):
+    os.makedirs(os.path.join(out, "v1"), exist_ok=True)
+    meta = {"opcodes": {}}
+    for key, (name, gen, mask) in sorted(TESTS.items()):
+        rnd = random.Random(key)
+        tests = [vector(key, name, gen, rnd) for _ in range(count)]
+        for i, t in enumerate(tests):
+            t["idx"] = i
+        with open(os.path.join(out, "v1", key + ".json"), "w") as f:
+            f.write("[\n" + ",\n".join(json.dumps(t, separators=(",", ":")) for t in tests) + "\n]\n")
+        op, _, reg = key.partition(".")
+        entry = meta["opcodes"].setdefault(op, {"status": "normal"})
+        if reg:
+            entry.setdefault("reg", {})[reg] = {"status": "normal"}
+            if mask != DEFINED:
+                entry["reg"][reg]["flags-mask"] = mask
+        elif mask != DEFINED:
+            entry["flags-mask"] = mask
+    with open(os.path.join(out, "metadata.json"), "w") as f:
+        json.dump(meta, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+
+main(sys.argv[1], int(sys.argv[2]))
@@ -0,0 +1,301 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Common/Logger.h"
+#include "Common/ParameterParser.h"
+#include "Common/String.h"
+#include "Common/Types.h"
+#include "Version.h"
+
+#include "Core/CPU/Instruction.h"
+#include "Core/Debug/StateHash.h"
+
+using namespace Core::CPU;
+using namespace Core::Debug;
+
+// Differing bytes listed in a report
+constexpr size_t MAX_REPORTED_BYTES = 32;
+
+// Bytes kept to disassemble the divergent instruction (as in trace records)
+constexpr u32 INSTRUCTION_BYTES = 7;
+
+static const char* REGISTER_NAMES[] = {"AX", "BX", "CX", "DX", "SI",
+                                       "DI", "BP", "SP", "CS", "DS",
+                                       "ES", "SS", "IP", "FLAGS"};
+
+namespace
+{
+//! A state hash file being read
+struct Run {
+  std::string path;
+  std::ifstream ifs;
+  StateHash::Entry entry;
+  //! RAM as of entry
+  std::vector<u8> ram;
+};
+} // namespace
+
+static bool Open(Run& run, u64& interval)
+{
+  run.ifs.open(run.path, std::ios::binary);
+
+  StateHash::Header header;
+  run.ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  if (!run.ifs.good() ||
+      !std::equal(std::begin(StateHash::MAGIC), std::end(StateHash::MAGIC),
+                  header.magic)) {
+    ERROR(run.path + " is not a state hash file");
+    return false;
+  }
+
+  if (header.version != StateHash::VERSION) {
+    ERROR("Unsupported state hash version " + std::to_string(header.version));
+    return false;
+  }
+
+  run.ram.assign(header.ram_size, 0);
+  interval = header.interval;
+
+  return true;
+}
+
+//! Read the next entry and apply its changes to RAM. Returns false at the end
+//! of the file
+static bool Next(Run& run)
+{
+  if (!run.ifs.read(reinterpret_cast<char*>(&run.entry), sizeof(run.entry)))
+    return false;
+
+  for (u32 i = 0; i < run.entry.spans; i++) {
+    StateHash::Span span;
+    run.ifs.read(reinterpret_cast<char*>(&span), sizeof(span));
+
+    if (!run.ifs.good() || span.address + span.length > run.ram.size()) {
+      WARN(run.path + " is truncated");
+      return false;
+    }
+
+    run.ifs.read(reinterpret_cast<char*>(run.ram.data() + span.address),
+                 span.length);
+  }
+
+  return run.ifs.good();
+}
+
+static std::string Disassemble(const u8* bytes, size_t size, u16 ip)
+{
+  const u8* end = bytes + size;
+  Instruction ins;
+
+  try {
+    ins = Instruction(*bytes++, ip);
+
+    if (ins.IsPrefix() && bytes < end)
+      ins = Instruction(ins, *bytes++, ip);
+
+    if (!ins.IsResolved() && bytes < end) {
+      u8 mod = *bytes++;
+      u8 length = ins.GetLength(mod);
+
+      std::vector<u8> data(bytes, std::min(bytes + length, end));
+      data.resize(length);
+
+      if (!ins.Resolve(mod, data))
+        return "(undecodable)";
+    }
+  } catch (...) {
+    return "(undecodable)";
+  }
+
+  if (ins.GetType() == Instruction::Type::Invalid)
+    return "(undecodable)";
+
+  return ins.ToString();
+}
+
+static void PrintRegisters(const Run& run, const Run& other)
+{
+  std::cout << run.path << ":" << std::endl << " ";
+
+  for (u8 i = 0; i < StateHash::Register::COUNT; i++) {
+    const bool differs = run.entry.registers[i] != other.entry.registers[i];
+
+    std::cout << " " << (differs ? "*" : "") << REGISTER_NAMES[i] << "="
+              << String::ToHex(run.entry.registers[i]);
+
+    if (i == StateHash::Register::SP)
+      std::cout << std::endl << " ";
+  }
+
+  if (run.entry.repeat_mode != other.entry.repeat_mode)
+    std::cout << " *REP=" << run.entry.repeat_mode;
+
+  std::cout << std::endl;
+}
+
+static void PrintMemory(const Run& a, const Run& b)
+{
+  const size_t size = std::min(a.ram.size(), b.ram.size());
+  size_t reported = 0;
+
+  for (size_t i = 0; i < size; i++) {
+    if (a.ram[i] == b.ram[i] || reported++ >= MAX_REPORTED_BYTES)
+      continue;
+
+    std::cout << "  [" << String::ToHex(static_cast<u32>(i)) << "] "
+              << String::ToHex(a.ram[i]) << " vs " << String::ToHex(b.ram[i])
+              << std::endl;
+  }
+
+  if (reported == 0)
+    std::cout << "  RAM is identical" << std::endl;
+  else if (reported > MAX_REPORTED_BYTES)
+    std::cout << "  (" << reported - MAX_REPORTED_BYTES
+              << " more bytes differ)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::cerr << "Ape " << VERSION_STRING << " State Hash Bisector" << std::endl
+            << "(c) Ape Emulator Project, 2018" << std::endl
+            << std::endl;
+
+  ParameterParser p;
+
+  p.AddString("files");
+  p.AddCommand("help");
+
+  if (!p.Parse(argc, argv)) {
+    std::cerr << "Failed to parse parameters." << std::endl
+              << "See --help for a list of options" << std::endl;
+    return 1;
+  }
+
+  const auto& files = p.GetString("files");
+  const auto comma = files.find(',');
+
+  if (p.CheckCommand("help") || comma == std::string::npos) {
+    std::cerr << "Usage: " << argv[0] << " --files (a),(b)" << std::endl
+              << "  Find the first state in which two runs recorded with "
+                 "--state-hash differ"
+              << std::endl;
+    return 1;
+  }
+
+  Run a, b;
+  u64 interval_a, interval_b;
+
+  a.path = files.substr(0, comma);
+  b.path = files.substr(comma + 1);
+
+  if (!Open(a, interval_a) || !Open(b, interval_b))
+    return 1;
+
+  if (a.ram.size() != b.ram.size()) {
+    ERROR("The runs have different amounts of RAM");
+    return 1;
+  }
+
+  // The last state both runs agreed on and the bytes of the instruction that
+  // got executed next
+  bool matched = false;
+  StateHash::Entry last{};
+  std::vector<u8> bytes;
+
+  bool has_a = Next(a);
+  bool has_b = Next(b);
+
+  // States are only compared where both runs recorded one
+  while (has_a && has_b) {
+    if (a.entry.instruction < b.entry.instruction) {
+      has_a = Next(a);
+      continue;
+    }
+
+    if (b.entry.instruction < a.entry.instruction) {
+      has_b = Next(b);
+      continue;
+    }
+
+    if (a.entry.hash != b.entry.hash)
+      break;
+
+    matched = true;
+    last = a.entry;
+
+    const u32 address = (last.registers[StateHash::Register::CS] << 4) +
+                        last.registers[StateHash::Register::IP];
+    bytes.clear();
+    for (u32 i = 0; i < INSTRUCTION_BYTES; i++)
+      bytes.push_back(a.ram[(address + i) % a.ram.size()]);
+
+    has_a = Next(a);
+    has_b = Next(b);
+  }
+
+  if (!has_a && !has_b) {
+    if (!matched) {
+      std::cout << "The runs have no state in common" << std::endl;
+      return 1;
+    }
+
+    std::cout << "No divergence, the runs agree up to instruction "
+              << last.instruction << std::endl;
+    return 0;
+  }
+
+  if (!has_a || !has_b) {
+    const Run& ended = has_a ? b : a;
+    const Run& other = has_a ? a : b;
+
+    std::cout << ended.path << " ends after instruction "
+              << ended.entry.instruction << ", " << other.path
+              << " continues (recorded up to "
+              << std::max(last.instruction, other.entry.instruction) << ")"
+              << std::endl;
+    return 1;
+  }
+
+  const u64 instruction = a.entry.instruction;
+
+  if (!matched) {
+    std::cout << "The runs already differ at instruction " << instruction
+              << ", the first state both recorded" << std::endl;
+  } else if (instruction - last.instruction == 1) {
+    const u16 cs = last.registers[StateHash::Register::CS];
+    const u16 ip = last.registers[StateHash::Register::IP];
+
+    std::cout << "First divergent instruction is #" << instruction << " at "
+              << String::ToHex(cs) << ":" << String::ToHex(ip) << "  "
+              << Disassemble(bytes.data(), bytes.size(), ip) << std::endl;
+  } else {
+    std::cout << "The runs diverged between instruction " << last.instruction
+              << " and " << instruction << std::endl
+              << "Record both again with --state-hash-every 1 "
+                 "--state-hash-range "
+              << last.instruction << "," << instruction
+              << " to find the instruction" << std::endl;
+
+    if (interval_a != interval_b)
+      std::cout << "(the runs were recorded at different intervals)"
+                << std::endl;
+  }
+
+  std::cout << std::endl << "State after instruction " << instruction << ":"
+            << std::endl;
+
+  PrintRegisters(a, b);
+  PrintRegisters(b, a);
+  PrintMemory(a, b);
+
+  return 1;
+}
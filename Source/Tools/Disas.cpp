@@ -5,6 +5,7 @@
 #include <cctype>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,7 @@
 #include "Version.h"
 
 #include "Core/CPU/Instruction.h"
+#include "Core/Debug/Coverage.h"
 
 using namespace Core::CPU;
 
@@ -38,6 +40,8 @@ int main(int argc, char** argv)
   ParameterParser p;
 
   p.AddString("file");
+  p.AddString("coverage");
+  p.AddString("base");
   p.AddCommand("help");
 
   if (!p.Parse(argc, argv)) {
@@ -46,7 +50,13 @@ int main(int argc, char** argv)
   }
 
   if (p.CheckCommand("help")) {
-    std::cerr << "Usage: " << argv[0] << " --file (file)" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " --file (file)" << std::endl
+              << "  --coverage [a,b,...]  Mark instructions executed in any "
+                 "of these coverage bitmaps"
+              << std::endl
+              << "  --base [hex]          Physical address the file was "
+                 "loaded at (e.g. 8100 for COM files)"
+              << std::endl;
     return 1;
   }
 
@@ -64,7 +74,23 @@ int main(int argc, char** argv)
     return 1;
   }
 
-  while (!ifs.eof()) {
+  const bool coverage = p.GetString("coverage") != "";
+  const u32 base = p.GetString("base") == ""
+                       ? 0
+                       : std::stoul(p.GetString("base"), nullptr, 16);
+
+  std::stringstream bitmaps(p.GetString("coverage"));
+  std::string bitmap;
+
+  while (std::getline(bitmaps, bitmap, ',')) {
+    if (!Core::Debug::Coverage::Merge(bitmap))
+      return 1;
+  }
+
+  u32 instructions = 0;
+  u32 covered = 0;
+
+  while (ifs.peek() != std::ifstream::traits_type::eof()) {
     u32 address = static_cast<u32>(
         ifs.tellg()); // Address to bark at if anything goes wrong
     u8 opcode = static_cast<u8>(ifs.get());
@@ -74,6 +100,15 @@ int main(int argc, char** argv)
     if (ins.IsPrefix())
       ins = Instruction(ins, static_cast<u8>(ifs.get()), address);
 
+    if (coverage) {
+      const bool executed = Core::Debug::Coverage::IsCovered(base + address);
+
+      std::cout << (executed ? "* " : "  ");
+
+      instructions++;
+      covered += executed;
+    }
+
     std::cout << String::ToHex(address) << " ";
 
     if (ins.GetType() == Instruction::Type::Invalid) {
@@ -121,5 +156,9 @@ int main(int argc, char** argv)
     std::cout << ins.ToString() << std::endl;
   }
 
+  if (coverage)
+    std::cerr << "Covered " << covered << " of " << instructions
+              << " instructions" << std::endl;
+
   return 0;
 }
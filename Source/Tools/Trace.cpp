@@ -0,0 +1,191 @@
+// Copyright 2018 Ape Emulator Project
+// Licensed under GPLv3+
+// Refer to the LICENSE file included.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Common/Logger.h"
+#include "Common/ParameterParser.h"
+#include "Common/String.h"
+#include "Common/Types.h"
+#include "Version.h"
+
+#include "Core/CPU/Instruction.h"
+#include "Core/Debug/Trace.h"
+
+using namespace Core::CPU;
+using namespace Core::Debug;
+
+static const char* REGISTER_NAMES[] = {"AX", "BX", "CX", "DX", "SI", "DI",
+                                       "BP", "SP", "DS", "ES", "SS", "FLAGS"};
+
+static std::string Disassemble(const Trace::Record& record)
+{
+  Instruction ins;
+
+  if (!Trace::Decode(record.bytes, record.bytes + record.length, record.ip,
+                     ins))
+    return "(undecodable)";
+
+  return ins.ToString();
+}
+
+static std::string RegisterDelta(const Trace::Record& before,
+                                 const Trace::Record& after)
+{
+  std::string delta;
+
+  for (u8 i = 0; i < Trace::Register::COUNT; i++) {
+    if (before.registers[i] == after.registers[i])
+      continue;
+
+    delta += std::string(delta.empty() ? "" : " ") + REGISTER_NAMES[i] + "=" +
+             String::ToHex(after.registers[i]);
+  }
+
+  return delta;
+}
+
+int main(int argc, char** argv)
+{
+  std::cerr << "Ape " << VERSION_STRING << " Trace Decoder" << std::endl
+            << "(c) Ape Emulator Project, 2018" << std::endl
+            << std::endl;
+
+  ParameterParser p;
+
+  p.AddString("file");
+  p.AddString("segment");
+  p.AddString("from");
+  p.AddString("to");
+  p.AddString("type");
+  p.AddString("limit");
+  p.AddCommand("help");
+
+  if (!p.Parse(argc, argv)) {
+    std::cerr << "Failed to parse parameters." << std::endl
+              << "See --help for a list of options" << std::endl;
+    return 1;
+  }
+
+  if (p.CheckCommand("help")) {
+    std::cerr << "Usage: " << argv[0] << " --file (file)" << std::endl
+              << "  --segment [hex]   Only show instructions in this segment"
+              << std::endl
+              << "  --from [hex]      Only show offsets >= from" << std::endl
+              << "  --to [hex]        Only show offsets <= to" << std::endl
+              << "  --type [name]     Only show this instruction type (e.g. "
+                 "CALL)"
+              << std::endl
+              << "  --limit [n]       Stop after n matching instructions"
+              << std::endl;
+    return 1;
+  }
+
+  const auto& file = p.GetString("file");
+
+  if (file == "") {
+    std::cerr << "No trace to decode provided. Exiting." << std::endl;
+    return 2;
+  }
+
+  std::ifstream ifs(file, std::ios::binary);
+
+  Trace::Header header;
+
+  ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  if (!ifs.good() ||
+      !std::equal(std::begin(Trace::MAGIC), std::end(Trace::MAGIC),
+                  header.magic)) {
+    ERROR(file + " is not a trace file");
+    return 1;
+  }
+
+  if (header.version != Trace::VERSION ||
+      header.record_size > sizeof(Trace::Record) ||
+      (header.record_size == 0 && !(header.flags & Trace::HAS_BRANCHES))) {
+    ERROR("Unsupported trace version " + std::to_string(header.version));
+    return 1;
+  }
+
+  const bool has_registers = header.flags & Trace::HAS_REGISTERS;
+
+  auto ParseHex = [&p](const std::string& name, u32 fallback) {
+    const auto& value = p.GetString(name);
+    return value == "" ? fallback
+                       : static_cast<u32>(std::stoul(value, nullptr, 16));
+  };
+
+  const u32 segment = ParseHex("segment", 0x10000);
+  const u32 from = ParseHex("from", 0);
+  const u32 to = ParseHex("to", 0xFFFF);
+  const auto& type = p.GetString("type");
+  const u64 limit = p.GetString("limit") == ""
+                        ? UINT64_MAX
+                        : std::stoull(p.GetString("limit"));
+
+  auto Matches = [&](const Trace::Record& record, const std::string& disasm) {
+    if (segment != 0x10000 && record.cs != segment)
+      return false;
+
+    if (record.ip < from || record.ip > to)
+      return false;
+
+    return type == "" || disasm.compare(0, type.size() + 1, type + " ") == 0;
+  };
+
+  u64 shown = 0;
+
+  auto Print = [&](const Trace::Record& record, const std::string& delta) {
+    if (shown >= limit)
+      return;
+
+    const auto& disasm = Disassemble(record);
+
+    if (!Matches(record, disasm))
+      return;
+
+    std::cout << String::ToHex(record.cs) << ":" << String::ToHex(record.ip)
+              << " " << disasm;
+
+    if (!delta.empty())
+      std::cout << " ; " << delta;
+
+    std::cout << std::endl;
+    shown++;
+  };
+
+  if (header.flags & Trace::HAS_BRANCHES) {
+    const auto show = [&](const Trace::Record& record) {
+      Print(record, "");
+      return shown < limit;
+    };
+
+    return Trace::DecodeBranches(ifs, show) ? 0 : 1;
+  }
+
+  // Lines are printed one record late so register changes caused by an
+  // instruction show up next to it
+  Trace::Record previous;
+  bool has_previous = false;
+
+  Trace::Record record;
+
+  while (shown < limit && ifs.read(reinterpret_cast<char*>(&record),
+                                   header.record_size)) {
+    if (has_previous)
+      Print(previous, has_registers ? RegisterDelta(previous, record) : "");
+
+    previous = record;
+    has_previous = true;
+  }
+
+  if (has_previous)
+    Print(previous, "");
+
+  return 0;
+}